@@ -7,8 +7,9 @@
 #include "freertos/task.h"
 
 #include "src/charger/CHARGERS.h"
-#include "src/communication/Transmitter.h"
+#include "src/communication/core_tick.h"
 #include "src/communication/can/comm_can.h"
+#include "src/communication/can/usb_can_stream.h"
 #include "src/communication/nvm/comm_nvm.h"
 #include "src/datalayer/datalayer.h"
 #include "src/devboard/sdcard/sdcard.h"
@@ -35,12 +36,6 @@ TaskHandle_t connectivity_loop_task;
 
 Logging logging;
 
-static std::list<Transmitter*> transmitters;
-void register_transmitter(Transmitter* transmitter) {
-  transmitters.push_back(transmitter);
-  DEBUG_PRINTF("transmitter registered, total: %d\n", transmitters.size());
-}
-
 // Initialization functions
 void init_serial() {
   // Init Serial monitor
@@ -141,31 +136,40 @@ void check_reset_reason() {
 
 void core_loop(void*) {
   esp_task_wdt_add(NULL);  // Register this task with WDT
-  TickType_t xLastWakeTime = xTaskGetTickCount();
+  set_can_rx_consumer(xTaskGetCurrentTaskHandle());
+  TickType_t xNextWakeTime = xTaskGetTickCount();
   const TickType_t xFrequency = pdMS_TO_TICKS(1);  // Convert 1ms to ticks
 
   while (true) {
 
-    // Input, Runs as fast as possible
-    receive_can();  // Receive CAN messages
+    // Input, handled as soon as the CAN RX task has queued frames
+    if (receive_can()) {  // Receive CAN messages
+      // The budget ran out with frames still queued, the notification about them was already taken
+      xTaskNotifyGive(xTaskGetCurrentTaskHandle());
+    }
 
-    ElegantOTA.loop();
+    if ((BaseType_t)(xTaskGetTickCount() - xNextWakeTime) >= 0) {
+      xNextWakeTime += xFrequency;
 
-    // Process
-    currentMillis = millis();
-    if (currentMillis - previousMillis10ms >= INTERVAL_10_MS) {
-      previousMillis10ms = currentMillis;
+      ElegantOTA.loop();
 
-      led_exe();
-    }
+      // Process
+      currentMillis = millis();
+      if (currentMillis - previousMillis10ms >= INTERVAL_10_MS) {
+        previousMillis10ms = currentMillis;
+
+        led_exe();
+      }
 
-    // Let all transmitter objects send their messages
-    for (auto& transmitter : transmitters) {
-      transmitter->transmit(currentMillis);
+      // Retried CAN frames and the cyclic tasks that are due
+      run_core_tick(currentMillis);
+
+      esp_task_wdt_reset();  // Reset watchdog to prevent reset
     }
 
-    esp_task_wdt_reset();  // Reset watchdog to prevent reset
-    vTaskDelayUntil(&xLastWakeTime, xFrequency);
+    // Sleep until the next 1ms tick, or until the CAN RX task notifies us about received frames
+    const BaseType_t ticks_left = (BaseType_t)(xNextWakeTime - xTaskGetTickCount());
+    ulTaskNotifyTake(pdTRUE, ticks_left > 0 ? ticks_left : 0);
   }
 }
 
@@ -175,6 +179,8 @@ void setup() {
 
   init_serial();
 
+  init_deferred_logging();
+
   // We print this after setting up serial, so that is also printed if configured to do so
   DEBUG_PRINTF("LEAF Charger emulator %s build " __DATE__ " " __TIME__ "\n", version_number);
 
@@ -182,6 +188,10 @@ void setup() {
 
   init_stored_settings();
 
+  init_sd_writer();
+
+  init_usb_can_stream();
+
   if (wifi_enabled) {
     xTaskCreatePinnedToCore((TaskFunction_t)&connectivity_loop, "connectivity_loop", 4096, NULL, TASK_CONNECTIVITY_PRIO,
                             &connectivity_loop_task, esp32hal->WIFICORE());
@@ -22,7 +22,7 @@
  */
 
 /* We are mostly sending out not receiving */
-void ChevyVoltCharger::map_can_frame_to_variable(CAN_frame rx_frame) {
+void ChevyVoltCharger::map_can_frame_to_variable(const CAN_frame& rx_frame) {
   uint16_t charger_stat_HVcur_temp = 0;
   uint16_t charger_stat_HVvol_temp = 0;
   uint16_t charger_stat_LVcur_temp = 0;
@@ -46,6 +46,8 @@ void ChevyVoltCharger::map_can_frame_to_variable(CAN_frame rx_frame) {
       charger_stat_LVvol_temp = (uint16_t)(((rx_frame.data.u8[3] << 8 | rx_frame.data.u8[4]) >> 1) & 0x00ff);
       datalayer.charger.charger_stat_LVvol = (float)(charger_stat_LVvol_temp) * .1;
 
+      LOG_TRACE(CHARGER, "0x212 HV %uV %u LV %uV %u (raw)\n", charger_stat_HVvol_temp, charger_stat_HVcur_temp,
+                charger_stat_LVvol_temp, charger_stat_LVcur_temp);
       break;
 
     //ID 0x30A conveys instantaneous AC charger stats
@@ -57,6 +59,7 @@ void ChevyVoltCharger::map_can_frame_to_variable(CAN_frame rx_frame) {
       charger_stat_ACvol_temp = (uint16_t)(((rx_frame.data.u8[1] << 8 | rx_frame.data.u8[2]) >> 4) & 0x00ff);
       datalayer.charger.charger_stat_ACvol = (float)(charger_stat_ACvol_temp) * 2;
 
+      LOG_TRACE(CHARGER, "0x30A AC %uV %u (raw)\n", charger_stat_ACvol_temp, charger_stat_ACcur_temp);
       break;
 
     //ID 0x266, 0x268, and 0x308 are regularly emitted by the charger but content is unknown
@@ -76,81 +79,78 @@ void ChevyVoltCharger::map_can_frame_to_variable(CAN_frame rx_frame) {
   }
 }
 
-void ChevyVoltCharger::transmit_can(unsigned long currentMillis) {
-  uint16_t Vol_temp = 0;
+/* Send keepalive with mode every 30ms */
+void ChevyVoltCharger::transmit_30ms() {
+  charger_mode = MODE_DISABLED;
 
-  uint16_t setpoint_HV_VDC = floor(datalayer.charger.charger_setpoint_HV_VDC);
-  uint16_t setpoint_HV_IDC = floor(datalayer.charger.charger_setpoint_HV_IDC);
-  uint16_t setpoint_HV_IDC_END = floor(datalayer.charger.charger_setpoint_HV_IDC_END);
-  uint8_t charger_mode = MODE_DISABLED;
+  if (datalayer.charger.charger_HV_enabled) {
+    charger_mode += MODE_HV;
 
-  /* Send keepalive with mode every 30ms */
-  if (currentMillis - previousMillis30ms >= INTERVAL_30_MS) {
-    previousMillis30ms = currentMillis;
+    /* disable HV if end amperage reached
+     * TODO - integration opportunity with battery/inverter code
+    if (setpoint_HV_IDC_END > 0 && charger_stat_HVcur > setpoint_HV_IDC_END) {
+      charger_mode -= MODE_HV;
+    }
+    */
+  }
 
-    if (datalayer.charger.charger_HV_enabled) {
-      charger_mode += MODE_HV;
+  if (datalayer.charger.charger_aux12V_enabled)
+    charger_mode += MODE_LV;
 
-      /* disable HV if end amperage reached
-       * TODO - integration opportunity with battery/inverter code
-      if (setpoint_HV_IDC_END > 0 && charger_stat_HVcur > setpoint_HV_IDC_END) {
-        charger_mode -= MODE_HV;
-      }
-      */
-    }
+  charger_keepalive_frame.data.u8[0] = charger_mode;
 
-    if (datalayer.charger.charger_aux12V_enabled)
-      charger_mode += MODE_LV;
+  transmit_can_frame(&charger_keepalive_frame);
+}
 
-    charger_keepalive_frame.data.u8[0] = charger_mode;
+/* Send current targets every 200ms */
+void ChevyVoltCharger::transmit_200ms() {
+  uint16_t Vol_temp = 0;
 
-    transmit_can_frame(&charger_keepalive_frame);
-  }
+  uint16_t setpoint_HV_VDC = floor(datalayer.charger.charger_setpoint_HV_VDC);
+  uint16_t setpoint_HV_IDC = floor(datalayer.charger.charger_setpoint_HV_IDC);
 
-  /* Send current targets every 200ms */
-  if (currentMillis - previousMillis200ms >= INTERVAL_200_MS) {
-    previousMillis200ms = currentMillis;
+  /* These values should be and are validated elsewhere, but adjust if needed
+   * to stay within limits of hardware and user-supplied settings
+   */
+  if (setpoint_HV_VDC > CHARGER_MAX_HV) {
+    setpoint_HV_VDC = CHEVYVOLT_MAX_HVDC;
+  }
 
-    /* These values should be and are validated elsewhere, but adjust if needed
-     * to stay within limits of hardware and user-supplied settings
-     */
-    if (setpoint_HV_VDC > CHARGER_MAX_HV) {
-      setpoint_HV_VDC = CHEVYVOLT_MAX_HVDC;
-    }
+  if (setpoint_HV_VDC < CHARGER_MIN_HV && setpoint_HV_VDC > 0) {
+    setpoint_HV_VDC = CHEVYVOLT_MIN_HVDC;
+  }
 
-    if (setpoint_HV_VDC < CHARGER_MIN_HV && setpoint_HV_VDC > 0) {
-      setpoint_HV_VDC = CHEVYVOLT_MIN_HVDC;
-    }
+  if (setpoint_HV_IDC > CHARGER_MAX_A) {
+    setpoint_HV_VDC = CHEVYVOLT_MAX_AMP;
+  }
 
-    if (setpoint_HV_IDC > CHARGER_MAX_A) {
-      setpoint_HV_VDC = CHEVYVOLT_MAX_AMP;
-    }
+  /* if power overcommitted, back down to just below while maintaining voltage target */
+  if (setpoint_HV_IDC * setpoint_HV_VDC > CHARGER_MAX_POWER) {
+    setpoint_HV_IDC = floor(CHARGER_MAX_POWER / setpoint_HV_VDC);
+  }
 
-    /* if power overcommitted, back down to just below while maintaining voltage target */
-    if (setpoint_HV_IDC * setpoint_HV_VDC > CHARGER_MAX_POWER) {
-      setpoint_HV_IDC = floor(CHARGER_MAX_POWER / setpoint_HV_VDC);
-    }
+  /* current setting */
+  charger_set_targets.data.u8[1] = setpoint_HV_IDC * 20;
+  Vol_temp = setpoint_HV_VDC * 2;
 
-    /* current setting */
-    charger_set_targets.data.u8[1] = setpoint_HV_IDC * 20;
-    Vol_temp = setpoint_HV_VDC * 2;
+  /* first 2 bits are MSB of the voltage command */
+  charger_set_targets.data.u8[2] = highByte(Vol_temp);
 
-    /* first 2 bits are MSB of the voltage command */
-    charger_set_targets.data.u8[2] = highByte(Vol_temp);
+  /* LSB of the voltage command. Then MSB LSB is divided by 2 */
+  charger_set_targets.data.u8[3] = lowByte(Vol_temp);
 
-    /* LSB of the voltage command. Then MSB LSB is divided by 2 */
-    charger_set_targets.data.u8[3] = lowByte(Vol_temp);
+  transmit_can_frame(&charger_set_targets);
+}
 
-    transmit_can_frame(&charger_set_targets);
-  }
+/* Serial echo every 5s of charger stats */
+void ChevyVoltCharger::log_status() {
+  uint16_t setpoint_HV_VDC = floor(datalayer.charger.charger_setpoint_HV_VDC);
+  uint16_t setpoint_HV_IDC = floor(datalayer.charger.charger_setpoint_HV_IDC);
+  uint16_t setpoint_HV_IDC_END = floor(datalayer.charger.charger_setpoint_HV_IDC_END);
 
-  /* Serial echo every 5s of charger stats */
-  if (currentMillis - previousMillis5000ms >= INTERVAL_5_S) {
-    previousMillis5000ms = currentMillis;
-    logging.printf("Charger AC in IAC=%fA VAC=%fV\n", AC_input_current(), AC_input_voltage());
-    logging.printf("Charger HV out IDC=%fA VDC=%fV\n", HVDC_output_current(), HVDC_output_voltage());
-    logging.printf("Charger LV out IDC=%fA VDC=%fV\n", LVDC_output_current(), LVDC_output_voltage());
-    logging.printf("Charger mode=%s\n", (charger_mode > MODE_DISABLED) ? "Enabled" : "Disabled");
-    logging.printf("Charger HVset=%uV,%uA finishCurrent=%uA\n", setpoint_HV_VDC, setpoint_HV_IDC, setpoint_HV_IDC_END);
-  }
+  LOG_INFO(CHARGER, "AC in IAC=%fA VAC=%fV\n", AC_input_current(), AC_input_voltage());
+  LOG_INFO(CHARGER, "HV out IDC=%fA VDC=%fV\n", HVDC_output_current(), HVDC_output_voltage());
+  LOG_INFO(CHARGER, "LV out IDC=%fA VDC=%fV\n", LVDC_output_current(), LVDC_output_voltage());
+  LOG_INFO(CHARGER, "mode=%s\n", (charger_mode > MODE_DISABLED) ? "Enabled" : "Disabled");
+  LOG_INFO(CHARGER, "HVset=%uV,%uA finishCurrent=%uA\n", setpoint_HV_VDC, setpoint_HV_IDC, setpoint_HV_IDC_END);
 }
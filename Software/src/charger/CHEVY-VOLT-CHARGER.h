@@ -9,13 +9,23 @@
 
 class ChevyVoltCharger : public CanCharger {
  public:
-  ChevyVoltCharger() : CanCharger(ChargerType::ChevyVolt) {}
+  ChevyVoltCharger() : CanCharger(ChargerType::ChevyVolt) {
+    register_cyclic_task(INTERVAL_30_MS, [this](unsigned long) { transmit_30ms(); });
+    register_cyclic_task(INTERVAL_200_MS, [this](unsigned long) { transmit_200ms(); });
+    register_cyclic_task(INTERVAL_5_S, [this](unsigned long) { log_status(); });
+    monitor_can_tx_timing(charger_keepalive_frame, can_interface, INTERVAL_30_MS);
+    monitor_can_tx_timing(charger_set_targets, can_interface, INTERVAL_200_MS);
+  }
 
   const char* name() { return Name; }
   static constexpr const char* Name = "Chevy Volt Gen1 Charger";
 
-  void map_can_frame_to_variable(CAN_frame rx_frame);
-  void transmit_can(unsigned long currentMillis);
+  void map_can_frame_to_variable(const CAN_frame& rx_frame);
+
+  std::vector<CAN_id_range> can_ids_of_interest() {
+    return {{0x212, 0x212, false}, {0x266, 0x266, false}, {0x268, 0x268, false},
+            {0x308, 0x308, false}, {0x30A, 0x30A, false}};
+  }
 
   float outputPowerDC() {
     return static_cast<float>(datalayer.charger.charger_stat_HVcur * datalayer.charger.charger_stat_HVvol);
@@ -37,12 +47,13 @@ class ChevyVoltCharger : public CanCharger {
   const float CHEVYVOLT_MAX_AMP = 11.5;
   const float CHEVYVOLT_MAX_POWER = 3300;
 
-  /* CAN cycles and timers */
-  unsigned long previousMillis30ms = 0;    // 30ms cycle for keepalive frames
-  unsigned long previousMillis200ms = 0;   // 200ms cycle for commanding I/V targets
-  unsigned long previousMillis5000ms = 0;  // 5s status printout to serial
+  /* CAN cycles */
+  void transmit_30ms();   // 30ms cycle for keepalive frames
+  void transmit_200ms();  // 200ms cycle for commanding I/V targets
+  void log_status();      // 5s status printout to serial
 
   enum CHARGER_MODES : uint8_t { MODE_DISABLED = 0, MODE_LV, MODE_HV, MODE_HVLV };
+  uint8_t charger_mode = MODE_DISABLED;
 
   //Actual content messages
   CAN_frame charger_keepalive_frame = {.FD = false,
@@ -1,7 +1,7 @@
 #ifndef CAN_CHARGER_H
 #define CAN_CHARGER_H
 
-#include "../communication/Transmitter.h"
+#include "../communication/CyclicScheduler.h"
 #include "../communication/can/CanReceiver.h"
 #include "../communication/can/comm_can.h"
 #include "../datalayer/datalayer.h"
@@ -43,14 +43,12 @@ class Charger {
 };
 
 // Base class for chargers on a CAN bus
-class CanCharger : public Charger, Transmitter, CanReceiver {
+// Cyclic messages are sent from tasks the charger registers with register_cyclic_task()
+class CanCharger : public Charger, CanReceiver {
  public:
-  virtual void map_can_frame_to_variable(CAN_frame rx_frame) = 0;
-  virtual void transmit_can(unsigned long currentMillis) = 0;
+  virtual void map_can_frame_to_variable(const CAN_frame& rx_frame) = 0;
 
-  void transmit(unsigned long currentMillis) { transmit_can(currentMillis); }
-
-  void receive_can_frame(CAN_frame* frame) { map_can_frame_to_variable(*frame); }
+  void receive_can_frame(const CAN_frame& frame) { map_can_frame_to_variable(frame); }
 
   CAN_Interface interface() { return can_interface; }
 
@@ -59,11 +57,12 @@ class CanCharger : public Charger, Transmitter, CanReceiver {
 
   CanCharger(ChargerType type) : Charger(type) {
     can_interface = can_config.charger;
-    register_transmitter(this);
     register_can_receiver(this, can_interface);
   }
 
   void transmit_can_frame(CAN_frame* frame) { transmit_can_frame_to_interface(frame, can_interface); }
+
+  void transmit_can_frames(std::span<const CAN_frame> frames) { ::transmit_can_frames(frames, can_interface); }
 };
 
 #endif
@@ -1,6 +1,7 @@
 #include "NISSAN-LEAF-CHARGER.h"
 #include "../communication/can/comm_can.h"
 #include "../datalayer/datalayer.h"
+#include "../devboard/utils/logging.h"
 #include "CHARGERS.h"
 
 /* This implements Nissan LEAF PDM charger support. 2013-2024 Gen2/3 PDMs are supported
@@ -52,11 +53,12 @@ static uint8_t calculate_checksum_nibble(CAN_frame* frame) {
   return sum;
 }
 
-void NissanLeafCharger::map_can_frame_to_variable(CAN_frame rx_frame) {
+void NissanLeafCharger::map_can_frame_to_variable(const CAN_frame& rx_frame) {
 
   switch (rx_frame.ID) {
     case 0x679:  // This message fires once when charging cable is plugged in
       datalayer.charger.CAN_charger_still_alive = CAN_STILL_ALIVE;  // Let system know charger is sending CAN
+      LOG_INFO(CHARGER, "Charging cable plugged in\n");
       OBCwakeup = true;
       datalayer.charger.charger_aux12V_enabled = true;  //Not possible to turn off 12V charging on LEAF PDM
       // Startout with default values, so that charging can begin right when user plugs in cable
@@ -85,6 +87,8 @@ void NissanLeafCharger::map_can_frame_to_variable(CAN_frame rx_frame) {
 
       OBC_Charge_Power = ((rx_frame.data.u8[0] & 0x01) << 8) | (rx_frame.data.u8[1]);
       datalayer.charger.charger_stat_HVcur = OBC_Charge_Power;
+      LOG_TRACE(CHARGER, "0x390 status %d AC %d power %d\n", OBC_Charge_Status, OBC_Status_AC_Voltage,
+                OBC_Charge_Power);
       break;
     case 0x393:
       datalayer.charger.CAN_charger_still_alive = CAN_STILL_ALIVE;  // Let system know charger is sending CAN
@@ -94,91 +98,80 @@ void NissanLeafCharger::map_can_frame_to_variable(CAN_frame rx_frame) {
   }
 }
 
-void NissanLeafCharger::transmit_can(unsigned long currentMillis) {
+/* Send keepalive with mode every 10ms */
+void NissanLeafCharger::transmit_10ms() {
+  mprun10 = (mprun10 + 1) % 4;  // mprun10 cycles between 0-1-2-3-0-1...
+
+  OBCpowerSetpoint = ((datalayer.charger.charger_setpoint_HV_IDC * 4) + 0x64);
+
+  // convert power setpoint to PDM format:
+  //    0xA0 = 15A (60x)
+  //    0x70 = 3 amps ish (12x)
+  //    0x6a = 1.4A (6x)
+  //    0x66 = 0.5A (2x)
+  //    0x65 = 0.3A (1x)
+  //    0x64 = no chg
+  //    so 0x64=100. 0xA0=160. so 60 decimal steps. 1 step=100W???
+
+  // This line controls if power should flow or not
+  if (PPStatus &&
+      datalayer.charger
+          .charger_HV_enabled) {  //Charging starts when cable plugged in and User has requested charging to start via WebUI
+    // clamp min and max values
+    if (OBCpowerSetpoint > 0xA0) {  //15A TODO, raise once cofirmed how to map bits into frame0 and frame1
+      OBCpowerSetpoint = 0xA0;
+    } else if (OBCpowerSetpoint <= 0x64) {
+      OBCpowerSetpoint = 0x64;  // 100W? stuck at 100 in drive mode (no charging)
+    }
+
+    // if actual battery_voltage is less than setpoint got to max power set from web ui
+    if (datalayer.battery.status.voltage_dV <
+        (CHARGER_SET_HV * 10)) {  //datalayer.battery.status.voltage_dV = V+1,  0-500.0 (0-5000)
+      OBCpower = OBCpowerSetpoint;
+    }
 
-  /* Send keepalive with mode every 10ms */
-  if (currentMillis - previousMillis10ms >= INTERVAL_10_MS) {
-    previousMillis10ms = currentMillis;
+    // decrement charger power if volt setpoint is reached
+    if (datalayer.battery.status.voltage_dV >= (CHARGER_SET_HV * 10)) {
+      if (OBCpower > 0x64) {
+        OBCpower--;
+      }
+    }
+  } else {
+    // set power to 0 if charge control is set to off or not in charge mode
+    OBCpower = 0x64;
+  }
 
-    mprun10 = (mprun10 + 1) % 4;  // mprun10 cycles between 0-1-2-3-0-1...
+  LEAF_1F2.data.u8[1] = OBCpower;
+  LEAF_1F2.data.u8[6] = mprun10;
+  LEAF_1F2.data.u8[7] = calculate_checksum_nibble(&LEAF_1F2);
 
 /* 1DB is the main control message. If LEAF battery is used, the battery controls almost everything */
 // Only send these messages if Nissan LEAF battery is not used
 #ifndef NISSAN_LEAF_BATTERY
-
-    // VCM message, containing info if battery should sleep or stay awake
-    transmit_can_frame(&LEAF_50B);  // HCM_WakeUpSleepCommand == 11b == WakeUp, and CANMASK = 1
-
-    LEAF_1DB.data.u8[7] = calculate_CRC_Nissan(&LEAF_1DB);
-    transmit_can_frame(&LEAF_1DB);
-
-    LEAF_1DC.data.u8[7] = calculate_CRC_Nissan(&LEAF_1DC);
-    transmit_can_frame(&LEAF_1DC);
+  LEAF_1DB.data.u8[7] = calculate_CRC_Nissan(&LEAF_1DB);
+  LEAF_1DC.data.u8[7] = calculate_CRC_Nissan(&LEAF_1DC);
+
+  // 50B is the VCM message, containing info if battery should sleep or stay awake
+  // HCM_WakeUpSleepCommand == 11b == WakeUp, and CANMASK = 1
+  const CAN_frame frames[] = {LEAF_50B, LEAF_1DB, LEAF_1DC, LEAF_1F2};
+  transmit_can_frames(frames);
+#else
+  transmit_can_frame(&LEAF_1F2);  // Sending of 1F2 message is halted in LEAF-BATTERY function incase used here
 #endif
+}
 
-    OBCpowerSetpoint = ((datalayer.charger.charger_setpoint_HV_IDC * 4) + 0x64);
-
-    // convert power setpoint to PDM format:
-    //    0xA0 = 15A (60x)
-    //    0x70 = 3 amps ish (12x)
-    //    0x6a = 1.4A (6x)
-    //    0x66 = 0.5A (2x)
-    //    0x65 = 0.3A (1x)
-    //    0x64 = no chg
-    //    so 0x64=100. 0xA0=160. so 60 decimal steps. 1 step=100W???
-
-    // This line controls if power should flow or not
-    if (PPStatus &&
-        datalayer.charger
-            .charger_HV_enabled) {  //Charging starts when cable plugged in and User has requested charging to start via WebUI
-      // clamp min and max values
-      if (OBCpowerSetpoint > 0xA0) {  //15A TODO, raise once cofirmed how to map bits into frame0 and frame1
-        OBCpowerSetpoint = 0xA0;
-      } else if (OBCpowerSetpoint <= 0x64) {
-        OBCpowerSetpoint = 0x64;  // 100W? stuck at 100 in drive mode (no charging)
-      }
-
-      // if actual battery_voltage is less than setpoint got to max power set from web ui
-      if (datalayer.battery.status.voltage_dV <
-          (CHARGER_SET_HV * 10)) {  //datalayer.battery.status.voltage_dV = V+1,  0-500.0 (0-5000)
-        OBCpower = OBCpowerSetpoint;
-      }
-
-      // decrement charger power if volt setpoint is reached
-      if (datalayer.battery.status.voltage_dV >= (CHARGER_SET_HV * 10)) {
-        if (OBCpower > 0x64) {
-          OBCpower--;
-        }
-      }
-    } else {
-      // set power to 0 if charge control is set to off or not in charge mode
-      OBCpower = 0x64;
-    }
-
-    LEAF_1F2.data.u8[1] = OBCpower;
-    LEAF_1F2.data.u8[6] = mprun10;
-    LEAF_1F2.data.u8[7] = calculate_checksum_nibble(&LEAF_1F2);
-
-    transmit_can_frame(&LEAF_1F2);  // Sending of 1F2 message is halted in LEAF-BATTERY function incase used here
-  }
-
-  /* Send messages every 100ms here */
-  if (currentMillis - previousMillis100ms >= INTERVAL_100_MS) {
-    previousMillis100ms = currentMillis;
-
-    mprun100 = (mprun100 + 1) % 4;  // mprun100 cycles between 0-1-2-3-0-1...
+/* Send messages every 100ms here */
+void NissanLeafCharger::transmit_100ms() {
+  mprun100 = (mprun100 + 1) % 4;  // mprun100 cycles between 0-1-2-3-0-1...
 
 // Only send these messages if Nissan LEAF battery is not used
 #ifndef NISSAN_LEAF_BATTERY
 
-    LEAF_55B.data.u8[6] = ((0x1 << 4) | (mprun100));
+  LEAF_55B.data.u8[6] = ((0x1 << 4) | (mprun100));
 
-    LEAF_55B.data.u8[7] = calculate_CRC_Nissan(&LEAF_55B);
-    transmit_can_frame(&LEAF_55B);
+  LEAF_55B.data.u8[7] = calculate_CRC_Nissan(&LEAF_55B);
 
-    transmit_can_frame(&LEAF_59E);
-
-    transmit_can_frame(&LEAF_5BC);
+  const CAN_frame frames[] = {LEAF_55B, LEAF_59E, LEAF_5BC};
+  transmit_can_frames(frames);
 #endif
-  }
 }
@@ -8,13 +8,24 @@
 
 class NissanLeafCharger : public CanCharger {
  public:
-  NissanLeafCharger() : CanCharger(ChargerType::NissanLeaf) {}
+  NissanLeafCharger() : CanCharger(ChargerType::NissanLeaf) {
+    register_cyclic_task(INTERVAL_10_MS, [this](unsigned long) { transmit_10ms(); });
+    register_cyclic_task(INTERVAL_100_MS, [this](unsigned long) { transmit_100ms(); });
+    // The PDM is sensitive to the timing of these
+    monitor_can_tx_timing(LEAF_1F2, can_interface, INTERVAL_10_MS);
+#ifndef NISSAN_LEAF_BATTERY
+    monitor_can_tx_timing(LEAF_1DB, can_interface, INTERVAL_10_MS);
+#endif
+  }
 
   const char* name() { return Name; }
   static constexpr const char* Name = "Nissan LEAF 2013-2024 PDM charger";
 
-  void map_can_frame_to_variable(CAN_frame rx_frame);
-  void transmit_can(unsigned long currentMillis);
+  void map_can_frame_to_variable(const CAN_frame& rx_frame);
+
+  std::vector<CAN_id_range> can_ids_of_interest() {
+    return {{0x390, 0x390, false}, {0x393, 0x393, false}, {0x679, 0x679, false}};
+  }
 
   float outputPowerDC() { return static_cast<float>(datalayer.charger.charger_stat_HVcur * 100); }
 
@@ -29,9 +40,9 @@ class NissanLeafCharger : public CanCharger {
   float HVDC_output_voltage() { return static_cast<float>(datalayer.battery.status.voltage_dV / 10); }
 
  private:
-  /* CAN cycles and timers */
-  unsigned long previousMillis10ms = 0;
-  unsigned long previousMillis100ms = 0;
+  /* CAN cycles */
+  void transmit_10ms();
+  void transmit_100ms();
 
   /* LEAF charger/battery parameters */
   enum OBC_MODES : uint8_t {
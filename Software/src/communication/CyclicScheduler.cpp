@@ -0,0 +1,77 @@
+#include "CyclicScheduler.h"
+#include <algorithm>
+#include <numeric>
+
+// True if a is due after b. Compared by difference so a millis() wrap is harmless.
+static bool due_later(unsigned long a, unsigned long b) {
+  return (long)(a - b) > 0;
+}
+
+bool CyclicScheduler::due_first(const Task& a, const Task& b) {
+  return due_later(a.due, b.due);
+}
+
+unsigned long CyclicScheduler::pick_phase(unsigned long period_ms) const {
+  // Two tasks fire in the same millisecond whenever their phases are equal modulo the gcd of their periods,
+  // which happens once every lcm of the periods. Pick the phase where that happens least often.
+  const unsigned long candidates = std::min(period_ms, 1000UL);
+  unsigned long best_phase = 0;
+  double best_cost = -1;
+  for (unsigned long phase = 0; phase < candidates; phase++) {
+    double cost = 0;
+    for (auto& task : tasks) {
+      const unsigned long gcd = std::gcd(period_ms, task.period);
+      if (phase % gcd == task.phase % gcd) {
+        cost += (double)gcd / task.period;
+      }
+    }
+    if (best_cost < 0 || cost < best_cost) {
+      best_cost = cost;
+      best_phase = phase;
+    }
+    if (cost == 0) {
+      break;
+    }
+  }
+  return best_phase;
+}
+
+unsigned long CyclicScheduler::add(unsigned long period_ms, Callback callback, unsigned long now_ms, long phase_ms) {
+  if (period_ms == 0) {
+    period_ms = 1;
+  }
+  const unsigned long phase = (phase_ms < 0) ? pick_phase(period_ms) : (unsigned long)phase_ms % period_ms;
+
+  unsigned long due = now_ms - (now_ms % period_ms) + phase;
+  if (due_later(now_ms, due)) {
+    due += period_ms;
+  }
+
+  tasks.push_back({due, period_ms, phase, callback});
+  std::push_heap(tasks.begin(), tasks.end(), due_first);
+  return phase;
+}
+
+uint16_t CyclicScheduler::run(unsigned long now_ms) {
+  uint16_t count = 0;
+
+  while (!tasks.empty() && !due_later(tasks.front().due, now_ms)) {
+    std::pop_heap(tasks.begin(), tasks.end(), due_first);
+    // Taken out of the heap while running, as the callback may register new tasks
+    Task task = std::move(tasks.back());
+    tasks.pop_back();
+
+    task.callback(now_ms);
+    count++;
+
+    task.due += task.period;
+    if (!due_later(task.due, now_ms)) {
+      // Fell behind by more than a period, skip the missed runs but keep the phase
+      task.due += ((now_ms - task.due) / task.period + 1) * task.period;
+    }
+
+    tasks.push_back(std::move(task));
+    std::push_heap(tasks.begin(), tasks.end(), due_first);
+  }
+  return count;
+}
@@ -0,0 +1,47 @@
+#ifndef _CYCLIC_SCHEDULER_H
+#define _CYCLIC_SCHEDULER_H
+
+#include <stdint.h>
+#include <functional>
+#include <vector>
+
+// Runs periodic tasks, typically the sending of cyclic CAN messages. Tasks are kept in a min-heap
+// ordered by due time, so a tick where nothing is due costs a single comparison.
+class CyclicScheduler {
+ public:
+  typedef std::function<void(unsigned long currentMillis)> Callback;
+
+  // Let the scheduler pick the phase with the fewest collisions with already registered tasks
+  static constexpr long AUTO_PHASE = -1;
+
+  // Registers a task run every period_ms. It runs whenever millis() % period_ms == phase_ms, the first
+  // time at or after now_ms. Returns the phase used.
+  unsigned long add(unsigned long period_ms, Callback callback, unsigned long now_ms, long phase_ms = AUTO_PHASE);
+
+  // Runs every task that is due, in order of due time. Returns the amount of tasks run.
+  uint16_t run(unsigned long now_ms);
+
+  size_t size() const { return tasks.size(); }
+
+  void clear() { tasks.clear(); }
+
+ private:
+  struct Task {
+    unsigned long due;
+    unsigned long period;
+    unsigned long phase;
+    Callback callback;
+  };
+
+  // Heap comparator, puts the task due first at the front
+  static bool due_first(const Task& a, const Task& b);
+  unsigned long pick_phase(unsigned long period_ms) const;
+
+  std::vector<Task> tasks;
+};
+
+// Registers a periodic task with the scheduler driven by core_loop
+void register_cyclic_task(unsigned long period_ms, CyclicScheduler::Callback callback,
+                          long phase_ms = CyclicScheduler::AUTO_PHASE);
+
+#endif
@@ -0,0 +1,51 @@
+#include "CanDispatcher.h"
+
+static constexpr uint32_t STD_ID_COUNT = 0x800;
+static constexpr uint32_t EXT_ID_MAX = 0x1FFFFFFF;
+
+bool CanDispatcher::add_receiver(CanReceiver* receiver, const std::vector<CAN_id_range>& ids) {
+  if (receivers.size() >= MAX_RECEIVERS) {
+    return false;
+  }
+
+  const uint8_t bit = 1 << receivers.size();
+  receivers.push_back(receiver);
+
+  if (ids.empty()) {
+    all_ids_mask |= bit;
+    return true;
+  }
+
+  for (auto range : ids) {
+    if (range.first > range.last) {
+      std::swap(range.first, range.last);
+    }
+    ranges.push_back(range);
+
+    if (!range.ext_ID) {
+      if (std_table.empty()) {
+        std_table.assign(STD_ID_COUNT, 0);
+      }
+      for (uint32_t id = range.first; id <= range.last && id < STD_ID_COUNT; id++) {
+        std_table[id] |= bit;
+      }
+    } else if (range.last - range.first < MAX_EXPANDED_EXT_RANGE) {
+      for (uint32_t id = range.first; id <= range.last && id <= EXT_ID_MAX; id++) {
+        ext_table[id] |= bit;
+      }
+    } else {
+      ext_ranges.push_back({range, bit});
+    }
+  }
+
+  return true;
+}
+
+void CanDispatcher::clear() {
+  receivers.clear();
+  ranges.clear();
+  std_table.clear();
+  ext_table.clear();
+  ext_ranges.clear();
+  all_ids_mask = 0;
+}
@@ -0,0 +1,75 @@
+#ifndef _CANDISPATCHER_H
+#define _CANDISPATCHER_H
+
+#include <unordered_map>
+#include <vector>
+#include "../../devboard/utils/types.h"
+#include "CanReceiver.h"
+
+// Per-interface lookup table from CAN ID to the receivers interested in it.
+// Standard (11-bit) IDs are looked up in a dense array, extended (29-bit) IDs in a
+// small hash map, so frames nobody handles are rejected with a single lookup.
+class CanDispatcher {
+ public:
+  // Maximum amount of receivers per interface, each receiver is one bit in the lookup masks
+  static constexpr size_t MAX_RECEIVERS = 8;
+  // Extended ID ranges larger than this are matched by a linear scan instead of being expanded into the hash map
+  static constexpr uint32_t MAX_EXPANDED_EXT_RANGE = 64;
+
+  // Adds a receiver interested in the given IDs. An empty list subscribes it to every frame.
+  // Returns false if the interface already has MAX_RECEIVERS receivers.
+  bool add_receiver(CanReceiver* receiver, const std::vector<CAN_id_range>& ids);
+
+  // Delivers the frame to every receiver interested in its ID
+  void dispatch(const CAN_frame& frame) const {
+    uint8_t mask = lookup(frame.ID, frame.ext_ID);
+    for (size_t i = 0; mask != 0; i++, mask >>= 1) {
+      if (mask & 1) {
+        receivers[i]->receive_can_frame(frame);
+      }
+    }
+  }
+
+  // True if at least one receiver wants frames with this ID
+  bool wants(uint32_t id, bool ext_ID) const { return lookup(id, ext_ID) != 0; }
+
+  // True if a receiver subscribed to every frame on the interface
+  bool wants_all() const { return all_ids_mask != 0; }
+
+  bool empty() const { return receivers.empty(); }
+
+  // All ID ranges declared by the receivers of this interface
+  const std::vector<CAN_id_range>& declared_ranges() const { return ranges; }
+
+  void clear();
+
+ private:
+  uint8_t lookup(uint32_t id, bool ext_ID) const {
+    if (!ext_ID) {
+      return (id < std_table.size()) ? std_table[id] | all_ids_mask : all_ids_mask;
+    }
+    uint8_t mask = all_ids_mask;
+    if (!ext_table.empty()) {
+      auto it = ext_table.find(id);
+      if (it != ext_table.end()) {
+        mask |= it->second;
+      }
+    }
+    for (auto& range : ext_ranges) {
+      if (id >= range.first.first && id <= range.first.last) {
+        mask |= range.second;
+      }
+    }
+    return mask;
+  }
+
+  std::vector<CanReceiver*> receivers;
+  std::vector<CAN_id_range> ranges;
+  // One receiver bitmask per standard ID, allocated on first use
+  std::vector<uint8_t> std_table;
+  std::unordered_map<uint32_t, uint8_t> ext_table;
+  std::vector<std::pair<CAN_id_range, uint8_t>> ext_ranges;
+  uint8_t all_ids_mask = 0;
+};
+
+#endif
@@ -0,0 +1,217 @@
+#include "CanFilters.h"
+#include <algorithm>
+#include <set>
+
+static constexpr uint32_t STD_ID_MASK = 0x7FF;
+static constexpr uint32_t EXT_ID_MASK = 0x1FFFFFFF;
+static constexpr size_t MCP2515_MAX_FILTERS = 6;
+
+static uint32_t id_mask(bool ext_ID) {
+  return ext_ID ? EXT_ID_MASK : STD_ID_MASK;
+}
+
+// Number of IDs a mask lets through
+static uint64_t accepted_count(uint32_t mask, bool ext_ID) {
+  return uint64_t(1) << __builtin_popcount(id_mask(ext_ID) & ~mask);
+}
+
+// True if everything b accepts is also accepted by a
+static bool covers(const CAN_acceptance_filter& a, const CAN_acceptance_filter& b) {
+  return (b.mask & a.mask) == a.mask && (b.id & a.mask) == a.id;
+}
+
+static CAN_acceptance_filter merge(const CAN_acceptance_filter& a, const CAN_acceptance_filter& b) {
+  uint32_t mask = a.mask & b.mask & ~(a.id ^ b.id);
+  return {a.id & mask, mask, a.ext_ID};
+}
+
+static void remove_covered(std::vector<CAN_acceptance_filter>& filters) {
+  for (size_t i = 0; i < filters.size();) {
+    bool covered = false;
+    for (size_t j = 0; j < filters.size() && !covered; j++) {
+      // Of two identical filters, only the later one is removed
+      covered = j != i && covers(filters[j], filters[i]) && (j < i || !covers(filters[i], filters[j]));
+    }
+    if (covered) {
+      filters.erase(filters.begin() + i);
+    } else {
+      i++;
+    }
+  }
+}
+
+// Splits [first, last] into the minimal list of aligned power-of-two blocks, each one exact filter
+static void split_range(uint32_t first, uint32_t last, bool ext_ID, std::vector<CAN_acceptance_filter>& out) {
+  const uint32_t full = id_mask(ext_ID);
+  if (first > last) {
+    std::swap(first, last);
+  }
+  if (first > full) {
+    return;
+  }
+  uint64_t a = first;
+  uint64_t b = std::min(last, full);
+  while (a <= b) {
+    uint64_t size = (a == 0) ? uint64_t(full) + 1 : (a & (~a + 1));
+    while (a + size - 1 > b) {
+      size >>= 1;
+    }
+    out.push_back({uint32_t(a), full & ~uint32_t(size - 1), ext_ID});
+    a += size;
+  }
+}
+
+bool filter_accepts(const CAN_acceptance_filter& filter, uint32_t id, bool ext_ID) {
+  return filter.ext_ID == ext_ID && (id & filter.mask) == filter.id;
+}
+
+std::vector<CAN_acceptance_filter> compute_acceptance_filters(const std::vector<CAN_id_range>& ranges, bool ext_ID,
+                                                              size_t max_filters) {
+  std::vector<CAN_acceptance_filter> filters;
+  for (auto& range : ranges) {
+    if (range.ext_ID == ext_ID) {
+      split_range(range.first, range.last, ext_ID, filters);
+    }
+  }
+  remove_covered(filters);
+
+  max_filters = std::max<size_t>(max_filters, 1);
+  while (filters.size() > max_filters) {
+    size_t best_i = 0;
+    size_t best_j = 1;
+    uint64_t best_cost = UINT64_MAX;
+    for (size_t i = 0; i < filters.size(); i++) {
+      for (size_t j = i + 1; j < filters.size(); j++) {
+        // Blocks are disjoint, so this is the amount of unwanted IDs the merge lets through
+        uint64_t cost = accepted_count(merge(filters[i], filters[j]).mask, ext_ID) -
+                        accepted_count(filters[i].mask, ext_ID) - accepted_count(filters[j].mask, ext_ID);
+        if (cost < best_cost) {
+          best_cost = cost;
+          best_i = i;
+          best_j = j;
+        }
+      }
+    }
+    filters[best_i] = merge(filters[best_i], filters[best_j]);
+    filters.erase(filters.begin() + best_j);
+    remove_covered(filters);
+  }
+  return filters;
+}
+
+static void find_formats(const std::vector<CAN_id_range>& ranges, bool& has_std, bool& has_ext) {
+  has_std = std::any_of(ranges.begin(), ranges.end(), [](const CAN_id_range& r) { return !r.ext_ID; });
+  has_ext = std::any_of(ranges.begin(), ranges.end(), [](const CAN_id_range& r) { return r.ext_ID; });
+}
+
+CAN_native_filter_plan plan_native_filters(const std::vector<CAN_id_range>& ranges) {
+  CAN_native_filter_plan plan = {true, {}};
+  bool has_std, has_ext;
+  find_formats(ranges, has_std, has_ext);
+
+  // The TWAI filter format is either standard or extended, mixed traffic has to pass unfiltered
+  if (has_std == has_ext) {
+    return plan;
+  }
+  plan.accept_all = false;
+  // In dual filter mode extended frames are only compared on their upper 16 bits, so use a single filter
+  plan.filters = compute_acceptance_filters(ranges, has_ext, has_ext ? 1 : 2);
+  return plan;
+}
+
+// Shares one mask between filters: the common mask is the AND of all of them
+static uint32_t group_mask(const std::vector<CAN_acceptance_filter>& group) {
+  uint32_t mask = UINT32_MAX;
+  for (auto& filter : group) {
+    mask &= filter.mask;
+  }
+  return mask;
+}
+
+static std::set<uint32_t> group_ids(const std::vector<CAN_acceptance_filter>& group, uint32_t mask) {
+  std::set<uint32_t> ids;
+  for (auto& filter : group) {
+    ids.insert(filter.id & mask);
+  }
+  return ids;
+}
+
+static uint64_t group_cost(const std::vector<CAN_acceptance_filter>& group, bool ext_ID) {
+  uint32_t mask = group_mask(group);
+  return group_ids(group, mask).size() * accepted_count(mask, ext_ID);
+}
+
+CAN_mcp2515_filter_plan plan_mcp2515_filters(const std::vector<CAN_id_range>& ranges) {
+  CAN_mcp2515_filter_plan plan = {true, {0, 0}, false, {}};
+  bool has_std, has_ext;
+  find_formats(ranges, has_std, has_ext);
+
+  // A mask applies to the standard and extended filters alike, so mixed traffic passes unfiltered
+  if (has_std == has_ext) {
+    return plan;
+  }
+  plan.accept_all = false;
+  plan.ext_ID = has_ext;
+
+  auto candidates = compute_acceptance_filters(ranges, has_ext, MCP2515_MAX_FILTERS);
+  if (candidates.size() == 1) {
+    plan.masks[0] = plan.masks[1] = candidates[0].mask;
+    plan.filters = candidates;
+    return plan;
+  }
+
+  // Try every split of the candidates into the RXM0 group (1-2 filters) and the RXM1 group (1-4 filters)
+  std::vector<CAN_acceptance_filter> best_first, best_second;
+  uint64_t best_cost = UINT64_MAX;
+  for (size_t i = 0; i < candidates.size(); i++) {
+    for (size_t j = i; j < candidates.size(); j++) {
+      std::vector<CAN_acceptance_filter> first, second;
+      for (size_t k = 0; k < candidates.size(); k++) {
+        (k == i || k == j ? first : second).push_back(candidates[k]);
+      }
+      if (second.empty() || second.size() > 4) {
+        continue;
+      }
+      uint64_t cost = group_cost(first, has_ext) + group_cost(second, has_ext);
+      if (cost < best_cost) {
+        best_cost = cost;
+        best_first = first;
+        best_second = second;
+      }
+    }
+  }
+
+  plan.masks[0] = group_mask(best_first);
+  plan.masks[1] = group_mask(best_second);
+  auto first_ids = group_ids(best_first, plan.masks[0]);
+  for (uint32_t id : first_ids) {
+    plan.filters.push_back({id, plan.masks[0], has_ext});
+  }
+  // The two mask variant of ACAN2515::begin expects exactly two filters for RXM0
+  if (first_ids.size() == 1) {
+    plan.filters.push_back(plan.filters.front());
+  }
+  for (uint32_t id : group_ids(best_second, plan.masks[1])) {
+    plan.filters.push_back({id, plan.masks[1], has_ext});
+  }
+  return plan;
+}
+
+CAN_mcp2518_filter_plan plan_mcp2518_filters(const std::vector<CAN_id_range>& ranges) {
+  CAN_mcp2518_filter_plan plan = {true, {}};
+  if (ranges.empty()) {
+    return plan;
+  }
+  plan.accept_all = false;
+
+  // Each format gets half of the filters, whatever one of them leaves unused goes to the other
+  const size_t half = MCP2518_MAX_FILTERS / 2;
+  auto std_filters = compute_acceptance_filters(ranges, false, half);
+  auto ext_filters = compute_acceptance_filters(ranges, true, MCP2518_MAX_FILTERS - std_filters.size());
+  if (std_filters.size() == half) {
+    std_filters = compute_acceptance_filters(ranges, false, MCP2518_MAX_FILTERS - ext_filters.size());
+  }
+  plan.filters = std_filters;
+  plan.filters.insert(plan.filters.end(), ext_filters.begin(), ext_filters.end());
+  return plan;
+}
@@ -0,0 +1,52 @@
+#ifndef _CANFILTERS_H
+#define _CANFILTERS_H
+
+#include <vector>
+#include "CanReceiver.h"
+
+// Hardware acceptance filter planning. The functions here only do ID/mask arithmetic so that the
+// result can be verified on the host; comm_can.cpp turns the plans into controller specific filters.
+
+/* A frame is accepted when (frame ID & mask) == id. Bits cleared in mask are "don't care". */
+typedef struct {
+  uint32_t id;
+  uint32_t mask;
+  bool ext_ID;
+} CAN_acceptance_filter;
+
+/* ESP32 TWAI controller: one filter for 29-bit IDs or up to two filters for 11-bit IDs */
+typedef struct {
+  bool accept_all;
+  std::vector<CAN_acceptance_filter> filters;
+} CAN_native_filter_plan;
+
+/* MCP2515: filters 0-1 are compared using masks[0], filters 2-5 using masks[1] */
+typedef struct {
+  bool accept_all;
+  uint32_t masks[2];
+  bool ext_ID;
+  std::vector<CAN_acceptance_filter> filters;
+} CAN_mcp2515_filter_plan;
+
+/* MCP2518: up to 32 independent mask/acceptance pairs */
+typedef struct {
+  bool accept_all;
+  std::vector<CAN_acceptance_filter> filters;
+} CAN_mcp2518_filter_plan;
+
+static constexpr size_t MCP2518_MAX_FILTERS = 32;
+
+bool filter_accepts(const CAN_acceptance_filter& filter, uint32_t id, bool ext_ID);
+
+// Returns at most max_filters filters accepting every ID of the given format in ranges.
+// Ranges are split into exact power-of-two blocks, which are then merged pairwise, always picking
+// the merge that lets the fewest extra IDs through, until max_filters is reached.
+std::vector<CAN_acceptance_filter> compute_acceptance_filters(const std::vector<CAN_id_range>& ranges, bool ext_ID,
+                                                              size_t max_filters);
+
+// An empty ranges list means the interface wants every frame, so no filtering is done
+CAN_native_filter_plan plan_native_filters(const std::vector<CAN_id_range>& ranges);
+CAN_mcp2515_filter_plan plan_mcp2515_filters(const std::vector<CAN_id_range>& ranges);
+CAN_mcp2518_filter_plan plan_mcp2518_filters(const std::vector<CAN_id_range>& ranges);
+
+#endif
@@ -1,11 +1,23 @@
 #ifndef _CANRECEIVER_H
 #define _CANRECEIVER_H
 
+#include <vector>
 #include "../../devboard/utils/types.h"
 
+/* Inclusive range of CAN IDs a receiver wants delivered */
+typedef struct {
+  uint32_t first;
+  uint32_t last;
+  bool ext_ID;
+} CAN_id_range;
+
 class CanReceiver {
  public:
-  virtual void receive_can_frame(CAN_frame* rx_frame) = 0;
+  virtual void receive_can_frame(const CAN_frame& rx_frame) = 0;
+
+  // The CAN IDs this receiver handles. Queried once when CAN is initialized.
+  // An empty list means that every frame on the interface is delivered.
+  virtual std::vector<CAN_id_range> can_ids_of_interest() { return {}; }
 };
 
 #endif
@@ -0,0 +1,50 @@
+#include "CanReplayBlocks.h"
+
+CanReplayBlocks::CanReplayBlocks(uint8_t* first, uint8_t* second, size_t size)
+    : blocks{{first, 0}, {second, 0}}, size(size) {
+  free_blocks = xQueueCreate(2, sizeof(Block*));
+  full_blocks = xQueueCreate(2, sizeof(Block*));
+}
+
+CanReplayBlocks::~CanReplayBlocks() {
+  if (free_blocks != NULL) {
+    vQueueDelete(free_blocks);
+  }
+  if (full_blocks != NULL) {
+    vQueueDelete(full_blocks);
+  }
+}
+
+bool CanReplayBlocks::valid() const {
+  return blocks[0].data != NULL && blocks[1].data != NULL && free_blocks != NULL && full_blocks != NULL;
+}
+
+void CanReplayBlocks::reset() {
+  // The previous pass may have ended with a block already back in free_blocks. Refilling without emptying the
+  // queues first would hand that block to the reader twice, which then overwrites it while it is decoded.
+  xQueueReset(free_blocks);
+  xQueueReset(full_blocks);
+  for (Block& block : blocks) {
+    Block* free_block = &block;
+    xQueueSend(free_blocks, &free_block, 0);
+  }
+}
+
+bool CanReplayBlocks::fill(const Read& read, TickType_t wait) {
+  Block* block;
+  if (xQueueReceive(free_blocks, &block, wait) != pdTRUE) {
+    return true;
+  }
+  block->len = read(block->data, size);
+  xQueueSend(full_blocks, &block, portMAX_DELAY);
+  return block->len > 0;
+}
+
+CanReplayBlocks::Block* CanReplayBlocks::take(TickType_t wait) {
+  Block* block;
+  return (xQueueReceive(full_blocks, &block, wait) == pdTRUE) ? block : NULL;
+}
+
+void CanReplayBlocks::give_back(Block* block) {
+  xQueueSend(free_blocks, &block, 0);
+}
@@ -0,0 +1,48 @@
+#ifndef _CANREPLAYBLOCKS_H
+#define _CANREPLAYBLOCKS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <functional>
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+
+// The two blocks a log file is streamed through during a replay. A reader task fills the free blocks while the
+// replay decodes the full ones, each handed over through a queue, so neither waits unless the other falls behind.
+class CanReplayBlocks {
+ public:
+  struct Block {
+    uint8_t* data;
+    size_t len;
+  };
+
+  // Reads up to size bytes of the log into data, 0 at its end
+  typedef std::function<size_t(uint8_t* data, size_t size)> Read;
+
+  // Streams through the two buffers of size bytes each
+  CanReplayBlocks(uint8_t* first, uint8_t* second, size_t size);
+  ~CanReplayBlocks();
+
+  bool valid() const;
+
+  // Starts a pass with both blocks free and none full, whatever the previous pass left in the queues
+  void reset();
+
+  // Reader task: fills the next free block and hands it to the replay. A block read() leaves empty ends the pass,
+  // after handing it over this returns false.
+  bool fill(const Read& read, TickType_t wait = portMAX_DELAY);
+
+  // Replay: the next full block, NULL if none came within wait
+  Block* take(TickType_t wait);
+
+  // Replay: hands a decoded block back to the reader
+  void give_back(Block* block);
+
+ private:
+  Block blocks[2];
+  size_t size;
+  QueueHandle_t free_blocks;
+  QueueHandle_t full_blocks;
+};
+
+#endif
@@ -0,0 +1,24 @@
+#include "CanReplayPlayer.h"
+
+bool CanReplayPlayer::route(const CAN_log_record& record, CAN_frame& frame, CAN_Interface& interface,
+                            int64_t& deadline_us) {
+  // Frames of buses that are off still move the schedule on, like any other frame of the log
+  deadline_us = replay_timing_next_deadline_us(timing, record.timestamp_us);
+
+  interface = default_interface;
+  if (options.map_buses) {
+    const uint8_t mapped =
+        (record.interface < CAN_REPLAY_BUSES) ? options.bus_map[record.interface] : CAN_REPLAY_BUS_OFF;
+    if (mapped == CAN_REPLAY_BUS_OFF) {
+      return false;
+    }
+    interface = (CAN_Interface)mapped;
+  }
+  // Anything else would index past the per-interface tables of comm_can
+  if (interface > CANFD_ADDON_MCP2518) {
+    return false;
+  }
+
+  can_log_record_to_frame(record, frame);
+  return true;
+}
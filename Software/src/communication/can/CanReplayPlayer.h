@@ -0,0 +1,68 @@
+#ifndef _CANREPLAYPLAYER_H
+#define _CANREPLAYPLAYER_H
+
+#include <stdint.h>
+#include "../../devboard/sdcard/can_log_format.h"
+#include "../../devboard/utils/types.h"
+#include "CanReplayTiming.h"
+
+enum CAN_replay_source : uint8_t { REPLAY_FROM_UPLOAD = 0, REPLAY_FROM_SD = 1 };
+
+enum CAN_replay_target : uint8_t {
+  // Frames are sent out of the interfaces
+  REPLAY_TO_BUS = 0,
+  // Frames are handed to the receivers registered for the interfaces, as if they had been received
+  REPLAY_TO_RECEIVERS = 1
+};
+
+// Buses of a log that can be mapped, RX0 to TX7 in the text logs: RX and TX of the four interfaces
+static constexpr uint8_t CAN_REPLAY_BUSES = 8;
+// Bus map entry for buses that are not replayed
+static constexpr uint8_t CAN_REPLAY_BUS_OFF = 0xFF;
+
+typedef struct {
+  CAN_replay_source source;
+  /** Start over at the end of the log, until stopped */
+  bool loop;
+  /** Seconds from the start of the log that are skipped */
+  uint32_t start_s;
+  /** Playback speed, 100 replays the log as it was recorded */
+  uint32_t speed_percent;
+  /** Send the frames of each bus to the interface in bus_map, instead of all to can_replay_interface */
+  bool map_buses;
+  /** CAN_Interface for the frames of each RXn/TXn bus number of the log, or CAN_REPLAY_BUS_OFF */
+  uint8_t bus_map[CAN_REPLAY_BUSES];
+  CAN_replay_target target;
+  /** Hold back every frame the firmware itself transmits while the replay feeds the receivers */
+  bool suppress_tx;
+} CAN_replay_options;
+
+// Decides where each record of a replay goes and when it is due. Waiting and sending are up to the caller:
+// the replay task waits on esp_timer, a host test simply moves its clock to the deadline and so replays
+// hours of a log in moments.
+class CanReplayPlayer {
+ public:
+  CanReplayPlayer(const CAN_replay_options& options, CAN_Interface default_interface, CAN_replay_timing& timing)
+      : options(options), default_interface(default_interface), timing(timing) {}
+
+  // Starts a pass through the log at now_us with the record logged at first_log_us
+  void start_pass(int64_t now_us, int64_t first_log_us) {
+    replay_timing_start_pass(timing, now_us, first_log_us, options.speed_percent);
+  }
+
+  // Fills in the frame of a record, whose interface is the bus number of the log, the interface it goes to and
+  // when it is due. Returns false for records of buses that are not replayed or mapped to no valid interface.
+  bool route(const CAN_log_record& record, CAN_frame& frame, CAN_Interface& interface, int64_t& deadline_us);
+
+  // Records that the frame due at deadline_us was sent or handed to the receivers at done_us
+  void done(int64_t deadline_us, int64_t done_us, uint32_t late_tolerance_us) {
+    replay_timing_record(timing, deadline_us, done_us, late_tolerance_us);
+  }
+
+ private:
+  const CAN_replay_options& options;
+  CAN_Interface default_interface;
+  CAN_replay_timing& timing;
+};
+
+#endif
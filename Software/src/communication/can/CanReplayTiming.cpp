@@ -0,0 +1,66 @@
+#include "CanReplayTiming.h"
+
+void replay_timing_reset(CAN_replay_timing& timing) {
+  timing.start_us = 0;
+  timing.first_log_us = 0;
+  timing.speed_percent = 100;
+  timing.last_log_us = 0;
+  timing.last_deadline_us = 0;
+  timing.frames = 0;
+  timing.sum_error_us = 0;
+  timing.max_error_us = 0;
+  for (uint8_t i = 0; i < CAN_TX_JITTER_BUCKETS; i++) {
+    timing.histogram[i] = 0;
+  }
+  timing.late = 0;
+}
+
+void replay_timing_start_pass(CAN_replay_timing& timing, int64_t now_us, int64_t first_log_us, uint32_t speed_percent) {
+  timing.start_us = now_us;
+  timing.first_log_us = first_log_us;
+  timing.speed_percent = (speed_percent > 0) ? speed_percent : 1;
+  timing.last_log_us = first_log_us;
+  timing.last_deadline_us = now_us;
+}
+
+int64_t replay_timing_next_deadline_us(CAN_replay_timing& timing, int64_t log_us) {
+  if (timing.last_log_us - log_us > CAN_REPLAY_CLOCK_RESTART_US) {
+    timing.start_us = timing.last_deadline_us;
+    timing.first_log_us = log_us;
+    timing.last_log_us = log_us;
+  }
+  const int64_t deadline_us = timing.start_us + (log_us - timing.first_log_us) * 100 / timing.speed_percent;
+  // Out of order frames don't move the schedule back, that would delay every frame after them
+  if (log_us >= timing.last_log_us) {
+    timing.last_log_us = log_us;
+    timing.last_deadline_us = deadline_us;
+  }
+  return deadline_us;
+}
+
+void replay_timing_record(CAN_replay_timing& timing, int64_t deadline_us, int64_t sent_us,
+                          uint32_t late_tolerance_us) {
+  const int64_t error = sent_us - deadline_us;
+  const uint32_t error_us = (error <= 0) ? 0 : (error > UINT32_MAX ? UINT32_MAX : (uint32_t)error);
+
+  timing.frames++;
+  timing.sum_error_us += error_us;
+  if (error_us > timing.max_error_us) {
+    timing.max_error_us = error_us;
+  }
+  uint8_t bucket = 0;
+  while (bucket < CAN_TX_JITTER_BUCKETS - 1 && error_us > CAN_TX_JITTER_BUCKET_LIMITS_US[bucket]) {
+    bucket++;
+  }
+  timing.histogram[bucket]++;
+  if (error_us > late_tolerance_us) {
+    timing.late++;
+  }
+}
+
+uint32_t replay_timing_mean_error_us(const CAN_replay_timing& timing) {
+  if (timing.frames == 0) {
+    return 0;
+  }
+  return timing.sum_error_us / timing.frames;
+}
@@ -0,0 +1,50 @@
+#ifndef _CANREPLAYTIMING_H
+#define _CANREPLAYTIMING_H
+
+#include <stdint.h>
+#include "CanTxTiming.h"
+
+// Schedule and timing error of CAN replay. Every frame is due at a deadline computed from its log timestamp
+// against the start of the replay, never against the previous frame, so waiting errors don't add up over a log.
+
+typedef struct {
+  /** Local time the first frame of the pass was due */
+  int64_t start_us;
+  /** Log timestamp of the first frame of the pass */
+  int64_t first_log_us;
+  /** Playback speed, 100 replays the log as it was recorded, 200 twice as fast */
+  uint32_t speed_percent;
+  /** Latest log timestamp of the pass and its deadline */
+  int64_t last_log_us;
+  int64_t last_deadline_us;
+  /** Frames sent, and how late they went out */
+  uint32_t frames;
+  uint64_t sum_error_us;
+  uint32_t max_error_us;
+  /** Frames by how late they were sent, see CAN_TX_JITTER_BUCKET_LIMITS_US */
+  uint32_t histogram[CAN_TX_JITTER_BUCKETS];
+  /** Frames sent more than the late tolerance after their deadline */
+  uint32_t late;
+} CAN_replay_timing;
+
+// Clears the statistics
+void replay_timing_reset(CAN_replay_timing& timing);
+
+// Starts a pass through the log at speed_percent, the frame logged at first_log_us is due at now_us
+void replay_timing_start_pass(CAN_replay_timing& timing, int64_t now_us, int64_t first_log_us, uint32_t speed_percent);
+
+// Log timestamps going back further than this are a new log clock, as where the logging board rebooted
+static constexpr int64_t CAN_REPLAY_CLOCK_RESTART_US = 1000000;
+
+// Local time the next frame, logged at log_us, is due. A frame logged slightly before the previous one, as RX
+// frames logged when core_loop handles them often are, keeps its own deadline and is due right away when that
+// has passed. Jumps back by more than CAN_REPLAY_CLOCK_RESTART_US restart the schedule from there, with the
+// frame due together with the latest one.
+int64_t replay_timing_next_deadline_us(CAN_replay_timing& timing, int64_t log_us);
+
+// Records a frame due at deadline_us that was sent at sent_us
+void replay_timing_record(CAN_replay_timing& timing, int64_t deadline_us, int64_t sent_us, uint32_t late_tolerance_us);
+
+uint32_t replay_timing_mean_error_us(const CAN_replay_timing& timing);
+
+#endif
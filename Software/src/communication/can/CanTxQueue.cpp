@@ -0,0 +1,61 @@
+#include "CanTxQueue.h"
+#include <algorithm>
+
+uint32_t CanTxQueue::arbitration_key(const CAN_frame& frame) {
+  // Base ID first, then the SRR/IDE bits (recessive for extended frames), then the 18 bit ID extension
+  if (frame.ext_ID) {
+    return ((frame.ID >> 18) & 0x7FF) << 19 | 1 << 18 | (frame.ID & 0x3FFFF);
+  }
+  return (frame.ID & 0x7FF) << 19;
+}
+
+void CanTxQueue::push(const CAN_frame& frame, bool cyclic) {
+  if (cyclic) {
+    for (uint8_t i = 0; i < count; i++) {
+      if (cyclic_frames[i] && frames[i].ID == frame.ID && frames[i].ext_ID == frame.ext_ID) {
+        frames[i] = frame;
+        stats.coalesced++;
+        return;
+      }
+    }
+  }
+
+  const uint32_t key = arbitration_key(frame);
+  if (count == CAN_TX_QUEUE_SIZE) {
+    stats.dropped++;
+    if (key >= arbitration_key(frames[count - 1])) {
+      return;
+    }
+    count--;
+  }
+
+  uint8_t pos = count;
+  while (pos > 0 && arbitration_key(frames[pos - 1]) > key) {
+    frames[pos] = frames[pos - 1];
+    cyclic_frames[pos] = cyclic_frames[pos - 1];
+    pos--;
+  }
+  frames[pos] = frame;
+  cyclic_frames[pos] = cyclic;
+  count++;
+  update_depth();
+}
+
+std::span<const CAN_frame> CanTxQueue::front(size_t max) const {
+  return std::span<const CAN_frame>(frames, std::min<size_t>(max, count));
+}
+
+void CanTxQueue::pop(size_t n) {
+  n = std::min<size_t>(n, count);
+  std::copy(frames + n, frames + count, frames);
+  std::copy(cyclic_frames + n, cyclic_frames + count, cyclic_frames);
+  count -= n;
+  update_depth();
+}
+
+void CanTxQueue::update_depth() {
+  stats.depth = count;
+  if (count > stats.depth_max) {
+    stats.depth_max = count;
+  }
+}
@@ -0,0 +1,56 @@
+#ifndef _CANTXQUEUE_H
+#define _CANTXQUEUE_H
+
+#include <span>
+#include "../../devboard/utils/types.h"
+#include "../../system_settings.h"
+
+typedef struct {
+  /** Frames currently waiting to be handed to the driver */
+  uint8_t depth;
+  /** Highest depth seen */
+  uint8_t depth_max;
+  /** Frames lost because the queue was full with frames of higher priority */
+  uint32_t dropped;
+  /** Queued frames replaced by a newer frame with the same ID before they were sent */
+  uint32_t coalesced;
+} CAN_tx_queue_stats;
+
+// Bounded queue of frames the CAN driver could not take yet. Frames leave in the order they would win bus
+// arbitration. Frames of cyclic messages are coalesced: a queued one is replaced when a newer one with the same
+// ID arrives, as only their latest content matters. Other frames, like the parts of a multi-frame transfer that
+// share an ID, are all kept.
+class CanTxQueue {
+ public:
+  explicit CanTxQueue(CAN_tx_queue_stats& stats) : stats(stats) {}
+
+  // When full, the frame with the lowest priority is dropped, which may be the one being pushed. A frame of a
+  // cyclic message replaces a queued frame of a cyclic message with the same ID.
+  void push(const CAN_frame& frame, bool cyclic);
+
+  // Up to max frames with the highest priority, highest first
+  std::span<const CAN_frame> front(size_t max) const;
+
+  // Whether the frame at index of front() was pushed as a frame of a cyclic message
+  bool cyclic(size_t index) const { return cyclic_frames[index]; }
+
+  // Removes count frames from the front
+  void pop(size_t count);
+
+  bool empty() const { return count == 0; }
+  size_t size() const { return count; }
+
+  // Lower keys win arbitration. A standard frame beats an extended frame with the same base ID.
+  static uint32_t arbitration_key(const CAN_frame& frame);
+
+ private:
+  void update_depth();
+
+  CAN_frame frames[CAN_TX_QUEUE_SIZE];
+  // Kept apart from frames, so front() can hand them to the driver as they are
+  bool cyclic_frames[CAN_TX_QUEUE_SIZE];
+  uint8_t count = 0;
+  CAN_tx_queue_stats& stats;
+};
+
+#endif
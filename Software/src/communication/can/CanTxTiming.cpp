@@ -0,0 +1,62 @@
+#include "CanTxTiming.h"
+
+void tx_timing_init(CAN_tx_timing& timing, uint32_t ID, CAN_Interface interface, uint32_t period_ms) {
+  timing.ID = ID;
+  timing.interface = interface;
+  timing.period_us = period_ms * 1000;
+  tx_timing_reset(timing);
+}
+
+void tx_timing_reset(CAN_tx_timing& timing) {
+  timing.last_us = 0;
+  timing.intervals = 0;
+  timing.min_us = UINT32_MAX;
+  timing.max_us = 0;
+  timing.sum_us = 0;
+  for (uint8_t i = 0; i < CAN_TX_JITTER_BUCKETS; i++) {
+    timing.histogram[i] = 0;
+  }
+  timing.late = 0;
+  timing.missed = 0;
+}
+
+void tx_timing_record(CAN_tx_timing& timing, int64_t now_us, uint32_t late_tolerance_us) {
+  const int64_t last_us = timing.last_us;
+  timing.last_us = now_us;
+  if (last_us == 0 || now_us <= last_us) {
+    return;
+  }
+
+  const uint32_t interval_us = (now_us - last_us > UINT32_MAX) ? UINT32_MAX : (uint32_t)(now_us - last_us);
+  timing.intervals++;
+  timing.sum_us += interval_us;
+  if (interval_us < timing.min_us) {
+    timing.min_us = interval_us;
+  }
+  if (interval_us > timing.max_us) {
+    timing.max_us = interval_us;
+  }
+
+  const uint32_t jitter_us =
+      (interval_us > timing.period_us) ? interval_us - timing.period_us : timing.period_us - interval_us;
+  uint8_t bucket = 0;
+  while (bucket < CAN_TX_JITTER_BUCKETS - 1 && jitter_us > CAN_TX_JITTER_BUCKET_LIMITS_US[bucket]) {
+    bucket++;
+  }
+  timing.histogram[bucket]++;
+
+  // An interval spanning the middle of the next slot means that slot was skipped
+  const uint32_t skipped = (timing.period_us > 0) ? (interval_us + timing.period_us / 2) / timing.period_us : 1;
+  if (skipped > 1) {
+    timing.missed += skipped - 1;
+  } else if (interval_us > timing.period_us + late_tolerance_us) {
+    timing.late++;
+  }
+}
+
+uint32_t tx_timing_mean_us(const CAN_tx_timing& timing) {
+  if (timing.intervals == 0) {
+    return 0;
+  }
+  return timing.sum_us / timing.intervals;
+}
@@ -0,0 +1,43 @@
+#ifndef _CANTXTIMING_H
+#define _CANTXTIMING_H
+
+#include <stdint.h>
+#include "../../devboard/utils/types.h"
+
+// Interval statistics for cyclic CAN messages. A message is monitored with monitor_can_tx_timing(), after which
+// every hand-over of that ID to the CAN driver is timestamped and compared to the expected period.
+
+/* Upper bounds in microseconds of the jitter histogram buckets, the last bucket holds everything above */
+static constexpr uint32_t CAN_TX_JITTER_BUCKET_LIMITS_US[] = {100, 250, 500, 1000, 2000, 5000};
+static constexpr uint8_t CAN_TX_JITTER_BUCKETS = sizeof(CAN_TX_JITTER_BUCKET_LIMITS_US) / sizeof(uint32_t) + 1;
+
+typedef struct {
+  uint32_t ID;
+  CAN_Interface interface;
+  /** Expected time between two transmissions */
+  uint32_t period_us;
+  /** Time of the previous transmission, 0 until the first one */
+  int64_t last_us;
+  /** Amount of intervals measured, one less than the amount of transmissions */
+  uint32_t intervals;
+  uint32_t min_us;
+  uint32_t max_us;
+  uint64_t sum_us;
+  /** Intervals by absolute deviation from period_us, see CAN_TX_JITTER_BUCKET_LIMITS_US */
+  uint32_t histogram[CAN_TX_JITTER_BUCKETS];
+  /** Intervals more than CAN_TX_LATE_TOLERANCE_US longer than the period, without a slot being skipped */
+  uint32_t late;
+  /** Slots in which the message was not sent at all */
+  uint32_t missed;
+} CAN_tx_timing;
+
+void tx_timing_init(CAN_tx_timing& timing, uint32_t ID, CAN_Interface interface, uint32_t period_ms);
+
+// Clears the statistics but keeps what is being monitored
+void tx_timing_reset(CAN_tx_timing& timing);
+
+void tx_timing_record(CAN_tx_timing& timing, int64_t now_us, uint32_t late_tolerance_us);
+
+uint32_t tx_timing_mean_us(const CAN_tx_timing& timing);
+
+#endif
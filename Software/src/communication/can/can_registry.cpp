@@ -0,0 +1,115 @@
+#include "can_registry.h"
+#include "../../datalayer/datalayer.h"
+#include "../../devboard/utils/logging.h"
+#include "CanReceiver.h"
+#include "CanTxTiming.h"
+
+#include <map>
+
+struct CanReceiverRegistration {
+  CanReceiver* receiver;
+  CAN_Speed speed;
+};
+
+static std::multimap<CAN_Interface, CanReceiverRegistration> can_receivers;
+
+// Precomputed per-interface ID lookup, built from can_receivers when CAN is initialized
+static CanDispatcher can_dispatchers[CANFD_ADDON_MCP2518 + 1];
+
+// Set from the webserver, acted on by the task transmitting so it never races with tx_timing_record()
+static volatile bool can_tx_timing_reset_requested = false;
+// Set when the firmware may transmit again after being held silent, acted on the same way
+static volatile bool can_tx_timing_restart_requested = false;
+
+void register_can_receiver(CanReceiver* receiver, CAN_Interface interface, CAN_Speed speed) {
+  can_receivers.insert({interface, {receiver, speed}});
+  LOG_DEBUG(CAN, "Receiver registered, total: %d\n", (int)can_receivers.size());
+}
+
+bool can_interface_in_use(CAN_Interface interface) {
+  return can_receivers.find(interface) != can_receivers.end();
+}
+
+CAN_Speed can_interface_speed(CAN_Interface interface) {
+  return can_receivers.find(interface)->second.speed;
+}
+
+uint32_t can_interface_speed_bps(CAN_Interface interface) {
+  auto it = can_receivers.find(interface);
+  return it == can_receivers.end() ? 0 : (uint32_t)it->second.speed * 1000;
+}
+
+void build_can_dispatchers() {
+  for (auto& dispatcher : can_dispatchers) {
+    dispatcher.clear();
+  }
+
+  for (auto& [interface, registration] : can_receivers) {
+    if (!can_dispatchers[interface].add_receiver(registration.receiver,
+                                                 registration.receiver->can_ids_of_interest())) {
+      LOG_ERROR(CAN, "Too many CAN receivers on %s\n", getCANInterfaceName(interface));
+    }
+  }
+}
+
+const CanDispatcher& can_dispatcher(CAN_Interface interface) {
+  return can_dispatchers[interface];
+}
+
+void dispatch_can_frame(const CAN_frame& frame, CAN_Interface interface) {
+  can_dispatchers[interface].dispatch(frame);
+  if (interface == CANFD_ADDON_MCP2518) {
+    can_dispatchers[CANFD_NATIVE].dispatch(frame);
+  }
+}
+
+void clear_can_receivers() {
+  can_receivers.clear();
+  build_can_dispatchers();
+}
+
+void monitor_can_tx_timing(const CAN_frame& frame, CAN_Interface interface, unsigned long period_ms) {
+  auto& status = datalayer.system.status;
+  for (uint8_t i = 0; i < status.can_tx_timing_count; i++) {
+    if (status.can_tx_timing[i].ID == frame.ID && status.can_tx_timing[i].interface == interface) {
+      return;
+    }
+  }
+  if (status.can_tx_timing_count >= CAN_TX_TIMING_MAX_MESSAGES) {
+    LOG_WARN(CAN, "TX timing: no room to monitor 0x%lx, raise CAN_TX_TIMING_MAX_MESSAGES\n",
+             (unsigned long)frame.ID);
+    return;
+  }
+  tx_timing_init(status.can_tx_timing[status.can_tx_timing_count], frame.ID, interface, period_ms);
+  status.can_tx_timing_count++;
+}
+
+void reset_can_tx_timing() {
+  can_tx_timing_reset_requested = true;
+}
+
+void restart_can_tx_timing() {
+  can_tx_timing_restart_requested = true;
+}
+
+void record_can_tx_timing(const CAN_frame& frame, CAN_Interface interface, int64_t now_us) {
+  auto& status = datalayer.system.status;
+  if (can_tx_timing_reset_requested) {
+    can_tx_timing_reset_requested = false;
+    for (uint8_t i = 0; i < status.can_tx_timing_count; i++) {
+      tx_timing_reset(status.can_tx_timing[i]);
+    }
+  }
+  if (can_tx_timing_restart_requested) {
+    can_tx_timing_restart_requested = false;
+    for (uint8_t i = 0; i < status.can_tx_timing_count; i++) {
+      status.can_tx_timing[i].last_us = 0;
+    }
+  }
+  for (uint8_t i = 0; i < status.can_tx_timing_count; i++) {
+    if (status.can_tx_timing[i].ID == frame.ID && status.can_tx_timing[i].interface == interface) {
+      tx_timing_record(status.can_tx_timing[i], now_us, CAN_TX_LATE_TOLERANCE_US);
+      return;
+    }
+  }
+}
@@ -0,0 +1,39 @@
+#ifndef _CAN_REGISTRY_H_
+#define _CAN_REGISTRY_H_
+
+#include "../../devboard/utils/types.h"
+#include "CanDispatcher.h"
+#include "comm_can.h"
+
+// What the rest of the firmware registers with comm_can: the receivers of each interface and the cyclic messages
+// whose TX timing is monitored. Free of driver calls, so the host build runs the same code on its virtual buses.
+
+// True if a receiver was registered for the interface
+bool can_interface_in_use(CAN_Interface interface);
+
+// Speed the first receiver registered for the interface asked for, only valid if the interface is in use
+CAN_Speed can_interface_speed(CAN_Interface interface);
+
+// Rebuilds the ID lookup of every interface from the registered receivers. Called when CAN is initialized.
+void build_can_dispatchers();
+
+// The ID lookup of the interface, as of the last build_can_dispatchers()
+const CanDispatcher& can_dispatcher(CAN_Interface interface);
+
+// Hands a received frame to the receivers of its interface that want its ID. Frames of the MCP2518 also go to the
+// receivers of CANFD_NATIVE, as both CAN-FD interfaces are served by it.
+void dispatch_can_frame(const CAN_frame& frame, CAN_Interface interface);
+
+// Forgets every receiver, so the host build can set up another one
+void clear_can_receivers();
+
+// Records that the driver took a frame of a cyclic message at now_us, if its ID is monitored on the interface.
+// Called with the TX mutex held. Requested resets and restarts are applied here, so they never race with the
+// recording.
+void record_can_tx_timing(const CAN_frame& frame, CAN_Interface interface, int64_t now_us);
+
+// Makes the next interval of every monitored message start with its next transmission, keeping the statistics,
+// so a time the firmware was silent on purpose is not counted as missed slots
+void restart_can_tx_timing();
+
+#endif
@@ -0,0 +1,203 @@
+#include "can_replay.h"
+#include <Arduino.h>
+#include "../../datalayer/datalayer.h"
+#include "../../devboard/sdcard/can_log_format.h"
+#include "../../devboard/utils/logging.h"
+#include "CanReplayTiming.h"
+#include "comm_can.h"
+#include "esp_heap_caps.h"
+#include "esp_timer.h"
+
+// Records of the uploaded log, one after the other as encode_can_log_record() writes them
+static uint8_t* replay_records = NULL;
+static size_t replay_size = 0;
+static size_t replay_used = 0;
+static uint32_t replay_frames = 0;
+static uint32_t replay_dropped = 0;
+static CanLogLineParser upload_parser;
+
+static volatile bool replay_running = false;
+static volatile bool replay_uploading = false;
+static volatile bool replay_stop = false;
+
+static CAN_replay_options replay_options;
+static CAN_replay_timing replay_timing;
+
+bool begin_can_replay_upload() {
+  if (replay_running || replay_uploading) {
+    return false;
+  }
+
+  // Short lines take fewer bytes than their records, so the size of the text says little about the records
+  const size_t size = CAN_REPLAY_MAX_SIZE;
+  heap_caps_free(replay_records);
+  replay_records = (uint8_t*)heap_caps_malloc(size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+  if (replay_records == NULL) {
+    replay_records = (uint8_t*)heap_caps_malloc(size, MALLOC_CAP_8BIT);
+  }
+  replay_size = (replay_records != NULL) ? size : 0;
+  replay_used = 0;
+  replay_frames = 0;
+  replay_dropped = 0;
+  upload_parser = CanLogLineParser();
+  replay_uploading = replay_records != NULL;
+  return replay_records != NULL;
+}
+
+static void store_record(const CAN_log_record& record) {
+  if (replay_size - replay_used < can_log_record_size(record.flags)) {
+    replay_dropped++;
+    return;
+  }
+  replay_used += encode_can_log_record(record, replay_records + replay_used);
+  replay_frames++;
+}
+
+void add_can_replay_upload_data(const uint8_t* data, size_t len) {
+  if (!replay_uploading) {
+    return;
+  }
+  upload_parser.feed(data, len, store_record);
+}
+
+bool end_can_replay_upload() {
+  if (!replay_uploading) {
+    return false;
+  }
+  upload_parser.finish(store_record);
+  replay_uploading = false;
+  LOG_INFO(CAN, "Replay log holds %lu frames in %u bytes, %lu dropped, %lu lines skipped\n",
+           (unsigned long)replay_frames, (unsigned)replay_used, (unsigned long)replay_dropped,
+           (unsigned long)upload_parser.lines_skipped());
+  return true;
+}
+
+void abort_can_replay_upload() {
+  if (!replay_uploading) {
+    return;
+  }
+  replay_uploading = false;
+  replay_used = 0;
+  replay_frames = 0;
+  LOG_INFO(CAN, "Replay log upload aborted\n");
+}
+
+uint32_t can_replay_frames() {
+  return replay_frames;
+}
+
+uint32_t can_replay_frames_dropped() {
+  return replay_dropped;
+}
+
+const CAN_replay_timing& can_replay_timing() {
+  return replay_timing;
+}
+
+bool UploadReplaySource::rewind(int64_t& skip_us) {
+  pos = 0;
+  skip_us = (int64_t)replay_options.start_s * 1000000;
+  return replay_used > 0;
+}
+
+bool UploadReplaySource::next(CAN_log_record& record) {
+  const size_t used = decode_can_log_record(replay_records + pos, replay_used - pos, record);
+  pos += used;
+  return used > 0;
+}
+
+bool begin_can_replay(const CAN_replay_options& options) {
+  if (replay_running || replay_uploading) {
+    return false;
+  }
+
+  replay_options = options;
+  // The replay sends through the same path, so only a replay into the receivers can silence the firmware
+  set_can_tx_suppressed(options.suppress_tx && options.target == REPLAY_TO_RECEIVERS);
+  datalayer.system.info.loop_playback = options.loop;
+  replay_timing_reset(replay_timing);
+  replay_stop = false;
+  replay_running = true;
+  return true;
+}
+
+// Hands a frame to the receivers, waiting for room in the queue to the core task rather than dropping it
+static void inject_replayed_frame(CAN_frame& frame, CAN_Interface interface) {
+  frame.timestamp_us = esp_timer_get_time();
+  while (!inject_can_frame(frame, interface) && !replay_stop) {
+    vTaskDelay(1);
+  }
+}
+
+void run_can_replay(ReplaySource& source, const std::function<void(int64_t deadline_us)>& wait_until) {
+  CanReplayPlayer player(replay_options, (CAN_Interface)datalayer.system.info.can_replay_interface, replay_timing);
+  CAN_frame frame = {};
+  CAN_log_record record;
+
+  while (!replay_stop) {
+    int64_t skip_us = 0;
+    if (!source.rewind(skip_us) || !source.next(record)) {
+      break;
+    }
+    // Seeking skips frames without waiting for them
+    const int64_t seek_us = record.timestamp_us + skip_us;
+    bool have_record = true;
+    while (have_record && record.timestamp_us < seek_us) {
+      have_record = source.next(record);
+    }
+    if (!have_record) {
+      break;
+    }
+
+    // Every pass is timed from its own start, the gap between the end of the log and its beginning is not kept
+    player.start_pass(esp_timer_get_time(), record.timestamp_us);
+    do {
+      CAN_Interface interface;
+      int64_t deadline_us;
+      if (!player.route(record, frame, interface, deadline_us)) {
+        continue;
+      }
+
+      wait_until(deadline_us);
+      if (replay_stop) {
+        break;
+      }
+
+      player.done(deadline_us, esp_timer_get_time(), CAN_REPLAY_LATE_TOLERANCE_US);
+      if (replay_options.target == REPLAY_TO_RECEIVERS) {
+        inject_replayed_frame(frame, interface);
+      } else {
+        transmit_can_frame_to_interface(&frame, interface);
+      }
+    } while (!replay_stop && source.next(record));
+
+    LOG_INFO(CAN, "Replay pass done, %lu frames, mean error %lu us, max %lu us, %lu late\n",
+             (unsigned long)replay_timing.frames, (unsigned long)replay_timing_mean_error_us(replay_timing),
+             (unsigned long)replay_timing.max_error_us, (unsigned long)replay_timing.late);
+    if (!datalayer.system.info.loop_playback) {
+      break;
+    }
+  }
+}
+
+void end_can_replay() {
+  set_can_tx_suppressed(false);
+  replay_running = false;
+}
+
+const CAN_replay_options& can_replay_options() {
+  return replay_options;
+}
+
+bool can_replay_stop_requested() {
+  return replay_stop;
+}
+
+void request_can_replay_stop() {
+  datalayer.system.info.loop_playback = false;
+  replay_stop = true;
+}
+
+bool can_replay_running() {
+  return replay_running;
+}
@@ -0,0 +1,92 @@
+#ifndef CAN_REPLAY_H
+#define CAN_REPLAY_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <functional>
+#include "CanReplayPlayer.h"
+
+// Replays a CAN log onto the interface selected in datalayer.system.info.can_replay_interface, or each bus
+// of the log onto an interface of its own, from an uploaded log or the CAN log on the SD card. Uploads are
+// parsed as they arrive into compact binary records (see can_log_format.h), so neither the text nor the
+// parsing is around any more once the replay runs. The SD card log is read while it plays, so its size is
+// not limited by memory. Writing to it is paused until the replay ends, and every pass replays the segments
+// the first one found. Extended IDs and CAN-FD are taken from the log.
+//
+// Instead of being sent, the frames can also be handed to the receivers as if they came from the bus, so a
+// capture drives the charger code while its own transmissions are optionally held back.
+
+// Starts receiving a log, replacing the previous one. Returns false if a replay is running, another log is being
+// uploaded or there is no memory for the records.
+bool begin_can_replay_upload();
+
+// Parses the next chunk of the upload
+void add_can_replay_upload_data(const uint8_t* data, size_t len);
+
+// Parses what is left of the upload. Returns false if no upload was in progress.
+bool end_can_replay_upload();
+
+// Drops an upload the client gave up on before it was complete, so a replay can start again
+void abort_can_replay_upload();
+
+/** Frames held for replay */
+uint32_t can_replay_frames();
+/** Frames of the last upload that did not fit in CAN_REPLAY_MAX_SIZE */
+uint32_t can_replay_frames_dropped();
+
+// Starts the replay task, returns false if it is already running or a log is being uploaded
+bool start_can_replay(const CAN_replay_options& options);
+
+// Ends the replay after the frame being sent
+void stop_can_replay();
+
+bool can_replay_running();
+
+// How far from their deadlines the frames of the current or last replay were sent
+const CAN_replay_timing& can_replay_timing();
+
+// The replay itself, free of the replay task and its timers so the host build runs it too. start_can_replay()
+// is begin_can_replay(), then run_can_replay() and end_can_replay() on the replay task.
+
+// Where the frames of a replay come from
+class ReplaySource {
+ public:
+  virtual ~ReplaySource() = default;
+  // Goes back to the start of the log, less skip_us that are left to skip by timestamp. False if it is empty.
+  virtual bool rewind(int64_t& skip_us) = 0;
+  // Reads the next record, false at the end of the log or when the replay is stopped. The interface of the
+  // record is the bus number of the RXn/TXn column of the text logs.
+  virtual bool next(CAN_log_record& record) = 0;
+};
+
+// The records of the last upload
+class UploadReplaySource : public ReplaySource {
+ public:
+  bool rewind(int64_t& skip_us) override;
+  bool next(CAN_log_record& record) override;
+
+ private:
+  size_t pos = 0;
+};
+
+// Takes the options of a replay and silences the firmware if they ask for it. Returns false if a replay is
+// running or a log is being uploaded.
+bool begin_can_replay(const CAN_replay_options& options);
+
+// Plays the log of source, over and over while datalayer.system.info.loop_playback is set. wait_until returns
+// once the deadline is reached, or earlier when the replay is stopped.
+void run_can_replay(ReplaySource& source, const std::function<void(int64_t deadline_us)>& wait_until);
+
+// Lets the firmware transmit again and another replay start, once the source is gone
+void end_can_replay();
+
+// Options of the current or last replay
+const CAN_replay_options& can_replay_options();
+
+// Set by stop_can_replay() until the next begin_can_replay()
+bool can_replay_stop_requested();
+
+// The part of stop_can_replay() that is not about waking the replay task
+void request_can_replay_stop();
+
+#endif
@@ -0,0 +1,194 @@
+#include <Arduino.h>
+#include "../../datalayer/datalayer.h"
+#include "../../devboard/hal/hal.h"
+#include "../../devboard/sdcard/can_log_format.h"
+#include "../../devboard/sdcard/sdcard.h"
+#include "CanReplayBlocks.h"
+#include "can_replay.h"
+#include "esp_heap_caps.h"
+#include "esp_timer.h"
+
+// The replay task of can_replay.cpp, with its esp_timer waits, and the SD card log as a replay source
+
+static esp_timer_handle_t replay_timer = NULL;
+static TaskHandle_t replay_task_handle = NULL;
+
+static void replay_timer_callback(void*) {
+  xTaskNotifyGive(replay_task_handle);
+}
+
+// Blocks on an esp_timer until CAN_REPLAY_SPIN_US before the deadline, then spins for the rest. The timer
+// wakes the task within tens of microseconds, spinning covers that without keeping the core busy for long gaps.
+static void wait_until(int64_t deadline_us) {
+  int64_t remaining_us;
+  while (!can_replay_stop_requested() &&
+         (remaining_us = deadline_us - esp_timer_get_time()) > CAN_REPLAY_SPIN_US) {
+    esp_timer_stop(replay_timer);
+    esp_timer_start_once(replay_timer, remaining_us - CAN_REPLAY_SPIN_US);
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+  }
+  while (!can_replay_stop_requested() && esp_timer_get_time() < deadline_us) {
+  }
+}
+
+// Streams the CAN log segments of the SD card. A task on the SD card core reads the file into one of two
+// blocks while the replay decodes the other, so the replay never waits for the card unless it falls behind.
+class SdReplaySource : public ReplaySource {
+ public:
+  SdReplaySource()
+      : block_data{alloc_block(), alloc_block()},
+        blocks(block_data[0], block_data[1], CAN_REPLAY_SD_BLOCK_SIZE) {}
+
+  ~SdReplaySource() override {
+    finish_reading();
+    if (reader) {
+      resume_can_writing();
+    }
+    heap_caps_free(block_data[0]);
+    heap_caps_free(block_data[1]);
+  }
+
+  bool rewind(int64_t& skip_us) override {
+    finish_reading();
+    if (!blocks.valid()) {
+      return false;
+    }
+
+    if (reader) {
+      reader->rewind();
+    } else {
+      // Seeking picks the segment holding the start time, the frames before it in that segment are skipped
+      reader = export_can_log(0, UINT32_MAX);
+      const uint32_t from_s = reader->start_s() + can_replay_options().start_s;
+      if (can_replay_options().start_s > 0) {
+        reader = export_can_log(from_s, UINT32_MAX);
+      }
+      first_skip_us = (from_s > reader->start_s()) ? (int64_t)(from_s - reader->start_s()) * 1000000 : 0;
+      // The replayed frames would be logged again, and the next pass would replay them too. Every pass reads
+      // the segments picked here up to their sizes now, and nothing is written to the log until the replay ends.
+      pause_can_writing();
+    }
+    skip_us = first_skip_us;
+    if (reader->size() == 0) {
+      return false;
+    }
+
+    decoder = CanLogBlockDecoder();
+    current = NULL;
+    stop_reading = false;
+    blocks.reset();
+    reading = true;
+    xTaskCreatePinnedToCore(reader_task, "CAN_Replay_SD", 4096, this, TASK_CAN_REPLAY_PRIO, NULL,
+                            esp32hal->SDCARD_CORE());
+    return true;
+  }
+
+  bool next(CAN_log_record& record) override {
+    while (!decoder.next(record)) {
+      if (current != NULL) {
+        blocks.give_back(current);
+        current = NULL;
+      }
+      if (decoder.bad_magic() || !reading) {
+        return false;
+      }
+      // Only waits when the card could not keep up, which shows in the timing error
+      while ((current = blocks.take(pdMS_TO_TICKS(100))) == NULL) {
+        if (can_replay_stop_requested()) {
+          return false;
+        }
+      }
+      if (current->len == 0) {
+        current = NULL;
+        reading = false;  // The reader task is done
+        return false;
+      }
+      decoder.set_block(current->data, current->len);
+    }
+    record.interface = can_log_bus_number(record);
+    return true;
+  }
+
+ private:
+  static uint8_t* alloc_block() {
+    uint8_t* data = (uint8_t*)heap_caps_malloc(CAN_REPLAY_SD_BLOCK_SIZE, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (data == NULL) {
+      data = (uint8_t*)heap_caps_malloc(CAN_REPLAY_SD_BLOCK_SIZE, MALLOC_CAP_8BIT);
+    }
+    return data;
+  }
+
+  static void reader_task(void* param) {
+    SdReplaySource* source = (SdReplaySource*)param;
+    auto read = [source](uint8_t* data, size_t size) -> size_t {
+      return source->stop_reading ? 0 : source->reader->read(data, size);
+    };
+    while (source->blocks.fill(read)) {
+    }
+    vTaskDelete(NULL);
+  }
+
+  // Ends the reader task of the previous pass, if it is still running
+  void finish_reading() {
+    if (!reading) {
+      return;
+    }
+    stop_reading = true;
+    if (current != NULL) {
+      blocks.give_back(current);
+      current = NULL;
+    }
+    // Hand back the blocks it filled until it sends the empty one it stops with
+    CanReplayBlocks::Block* block;
+    while ((block = blocks.take(portMAX_DELAY)) != NULL && block->len > 0) {
+      blocks.give_back(block);
+    }
+    reading = false;
+  }
+
+  uint8_t* block_data[2];
+  CanReplayBlocks blocks;
+  // Picked on the first pass, kept for all others
+  std::shared_ptr<LogSegmentReader> reader;
+  int64_t first_skip_us = 0;
+  CanLogBlockDecoder decoder;
+  CanReplayBlocks::Block* current = NULL;
+  bool reading = false;
+  volatile bool stop_reading = false;
+};
+
+static void can_replay_task(void* param) {
+  ReplaySource* source = (ReplaySource*)param;
+  run_can_replay(*source, wait_until);
+  delete source;
+  end_can_replay();
+  vTaskDelete(NULL);
+}
+
+bool start_can_replay(const CAN_replay_options& options) {
+  if (options.source == REPLAY_FROM_SD && !datalayer.system.info.CAN_SD_logging_active) {
+    return false;
+  }
+  if (replay_timer == NULL) {
+    const esp_timer_create_args_t timer_args = {.callback = replay_timer_callback, .name = "can_replay"};
+    if (esp_timer_create(&timer_args, &replay_timer) != ESP_OK) {
+      return false;
+    }
+  }
+  if (!begin_can_replay(options)) {
+    return false;
+  }
+
+  ReplaySource* source = (options.source == REPLAY_FROM_SD) ? (ReplaySource*)new SdReplaySource()
+                                                           : (ReplaySource*)new UploadReplaySource();
+  xTaskCreatePinnedToCore(can_replay_task, "CAN_Replay", 4096, source, TASK_CAN_REPLAY_PRIO, &replay_task_handle,
+                          esp32hal->CORE_FUNCTION_CORE());
+  return true;
+}
+
+void stop_can_replay() {
+  request_can_replay_stop();
+  if (can_replay_running()) {
+    xTaskNotifyGive(replay_task_handle);  // Ends a wait for a far away frame
+  }
+}
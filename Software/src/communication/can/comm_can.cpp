@@ -2,16 +2,25 @@
 #include "../../lib/pierremolinaro-ACAN2517FD/ACAN2517FD.h"
 #include "../../lib/pierremolinaro-acan-esp32/ACAN_ESP32.h"
 #include "../../lib/pierremolinaro-acan2515/ACAN2515.h"
-#include "CanReceiver.h"
+#include "CanFilters.h"
+#include "CanTxQueue.h"
+#include "can_registry.h"
+#include "usb_can_stream.h"
 #include "comm_can.h"
+#include "src/communication/core_tick.h"
 #include "src/datalayer/datalayer.h"
+#include "src/devboard/sdcard/can_log_format.h"
 #include "src/devboard/sdcard/sdcard.h"
+#include "src/devboard/utils/log_ring.h"
 #include "src/devboard/utils/logging.h"
+#include "src/devboard/utils/spsc_ring.h"
 
 #include <esp_private/periph_ctrl.h>
+#include "esp_timer.h"
+#include "freertos/semphr.h"
 
 #include <algorithm>
-#include <map>
+#include <cstring>
 
 volatile CAN_Configuration can_config = {.battery = CAN_NATIVE,
                                          .inverter = CAN_NATIVE,
@@ -19,25 +28,131 @@ volatile CAN_Configuration can_config = {.battery = CAN_NATIVE,
                                          .charger = CAN_NATIVE,
                                          .shunt = CAN_NATIVE};
 
-struct CanReceiverRegistration {
-  CanReceiver* receiver;
-  CAN_Speed speed;
-};
-
-static std::multimap<CAN_Interface, CanReceiverRegistration> can_receivers;
-
 volatile bool send_ok_native = 0;
 volatile bool send_ok_2515 = 0;
 volatile bool send_ok_2518 = 0;
 
-void map_can_frame_to_variable(CAN_frame* rx_frame, CAN_Interface interface);
+void map_can_frame_to_variable(const CAN_frame& rx_frame, CAN_Interface interface);
+static void start_can_rx_task();
+
+// Taken while transmitting, as both the core task and the CAN replay task send frames
+static SemaphoreHandle_t can_tx_mutex = nullptr;
+// Set while CAN replay feeds the receivers and the firmware should stay silent on the buses
+static volatile bool can_tx_suppressed = false;
+// The core task, which handles received frames and whose cyclic messages are timed
+static TaskHandle_t can_rx_consumer_task = nullptr;
+
+// Hardware acceptance filters for each controller, computed from the dispatchers when CAN is initialized
+static CAN_native_filter_plan native_filter_plan = {true, {}};
+static CAN_mcp2515_filter_plan mcp2515_filter_plan = {true, {0, 0}, false, {}};
+static CAN_mcp2518_filter_plan mcp2518_filter_plan = {true, {}};
+
+// The IDs the controller serving these interfaces has to let through. Empty means every frame.
+static std::vector<CAN_id_range> hardware_filter_ranges(std::initializer_list<CAN_Interface> interfaces) {
+  std::vector<CAN_id_range> ranges;
+  if (!CAN_HARDWARE_FILTERS || datalayer.system.info.CAN_usb_logging_active ||
+      datalayer.system.info.CAN_SD_logging_active || datalayer.system.info.can_logging_active) {
+    return ranges;
+  }
+
+  for (auto interface : interfaces) {
+    auto& dispatcher = can_dispatcher(interface);
+    if (dispatcher.wants_all()) {
+      return {};
+    }
+    ranges.insert(ranges.end(), dispatcher.declared_ranges().begin(), dispatcher.declared_ranges().end());
+  }
+  return ranges;
+}
+
+static void plan_hardware_filters() {
+  native_filter_plan = plan_native_filters(hardware_filter_ranges({CAN_NATIVE}));
+  mcp2515_filter_plan = plan_mcp2515_filters(hardware_filter_ranges({CAN_ADDON_MCP2515}));
+  // Both CAN-FD interfaces are served by the MCP2518
+  mcp2518_filter_plan = plan_mcp2518_filters(hardware_filter_ranges({CANFD_NATIVE, CANFD_ADDON_MCP2518}));
+}
+
+static ACAN_ESP32_Filter native_filter() {
+  auto& filters = native_filter_plan.filters;
+  if (native_filter_plan.accept_all || filters.empty()) {
+    return ACAN_ESP32_Filter::acceptAll();
+  }
+  if (filters[0].ext_ID) {
+    return ACAN_ESP32_Filter::singleExtendedFilter(ACAN_ESP32_Filter::dataAndRemote, filters[0].id,
+                                                   ~filters[0].mask & 0x1FFFFFFF);
+  }
+  if (filters.size() == 1) {
+    return ACAN_ESP32_Filter::singleStandardFilter(ACAN_ESP32_Filter::dataAndRemote, filters[0].id,
+                                                   ~filters[0].mask & 0x7FF);
+  }
+  return ACAN_ESP32_Filter::dualStandardFilter(ACAN_ESP32_Filter::dataAndRemote, filters[0].id,
+                                               ~filters[0].mask & 0x7FF, ACAN_ESP32_Filter::dataAndRemote,
+                                               filters[1].id, ~filters[1].mask & 0x7FF);
+}
+
+static ACAN2515Mask mcp2515_mask(uint32_t mask, bool ext_ID) {
+  return ext_ID ? extended2515Mask(mask) : standard2515Mask(mask, 0, 0);
+}
+
+static uint16_t begin_mcp2515() {
+  auto& plan = mcp2515_filter_plan;
+  if (plan.accept_all || plan.filters.empty()) {
+    return can2515->begin(*settings2515, [] { can2515->isr(); });
+  }
+
+  std::vector<ACAN2515AcceptanceFilter> filters;
+  for (auto& filter : plan.filters) {
+    filters.push_back({plan.ext_ID ? extended2515Filter(filter.id) : standard2515Filter(filter.id, 0, 0), nullptr});
+  }
+  if (filters.size() == 1) {
+    return can2515->begin(*settings2515, [] { can2515->isr(); }, mcp2515_mask(plan.masks[0], plan.ext_ID),
+                          filters.data(), filters.size());
+  }
+  return can2515->begin(*settings2515, [] { can2515->isr(); }, mcp2515_mask(plan.masks[0], plan.ext_ID),
+                        mcp2515_mask(plan.masks[1], plan.ext_ID), filters.data(), filters.size());
+}
+
+// Applies the planned filters to the running MCP2515. Its driver starts a handler task on every begin() that end()
+// does not stop, so the controller is never restarted for this.
+static uint16_t set_mcp2515_filters() {
+  auto& plan = mcp2515_filter_plan;
+  if (plan.accept_all || plan.filters.empty()) {
+    return can2515->setFiltersOnTheFly();
+  }
+
+  std::vector<ACAN2515AcceptanceFilter> filters;
+  for (auto& filter : plan.filters) {
+    filters.push_back({plan.ext_ID ? extended2515Filter(filter.id) : standard2515Filter(filter.id, 0, 0), nullptr});
+  }
+  if (filters.size() == 1) {
+    return can2515->setFiltersOnTheFly(mcp2515_mask(plan.masks[0], plan.ext_ID), filters.data(), filters.size());
+  }
+  return can2515->setFiltersOnTheFly(mcp2515_mask(plan.masks[0], plan.ext_ID), mcp2515_mask(plan.masks[1], plan.ext_ID),
+                                     filters.data(), filters.size());
+}
 
-void register_can_receiver(CanReceiver* receiver, CAN_Interface interface, CAN_Speed speed) {
-  can_receivers.insert({interface, {receiver, speed}});
-  DEBUG_PRINTF("CAN receiver registered, total: %d\n", can_receivers.size());
+static uint32_t begin_mcp2518() {
+  if (mcp2518_filter_plan.accept_all || mcp2518_filter_plan.filters.empty()) {
+    return canfd->begin(*settings2517, [] { canfd->isr(); });
+  }
+
+  ACAN2517FDFilters filters;
+  for (auto& filter : mcp2518_filter_plan.filters) {
+    filters.appendFilter(filter.ext_ID ? kExtended : kStandard, filter.mask, filter.id, nullptr);
+  }
+  return canfd->begin(*settings2517, [] { canfd->isr(); }, filters);
+}
+
+static void log_hardware_filters(CAN_Interface interface, bool accept_all, size_t count) {
+  if (accept_all) {
+    LOG_INFO(CAN, "%s: receiving all CAN IDs\n", getCANInterfaceName(interface));
+  } else {
+    LOG_INFO(CAN, "%s: %d hardware acceptance filters\n", getCANInterfaceName(interface), (int)count);
+  }
 }
 
 uint32_t init_native_can(CAN_Speed speed, gpio_num_t tx_pin, gpio_num_t rx_pin);
+static uint32_t begin_native_can();
 
 ACAN_ESP32_Settings* settingsespcan = nullptr;
 
@@ -62,6 +177,10 @@ bool native_can_initialized = false;
 
 bool init_CAN() {
 
+  build_can_dispatchers();
+  plan_hardware_filters();
+  can_tx_mutex = xSemaphoreCreateMutex();
+
   if (user_selected_can_addon_crystal_frequency_mhz > 0) {
     QUARTZ_FREQUENCY = user_selected_can_addon_crystal_frequency_mhz * 1000000UL;
   } else {
@@ -76,8 +195,7 @@ bool init_CAN() {
     quartz_fd_frequency = ACAN2517FDSettings::OSC_40MHz;
   }
 
-  auto nativeIt = can_receivers.find(CAN_NATIVE);
-  if (nativeIt != can_receivers.end()) {
+  if (can_interface_in_use(CAN_NATIVE)) {
     auto se_pin = esp32hal->CAN_SE_PIN();
     auto tx_pin = esp32hal->CAN_TX_PIN();
     auto rx_pin = esp32hal->CAN_RX_PIN();
@@ -94,37 +212,24 @@ bool init_CAN() {
       return false;
     }
 
-    const uint32_t errorCode = init_native_can(nativeIt->second.speed, tx_pin, rx_pin);
+    const uint32_t errorCode = init_native_can(can_interface_speed(CAN_NATIVE), tx_pin, rx_pin);
     if (errorCode == 0) {
       native_can_initialized = true;
-      logging.println("Native Can ok");
-      logging.print("Bit Rate prescaler: ");
-      logging.println(settingsespcan->mBitRatePrescaler);
-      logging.print("Time Segment 1:     ");
-      logging.println(settingsespcan->mTimeSegment1);
-      logging.print("Time Segment 2:     ");
-      logging.println(settingsespcan->mTimeSegment2);
-      logging.print("RJW:                ");
-      logging.println(settingsespcan->mRJW);
-      logging.print("Triple Sampling:    ");
-      logging.println(settingsespcan->mTripleSampling ? "yes" : "no");
-      logging.print("Actual bit rate:    ");
-      logging.print(settingsespcan->actualBitRate());
-      logging.println(" bit/s");
-      logging.print("Exact bit rate ?    ");
-      logging.println(settingsespcan->exactBitRate() ? "yes" : "no");
-      logging.print("Sample point:       ");
-      logging.print(settingsespcan->samplePointFromBitStart());
-      logging.println("%");
+      LOG_INFO(CAN, "Native Can ok\n");
+      log_hardware_filters(CAN_NATIVE, native_filter_plan.accept_all, native_filter_plan.filters.size());
+      LOG_DEBUG(CAN, "Bit Rate prescaler: %u, Time Segment 1: %u, Time Segment 2: %u, RJW: %u, Triple Sampling: %s\n",
+                settingsespcan->mBitRatePrescaler, settingsespcan->mTimeSegment1, settingsespcan->mTimeSegment2,
+                settingsespcan->mRJW, settingsespcan->mTripleSampling ? "yes" : "no");
+      LOG_DEBUG(CAN, "Actual bit rate: %lu bit/s, exact: %s, sample point: %lu%%\n",
+                (unsigned long)settingsespcan->actualBitRate(), settingsespcan->exactBitRate() ? "yes" : "no",
+                (unsigned long)settingsespcan->samplePointFromBitStart());
     } else {
-      logging.print("Error Native Can: 0x");
-      logging.println(errorCode, HEX);
+      LOG_ERROR(CAN, "Error Native Can: 0x%lX\n", (unsigned long)errorCode);
       return false;
     }
   }
 
-  auto addonIt = can_receivers.find(CAN_ADDON_MCP2515);
-  if (addonIt != can_receivers.end()) {
+  if (can_interface_in_use(CAN_ADDON_MCP2515)) {
     auto cs_pin = esp32hal->MCP2515_CS();
     auto int_pin = esp32hal->MCP2515_INT();
     auto sck_pin = esp32hal->MCP2515_SCK();
@@ -136,7 +241,7 @@ bool init_CAN() {
       return false;
     }
 
-    logging.println("Dual CAN Bus (ESP32+MCP2515) selected");
+    LOG_INFO(CAN, "Dual CAN Bus (ESP32+MCP2515) selected\n");
     gBuffer.initWithSize(25);
 
     if (rst_pin != GPIO_NUM_NC) {
@@ -154,27 +259,24 @@ bool init_CAN() {
     SPI2515.begin(sck_pin, miso_pin, mosi_pin);
 
     // CAN bit rate 250 or 500 kb/s
-    auto bitRate = (int)addonIt->second.speed * 1000UL;
+    auto bitRate = (int)can_interface_speed(CAN_ADDON_MCP2515) * 1000UL;
 
     settings2515 = new ACAN2515Settings(QUARTZ_FREQUENCY, bitRate);
     settings2515->mRequestedMode = ACAN2515Settings::NormalMode;
-    const uint16_t errorCode2515 = can2515->begin(*settings2515, [] { can2515->isr(); });
+    const uint16_t errorCode2515 = begin_mcp2515();
     if (errorCode2515 == 0) {
-      logging.println("Can ok");
+      LOG_INFO(CAN, "Can ok\n");
+      log_hardware_filters(CAN_ADDON_MCP2515, mcp2515_filter_plan.accept_all, mcp2515_filter_plan.filters.size());
     } else {
-      logging.print("Error Can: 0x");
-      logging.println(errorCode2515, HEX);
+      LOG_ERROR(CAN, "Error Can: 0x%X\n", errorCode2515);
       set_event(EVENT_CANMCP2515_INIT_FAILURE, (uint8_t)errorCode2515);
       return false;
     }
   }
 
-  auto fdNativeIt = can_receivers.find(CANFD_NATIVE);
-  auto fdAddonIt = can_receivers.find(CANFD_ADDON_MCP2518);
-
-  if (fdNativeIt != can_receivers.end() || fdAddonIt != can_receivers.end()) {
+  if (can_interface_in_use(CANFD_NATIVE) || can_interface_in_use(CANFD_ADDON_MCP2518)) {
 
-    auto speed = (fdNativeIt != can_receivers.end()) ? fdNativeIt->second.speed : fdAddonIt->second.speed;
+    auto speed = can_interface_speed(can_interface_in_use(CANFD_NATIVE) ? CANFD_NATIVE : CANFD_ADDON_MCP2518);
 
     auto cs_pin = esp32hal->MCP2517_CS();
     auto int_pin = esp32hal->MCP2517_INT();
@@ -188,7 +290,7 @@ bool init_CAN() {
 
     canfd = new ACAN2517FD(cs_pin, SPI2517, int_pin);
 
-    logging.println("CAN FD add-on (ESP32+MCP2517) selected");
+    LOG_INFO(CAN, "CAN FD add-on (ESP32+MCP2517) selected\n");
     SPI2517.begin(sck_pin, sdo_pin, sdi_pin);
     auto bitRate = (int)speed * 1000UL;
     settings2517 = new ACAN2517FDSettings(quartz_fd_frequency, bitRate, DataBitRateFactor::x4);
@@ -197,90 +299,86 @@ bool init_CAN() {
     // ListenOnly / Normal20B / NormalFDs
     settings2517->mRequestedMode = use_canfd_as_can ? ACAN2517FDSettings::Normal20B : ACAN2517FDSettings::NormalFD;
 
-    const uint32_t errorCode2517 = canfd->begin(*settings2517, [] { canfd->isr(); });
+    const uint32_t errorCode2517 = begin_mcp2518();
     canfd->poll();
     if (errorCode2517 == 0) {
-      logging.print("Bit Rate prescaler: ");
-      logging.println(settings2517->mBitRatePrescaler);
-      logging.print("Arbitration Phase segment 1: ");
-      logging.print(settings2517->mArbitrationPhaseSegment1);
-      logging.print(" segment 2: ");
-      logging.print(settings2517->mArbitrationPhaseSegment2);
-      logging.print(" SJW: ");
-      logging.println(settings2517->mArbitrationSJW);
-      logging.print("Actual Arbitration Bit Rate: ");
-      logging.print(settings2517->actualArbitrationBitRate());
-      logging.print(" bit/s");
-      logging.print(" (Exact:");
-      logging.println(settings2517->exactArbitrationBitRate() ? "yes)" : "no)");
-      logging.print("Arbitration Sample point: ");
-      logging.print(settings2517->arbitrationSamplePointFromBitStart());
-      logging.println("%");
+      LOG_DEBUG(CAN, "Bit Rate prescaler: %u, Arbitration Phase segment 1: %u segment 2: %u SJW: %u\n",
+                settings2517->mBitRatePrescaler, settings2517->mArbitrationPhaseSegment1,
+                settings2517->mArbitrationPhaseSegment2, settings2517->mArbitrationSJW);
+      LOG_DEBUG(CAN, "Actual Arbitration Bit Rate: %lu bit/s (Exact: %s), Arbitration Sample point: %lu%%\n",
+                (unsigned long)settings2517->actualArbitrationBitRate(),
+                settings2517->exactArbitrationBitRate() ? "yes" : "no",
+                (unsigned long)settings2517->arbitrationSamplePointFromBitStart());
+      log_hardware_filters(CANFD_ADDON_MCP2518, mcp2518_filter_plan.accept_all, mcp2518_filter_plan.filters.size());
     } else {
-      logging.print("CAN-FD Configuration error 0x");
-      logging.println(errorCode2517, HEX);
+      LOG_ERROR(CAN, "CAN-FD Configuration error 0x%lX\n", (unsigned long)errorCode2517);
       set_event(EVENT_CANMCP2517FD_INIT_FAILURE, (uint8_t)errorCode2517);
       return false;
     }
   }
 
+  start_can_rx_task();
+
   return true;
 }
 
-void transmit_can_frame_to_interface(const CAN_frame* tx_frame, CAN_Interface interface) {
-  print_can_frame(*tx_frame, interface, frameDirection(MSG_TX));
+static CANMessage to_can_message(const CAN_frame& frame) {
+  CANMessage message;
+  message.id = frame.ID;
+  message.ext = frame.ext_ID;
+  message.rtr = false;
+  message.len = std::min<uint8_t>(frame.DLC, 8);
+  memcpy(message.data, frame.data.u8, sizeof(message.data));
+  return message;
+}
 
-  if (datalayer.system.info.CAN_SD_logging_active) {
-    add_can_frame_to_buffer(*tx_frame, frameDirection(MSG_TX));
-  }
+static CANFDMessage to_canfd_message(const CAN_frame& frame) {
+  CANFDMessage message;
+  message.type = frame.FD ? CANFDMessage::CANFD_WITH_BIT_RATE_SWITCH : CANFDMessage::CAN_DATA;
+  message.id = frame.ID;
+  message.ext = frame.ext_ID;
+  message.len = std::min<uint8_t>(frame.DLC, sizeof(message.data));
+  memcpy(message.data, frame.data.u8, message.len);
+  return message;
+}
+
+// Converts up to CAN_TX_BATCH_MAX_FRAMES frames on the stack and hands them to the driver in one go.
+// Returns how many frames, from the start of the batch, the driver took.
+static uint8_t send_can_batch(std::span<const CAN_frame> frames, CAN_Interface interface) {
+  const uint8_t count = frames.size();
+  uint8_t sent = 0;
 
   switch (interface) {
     case CAN_NATIVE: {
-
-      CANMessage frame;
-      frame.id = tx_frame->ID;
-      frame.ext = tx_frame->ext_ID;
-      frame.len = tx_frame->DLC;
-      for (uint8_t i = 0; i < frame.len; i++) {
-        frame.data[i] = tx_frame->data.u8[i];
+      CANMessage messages[CAN_TX_BATCH_MAX_FRAMES];
+      for (uint8_t i = 0; i < count; i++) {
+        messages[i] = to_can_message(frames[i]);
       }
-      send_ok_native = ACAN_ESP32::can.tryToSend(frame);
-
+      sent = ACAN_ESP32::can.tryToSendBatch(messages, count);
+      send_ok_native = sent == count;
       if (!send_ok_native) {
         datalayer.system.info.can_native_send_fail = true;
       }
     } break;
     case CAN_ADDON_MCP2515: {
-      //Struct with ACAN2515 library format, needed to use the MCP2515 library for CAN2
-      CANMessage MCP2515Frame;
-      MCP2515Frame.id = tx_frame->ID;
-      MCP2515Frame.ext = tx_frame->ext_ID;
-      MCP2515Frame.len = tx_frame->DLC;
-      MCP2515Frame.rtr = false;
-      for (uint8_t i = 0; i < MCP2515Frame.len; i++) {
-        MCP2515Frame.data[i] = tx_frame->data.u8[i];
+      CANMessage messages[CAN_TX_BATCH_MAX_FRAMES];
+      for (uint8_t i = 0; i < count; i++) {
+        messages[i] = to_can_message(frames[i]);
       }
-
-      send_ok_2515 = can2515->tryToSend(MCP2515Frame);
+      sent = can2515->tryToSendBatch(messages, count);
+      send_ok_2515 = sent == count;
       if (!send_ok_2515) {
         datalayer.system.info.can_2515_send_fail = true;
       }
     } break;
     case CANFD_NATIVE:
     case CANFD_ADDON_MCP2518: {
-      CANFDMessage MCP2518Frame;
-      if (tx_frame->FD) {
-        MCP2518Frame.type = CANFDMessage::CANFD_WITH_BIT_RATE_SWITCH;
-      } else {  //Classic CAN message
-        MCP2518Frame.type = CANFDMessage::CAN_DATA;
+      CANFDMessage messages[CAN_TX_BATCH_MAX_FRAMES];
+      for (uint8_t i = 0; i < count; i++) {
+        messages[i] = to_canfd_message(frames[i]);
       }
-      MCP2518Frame.id = tx_frame->ID;
-      MCP2518Frame.ext = tx_frame->ext_ID;
-      MCP2518Frame.len = tx_frame->DLC;
-      for (uint8_t i = 0; i < MCP2518Frame.len; i++) {
-        MCP2518Frame.data[i] = tx_frame->data.u8[i];
-      }
-      send_ok_2518 = canfd->tryToSend(MCP2518Frame);
+      sent = canfd->tryToSendBatch(messages, count);
+      send_ok_2518 = sent == count;
       if (!send_ok_2518) {
         datalayer.system.info.can_2518_send_fail = true;
       }
@@ -289,50 +387,342 @@ void transmit_can_frame_to_interface(const CAN_frame* tx_frame, CAN_Interface in
       // Invalid interface sent with function call. TODO: Raise event that coders messed up
       break;
   }
+  return sent;
+}
+
+// Frames a driver could not take are kept here, one queue per CAN controller, and retried every core_loop tick
+static CanTxQueue can_native_tx_queue(datalayer.system.status.can_native_tx_queue);
+static CanTxQueue can_2515_tx_queue(datalayer.system.status.can_2515_tx_queue);
+static CanTxQueue can_2518_tx_queue(datalayer.system.status.can_2518_tx_queue);
+
+static CanTxQueue* tx_queue_for(CAN_Interface interface) {
+  switch (interface) {
+    case CAN_NATIVE:
+      return &can_native_tx_queue;
+    case CAN_ADDON_MCP2515:
+      return &can_2515_tx_queue;
+    case CANFD_NATIVE:
+    case CANFD_ADDON_MCP2518:
+      return &can_2518_tx_queue;
+    default:
+      return nullptr;
+  }
+}
+
+// Records when the driver took frames of cyclic messages, the ones monitored with monitor_can_tx_timing()
+static void record_sent_frames(std::span<const CAN_frame> sent, CAN_Interface interface) {
+  const int64_t now_us = esp_timer_get_time();
+  for (const CAN_frame& frame : sent) {
+    record_can_tx_timing(frame, interface, now_us);
+  }
+}
+
+// Sends queued frames in priority order until the queue is empty or the driver is full
+static void flush_tx_queue(CanTxQueue& queue, CAN_Interface interface) {
+  while (!queue.empty()) {
+    const std::span<const CAN_frame> batch = queue.front(CAN_TX_BATCH_MAX_FRAMES);
+    const uint8_t sent = send_can_batch(batch, interface);
+    for (uint8_t i = 0; i < sent; i++) {
+      if (queue.cyclic(i)) {
+        record_sent_frames(batch.subspan(i, 1), interface);
+      }
+    }
+    queue.pop(sent);
+    if (sent < batch.size()) {
+      return;
+    }
+  }
+}
+
+// Frames are timed once the driver took them. A frame replaced in or dropped from the queue is never timed.
+static void send_or_queue(std::span<const CAN_frame> frames, CAN_Interface interface) {
+  CanTxQueue* queue = tx_queue_for(interface);
+  if (queue == nullptr) {
+    return;  // Invalid interface
+  }
+  // Only the cyclic tasks of the core task send cyclic messages. Frames sent from elsewhere, like a replay or a
+  // multi-frame transfer, can share their IDs, but are neither coalesced nor timed.
+  const bool cyclic = in_cyclic_task() && xTaskGetCurrentTaskHandle() == can_rx_consumer_task;
+
+  if (!queue->empty()) {
+    // Let the new frames compete with the waiting ones
+    for (const CAN_frame& frame : frames) {
+      queue->push(frame, cyclic);
+    }
+    flush_tx_queue(*queue, interface);
+    return;
+  }
+
+  for (size_t start = 0; start < frames.size();) {
+    const std::span<const CAN_frame> batch =
+        frames.subspan(start, std::min<size_t>(frames.size() - start, CAN_TX_BATCH_MAX_FRAMES));
+    const uint8_t sent = send_can_batch(batch, interface);
+    if (cyclic) {
+      record_sent_frames(batch.first(sent), interface);
+    }
+    start += sent;
+    if (sent < batch.size()) {
+      for (const CAN_frame& frame : frames.subspan(start)) {
+        queue->push(frame, cyclic);
+      }
+      return;
+    }
+  }
+}
+
+void retry_can_tx_queues() {
+  if (can_native_tx_queue.empty() && can_2515_tx_queue.empty() && can_2518_tx_queue.empty()) {
+    return;
+  }
+  if (can_tx_mutex != nullptr) {
+    xSemaphoreTake(can_tx_mutex, portMAX_DELAY);
+  }
+  flush_tx_queue(can_native_tx_queue, CAN_NATIVE);
+  flush_tx_queue(can_2515_tx_queue, CAN_ADDON_MCP2515);
+  flush_tx_queue(can_2518_tx_queue, CANFD_ADDON_MCP2518);
+  if (can_tx_mutex != nullptr) {
+    xSemaphoreGive(can_tx_mutex);
+  }
+}
+
+void transmit_can_frames(std::span<const CAN_frame> frames, CAN_Interface interface) {
+  for (const CAN_frame& frame : frames) {
+    print_can_frame(frame, interface, frameDirection(MSG_TX));
+
+    if (datalayer.system.info.CAN_SD_logging_active) {
+      add_can_frame_to_buffer(frame, interface, frameDirection(MSG_TX));
+    }
+  }
+
+  if (can_tx_suppressed) {
+    return;
+  }
+
+  if (can_tx_mutex != nullptr) {
+    xSemaphoreTake(can_tx_mutex, portMAX_DELAY);
+  }
+  send_or_queue(frames, interface);
+  if (can_tx_mutex != nullptr) {
+    xSemaphoreGive(can_tx_mutex);
+  }
+}
+
+void transmit_can_frame_to_interface(const CAN_frame* tx_frame, CAN_Interface interface) {
+  transmit_can_frames(std::span<const CAN_frame>(tx_frame, 1), interface);
 }
 
 // Receive functions
-void receive_can() {
-  if (native_can_initialized) {
-    receive_frame_can_native();  // Receive CAN messages from native CAN port
+
+// Returns true if another frame may be handled within the current tick's budget
+static bool can_rx_budget_left(uint16_t count, int64_t deadline_us) {
+  if (count < CAN_RX_BATCH_MAX_FRAMES && esp_timer_get_time() < deadline_us) {
+    return true;
   }
+  datalayer.system.status.can_rx_budget_exhausted++;
+  return false;
+}
 
-  if (can2515) {
-    receive_frame_can_addon();  // Receive CAN messages on add-on MCP2515 chip
+// The CAN RX task moves frames from the drivers into this queue, the core task handles them in receive_can()
+typedef struct {
+  CAN_frame frame;
+  CAN_Interface interface;
+} CAN_rx_entry;
+
+static SpscRing<CAN_rx_entry, CAN_RX_QUEUE_SIZE> can_rx_queue;
+// Frames injected as if received, by CAN replay. A queue of its own as each queue has a single producer.
+static SpscRing<CAN_rx_entry, CAN_RX_QUEUE_SIZE> can_inject_queue;
+static TaskHandle_t can_rx_task_handle = nullptr;
+
+static void queue_rx_frame(const CAN_frame& rx_frame, CAN_Interface interface) {
+  if (!can_rx_queue.push({rx_frame, interface})) {
+    datalayer.system.status.can_rx_queue_overruns++;
+  }
+}
+
+// Set when the web CAN logger is switched on or off, for the CAN RX task to open or restore the hardware filters
+static volatile bool can_filters_changed = false;
+
+// Applies the hardware filters to the controllers whose filters changed, restarting those that cannot take them on
+// the fly. Runs on the CAN RX task so no driver is read during the
+// restart, with the TX mutex held so nothing is sent either.
+static void update_hardware_filters() {
+  const bool native_accept_all = native_filter_plan.accept_all;
+  const bool mcp2515_accept_all = mcp2515_filter_plan.accept_all;
+  const bool mcp2518_accept_all = mcp2518_filter_plan.accept_all;
+  plan_hardware_filters();
+
+  if (can_tx_mutex != nullptr) {
+    xSemaphoreTake(can_tx_mutex, portMAX_DELAY);
+  }
+  if (native_can_initialized && native_filter_plan.accept_all != native_accept_all) {
+    ACAN_ESP32::can.end();
+    begin_native_can();
+    log_hardware_filters(CAN_NATIVE, native_filter_plan.accept_all, native_filter_plan.filters.size());
+  }
+  if (can2515 && mcp2515_filter_plan.accept_all != mcp2515_accept_all) {
+    set_mcp2515_filters();
+    log_hardware_filters(CAN_ADDON_MCP2515, mcp2515_filter_plan.accept_all, mcp2515_filter_plan.filters.size());
+  }
+  if (canfd && mcp2518_filter_plan.accept_all != mcp2518_accept_all) {
+    canfd->end();
+    begin_mcp2518();
+    log_hardware_filters(CANFD_ADDON_MCP2518, mcp2518_filter_plan.accept_all, mcp2518_filter_plan.filters.size());
+  }
+  if (can_tx_mutex != nullptr) {
+    xSemaphoreGive(can_tx_mutex);
+  }
+}
+
+static void can_rx_task(void*) {
+  while (true) {
+    // Woken by the drivers as soon as a frame arrived, the timeout is a fallback in case a notification is missed
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(1));
+
+    if (can_filters_changed) {
+      can_filters_changed = false;
+      update_hardware_filters();
+    }
+
+    uint16_t frames = 0;
+    if (native_can_initialized) {
+      frames += receive_frame_can_native();  // Receive CAN messages from native CAN port
+    }
+
+    if (can2515) {
+      frames += receive_frame_can_addon();  // Receive CAN messages on add-on MCP2515 chip
+    }
+
+    if (canfd) {
+      frames += receive_frame_canfd_addon();  // Receive CAN-FD messages.
+    }
+
+    if (frames > 0 && can_rx_consumer_task != nullptr) {
+      xTaskNotifyGive(can_rx_consumer_task);
+    }
+  }
+}
+
+static void start_can_rx_task() {
+  if (can_rx_task_handle == nullptr) {
+    xTaskCreatePinnedToCore(can_rx_task, "can_rx", 3072, nullptr, TASK_CAN_RX_PRIO, &can_rx_task_handle,
+                            esp32hal->CORE_FUNCTION_CORE());
   }
 
+  ACAN_ESP32::can.mReceiveNotifyTask = can_rx_task_handle;
+  if (can2515) {
+    can2515->mReceiveNotifyTask = can_rx_task_handle;
+  }
   if (canfd) {
-    receive_frame_canfd_addon();  // Receive CAN-FD messages.
+    canfd->mReceiveNotifyTask = can_rx_task_handle;
   }
 }
 
-void receive_frame_can_native() {  // This section checks if we have a complete CAN message incoming on native CAN port
-  CANMessage frame;
+bool inject_can_frame(const CAN_frame& frame, CAN_Interface interface) {
+  if (!can_inject_queue.push({frame, interface})) {
+    return false;
+  }
+  if (can_rx_consumer_task != nullptr) {
+    xTaskNotifyGive(can_rx_consumer_task);
+  }
+  return true;
+}
 
-  if (ACAN_ESP32::can.available()) {
-    if (ACAN_ESP32::can.receive(frame)) {
+void set_web_can_logging(bool active) {
+  if (datalayer.system.info.can_logging_active != active) {
+    datalayer.system.info.can_logging_active = active;
+    can_filters_changed = true;
+  }
+}
 
-      CAN_frame rx_frame;
-      rx_frame.ID = frame.id;
-      rx_frame.ext_ID = frame.ext;
-      rx_frame.DLC = frame.len;
-      for (uint8_t i = 0; i < frame.len && i < 8; i++) {
-        rx_frame.data.u8[i] = frame.data[i];
-      }
+void set_can_tx_suppressed(bool suppressed) {
+  if (can_tx_suppressed && !suppressed) {
+    restart_can_tx_timing();
+  }
+  can_tx_suppressed = suppressed;
+}
+
+void set_can_rx_consumer(TaskHandle_t task) {
+  can_rx_consumer_task = task;
+}
+
+bool receive_can() {
+  // Bounded by a time budget so a flooded bus cannot stall core_loop, the rest is handled on the next call
+  const int64_t deadline_us = esp_timer_get_time() + CAN_RX_BATCH_MAX_US;
+  uint16_t frames = 0;
+  bool frames_left = false;
+  CAN_rx_entry entry;
+
+  while (!can_rx_queue.empty() || !can_inject_queue.empty()) {
+    if (!can_rx_budget_left(frames, deadline_us)) {
+      frames_left = true;
+      break;
+    }
+    if (!can_rx_queue.pop(entry)) {
+      can_inject_queue.pop(entry);
+    }
+    frames++;
+
+    const uint32_t latency_us = (uint32_t)(esp_timer_get_time() - entry.frame.timestamp_us);
+    if (latency_us > datalayer.system.status.can_rx_latency_max_us) {
+      datalayer.system.status.can_rx_latency_max_us = latency_us;
+    }
+
+    //message incoming, pass it on to the handler
+    map_can_frame_to_variable(entry.frame, entry.interface);
+  }
 
-      //message incoming, pass it on to the handler
-      map_can_frame_to_variable(&rx_frame, CAN_NATIVE);
+  if (frames > datalayer.system.status.can_rx_batch_max) {
+    datalayer.system.status.can_rx_batch_max = frames;
+  }
+  return frames_left;
+}
+
+uint16_t receive_frame_can_native() {  // Drain complete CAN messages from native CAN port
+  CANMessage frame;
+  uint16_t count = 0;
+
+  // Peak count exceeds the buffer size once the driver had to drop a frame
+  if (ACAN_ESP32::can.driverReceiveBufferPeakCount() > ACAN_ESP32::can.driverReceiveBufferSize()) {
+    datalayer.system.status.can_native_rx_overruns++;
+    ACAN_ESP32::can.resetDriverReceiveBufferPeakCount();
+  }
+
+  while (ACAN_ESP32::can.receive(frame)) {
+    count++;
+
+    CAN_frame rx_frame = {};
+    rx_frame.FD = false;
+    rx_frame.timestamp_us = esp_timer_get_time();
+    rx_frame.ID = frame.id;
+    rx_frame.ext_ID = frame.ext;
+    rx_frame.DLC = frame.len;
+    for (uint8_t i = 0; i < frame.len && i < 8; i++) {
+      rx_frame.data.u8[i] = frame.data[i];
     }
+
+    queue_rx_frame(rx_frame, CAN_NATIVE);
   }
+
+  return count;
 }
 
-void receive_frame_can_addon() {  // This section checks if we have a complete CAN message incoming on add-on CAN port
-  CAN_frame rx_frame;             // Struct with our CAN format
-  CANMessage MCP2515frame;        // Struct with ACAN2515 library format, needed to use the MCP2515 library
+uint16_t receive_frame_can_addon() {  // Drain complete CAN messages from add-on CAN port
+  CANMessage MCP2515frame;  // Struct with ACAN2515 library format, needed to use the MCP2515 library
+  uint16_t count = 0;
+
+  // Peak count exceeds the buffer size once the driver had to drop a frame
+  if (can2515->receiveBufferPeakCount() > can2515->receiveBufferSize()) {
+    datalayer.system.status.can_2515_rx_overruns++;
+    can2515->resetReceiveBufferPeakCount();
+  }
 
-  if (can2515->available()) {
+  while (can2515->available()) {
     can2515->receive(MCP2515frame);
+    count++;
 
+    CAN_frame rx_frame = {};  // Struct with our CAN format
+    rx_frame.FD = false;
+    rx_frame.timestamp_us = esp_timer_get_time();
     rx_frame.ID = MCP2515frame.id;
     rx_frame.ext_ID = MCP2515frame.ext;
     rx_frame.DLC = MCP2515frame.len;
@@ -340,54 +730,52 @@ void receive_frame_can_addon() {  // This section checks if we have a complete C
       rx_frame.data.u8[i] = MCP2515frame.data[i];
     }
 
-    //message incoming, pass it on to the handler
-    map_can_frame_to_variable(&rx_frame, CAN_ADDON_MCP2515);
+    queue_rx_frame(rx_frame, CAN_ADDON_MCP2515);
   }
+
+  return count;
 }
 
-void receive_frame_canfd_addon() {  // This section checks if we have a complete CAN-FD message incoming
+uint16_t receive_frame_canfd_addon() {  // Drain complete CAN-FD messages
   CANFDMessage MCP2518frame;
-  int count = 0;
-  while (canfd->available() && count++ < 16) {
+  uint16_t count = 0;
+
+  if (canfd->driverReceiveBufferPeakCount() > canfd->driverReceiveBufferSize()) {
+    datalayer.system.status.can_2518_rx_overruns++;
+    canfd->resetDriverReceiveBufferPeakCount();
+  }
+  if (canfd->hardwareReceiveBufferOverflowCount() > 0) {
+    datalayer.system.status.can_2518_rx_overruns += canfd->hardwareReceiveBufferOverflowCount();
+    canfd->resetHardwareReceiveBufferOverflowCount();
+  }
+
+  while (canfd->available()) {
     canfd->receive(MCP2518frame);
+    count++;
 
-    CAN_frame rx_frame;
+    CAN_frame rx_frame = {};
+    rx_frame.FD = MCP2518frame.type == CANFDMessage::CANFD_WITH_BIT_RATE_SWITCH ||
+                  MCP2518frame.type == CANFDMessage::CANFD_NO_BIT_RATE_SWITCH;
+    rx_frame.timestamp_us = esp_timer_get_time();
     rx_frame.ID = MCP2518frame.id;
     rx_frame.ext_ID = MCP2518frame.ext;
     rx_frame.DLC = MCP2518frame.len;
     memcpy(rx_frame.data.u8, MCP2518frame.data, std::min(rx_frame.DLC, (uint8_t)64));
-    //message incoming, pass it on to the handler
-    map_can_frame_to_variable(&rx_frame, CANFD_ADDON_MCP2518);
-    map_can_frame_to_variable(&rx_frame, CANFD_NATIVE);
+    queue_rx_frame(rx_frame, CANFD_ADDON_MCP2518);
   }
+
+  return count;
 }
 
 // Support functions
-void print_can_frame(CAN_frame frame, CAN_Interface interface, frameDirection msgDir) {
+int64_t can_frame_log_time_us(const CAN_frame& frame) {
+  return frame.timestamp_us != 0 ? frame.timestamp_us : esp_timer_get_time();
+}
+
+void print_can_frame(const CAN_frame& frame, CAN_Interface interface, frameDirection msgDir) {
 
   if (datalayer.system.info.CAN_usb_logging_active) {
-    uint8_t i = 0;
-    Serial.print("(");
-    Serial.print(millis() / 1000.0);
-    if (msgDir == MSG_RX) {
-      Serial.print(") RX");
-      Serial.print((int)(interface * 2));
-    } else {
-      Serial.print(") TX");
-      Serial.print((int)(interface * 2) + 1);
-    }
-    Serial.print(" ");
-    Serial.print(frame.ID, HEX);
-    Serial.print(" [");
-    Serial.print(frame.DLC);
-    Serial.print("] ");
-    for (i = 0; i < frame.DLC; i++) {
-      Serial.print(frame.data.u8[i] < 16 ? "0" : "");
-      Serial.print(frame.data.u8[i], HEX);
-      if (i < frame.DLC - 1)
-        Serial.print(" ");
-    }
-    Serial.println("");
+    add_can_frame_to_usb_stream(frame, interface, msgDir);
   }
 
   if (datalayer.system.info.can_logging_active) {  // If user clicked on CAN Logging page in webserver, start recording
@@ -395,67 +783,57 @@ void print_can_frame(CAN_frame frame, CAN_Interface interface, frameDirection ms
   }
 }
 
-void map_can_frame_to_variable(CAN_frame* rx_frame, CAN_Interface interface) {
-  if (interface !=
-      CANFD_NATIVE) {  //Avoid printing twice due to receive_frame_canfd_addon sending to both FD interfaces
-    //TODO: This check can be removed later when refactored to use inline functions for logging
-    print_can_frame(*rx_frame, interface, frameDirection(MSG_RX));
-  }
+void map_can_frame_to_variable(const CAN_frame& rx_frame, CAN_Interface interface) {
+  print_can_frame(rx_frame, interface, frameDirection(MSG_RX));
 
   if (datalayer.system.info.CAN_SD_logging_active) {
-    if (interface !=
-        CANFD_NATIVE) {  //Avoid printing twice due to receive_frame_canfd_addon sending to both FD interfaces
-      //TODO: This check can be removed later when refactored to use inline functions for logging
-      add_can_frame_to_buffer(*rx_frame, frameDirection(MSG_RX));
-    }
+    add_can_frame_to_buffer(rx_frame, interface, frameDirection(MSG_RX));
   }
 
-  // Send the frame to all the receivers registered for this interface.
-  auto receivers = can_receivers.equal_range(interface);
-
-  for (auto it = receivers.first; it != receivers.second; ++it) {
-    auto& receiver = it->second;
-    receiver.receiver->receive_can_frame(rx_frame);
-  }
+  // Send the frame to the receivers registered for this interface that want this ID
+  dispatch_can_frame(rx_frame, interface);
 }
 
-void dump_can_frame(CAN_frame& frame, CAN_Interface interface, frameDirection msgDir) {
-  char* message_string = datalayer.system.info.logged_can_messages;
-  int offset = datalayer.system.info.logged_can_messages_offset;  // Keeps track of the current position in the buffer
-  size_t message_string_size = sizeof(datalayer.system.info.logged_can_messages);
+// Frames as binary records in the SD card log format, written from every task that sends or receives
+static LogRing<WEB_CAN_LOG_BUFFER_SIZE> web_can_log;
+// Where the CAN logger page starts reading, moved forward to clear the log
+static std::atomic<uint32_t> web_can_log_start{0};
 
-  if (offset + 128 > sizeof(datalayer.system.info.logged_can_messages)) {
-    // Not enough space, reset and start from the beginning
-    offset = 0;
-  }
-  unsigned long currentTime = millis();
-  // Add timestamp
-  offset += snprintf(message_string + offset, message_string_size - offset, "(%lu.%03lu) ", currentTime / 1000,
-                     currentTime % 1000);
+void dump_can_frame(const CAN_frame& frame, CAN_Interface interface, frameDirection msgDir) {
+  uint8_t record[CAN_LOG_RECORD_MAX_SIZE];
+  web_can_log.write(record, encode_can_log_record(frame, msgDir, interface, can_frame_log_time_us(frame), record));
+}
 
-  // Add direction. Multiplying the interface by two ensures that SavvyCAN puts TX and RX in a different bus.
-  offset += snprintf(message_string + offset, message_string_size - offset, "%s%d ", (msgDir == MSG_RX) ? "RX" : "TX",
-                     (int)(interface * 2) + (msgDir == MSG_RX ? 0 : 1));
+void clear_web_can_log() {
+  web_can_log_start = web_can_log.newest();
+}
 
-  // Add ID and DLC
-  offset += snprintf(message_string + offset, message_string_size - offset, "%X [%u] ", frame.ID, frame.DLC);
+bool web_can_log_empty() {
+  return web_can_log.newest() == web_can_log_start;
+}
 
-  // Add data bytes
-  for (uint8_t i = 0; i < frame.DLC; i++) {
-    if (i < frame.DLC - 1) {
-      offset += snprintf(message_string + offset, message_string_size - offset, "%02X ", frame.data.u8[i]);
-    } else {
-      offset += snprintf(message_string + offset, message_string_size - offset, "%02X", frame.data.u8[i]);
+void for_each_web_can_log_line(const std::function<bool(const char* line, size_t len)>& visit) {
+  uint8_t buffer[CAN_LOG_RECORD_MAX_SIZE];
+  char line[CAN_LOG_LINE_MAX_SIZE];
+  uint32_t cursor = web_can_log_start;
+  size_t len;
+  while ((len = web_can_log.read(cursor, buffer, sizeof(buffer))) > 0) {
+    CAN_log_record record;
+    if (decode_can_log_record(buffer, len, record) == 0) {
+      continue;
+    }
+    if (!visit(line, format_can_log_line(record, line, sizeof(line)))) {
+      return;
     }
   }
-  // Add linebreak
-  offset += snprintf(message_string + offset, message_string_size - offset, "\n");
-
-  datalayer.system.info.logged_can_messages_offset = offset;  // Update offset in buffer
 }
 
 void stop_can() {
-  if (can_receivers.find(CAN_NATIVE) != can_receivers.end()) {
+  if (can_rx_task_handle != nullptr) {
+    vTaskSuspend(can_rx_task_handle);
+  }
+
+  if (can_interface_in_use(CAN_NATIVE)) {
     ACAN_ESP32::can.end();
   }
 
@@ -471,18 +849,22 @@ void stop_can() {
 }
 
 void restart_can() {
-  if (can_receivers.find(CAN_NATIVE) != can_receivers.end()) {
-    ACAN_ESP32::can.begin(*settingsespcan);
+  if (can_interface_in_use(CAN_NATIVE)) {
+    ACAN_ESP32::can.begin(*settingsespcan, native_filter());
   }
 
   if (can2515) {
     SPI2515.begin();
-    can2515->begin(*settings2515, [] { can2515->isr(); });
+    begin_mcp2515();
   }
 
   if (canfd) {
     SPI2517.begin();
-    canfd->begin(*settings2517, [] { can2515->isr(); });
+    begin_mcp2518();
+  }
+
+  if (can_rx_task_handle != nullptr) {
+    vTaskResume(can_rx_task_handle);
   }
 }
 
@@ -490,11 +872,6 @@ void restart_can() {
 // This can be called repeatedly to change the interface speed (as some
 // batteries require).
 uint32_t init_native_can(CAN_Speed speed, gpio_num_t tx_pin, gpio_num_t rx_pin) {
-
-  // TODO: check whether this is necessary? It seems to help with
-  // reinitialization.
-  periph_module_reset(PERIPH_TWAI_MODULE);
-
   if (settingsespcan != nullptr) {
     delete settingsespcan;
   }
@@ -505,8 +882,16 @@ uint32_t init_native_can(CAN_Speed speed, gpio_num_t tx_pin, gpio_num_t rx_pin)
   settingsespcan->mTxPin = tx_pin;
   settingsespcan->mRxPin = rx_pin;
 
-  // (Re)start the CAN interface
-  return ACAN_ESP32::can.begin(*settingsespcan);
+  return begin_native_can();
+}
+
+// (Re)starts the native CAN interface with the current settings and hardware filters
+static uint32_t begin_native_can() {
+  // TODO: check whether this is necessary? It seems to help with
+  // reinitialization.
+  periph_module_reset(PERIPH_TWAI_MODULE);
+
+  return ACAN_ESP32::can.begin(*settingsespcan, native_filter());
 }
 
 // Change the speed of the given CAN interface. Returns true if successful.
@@ -515,8 +900,7 @@ bool change_can_speed(CAN_Interface interface, CAN_Speed speed) {
     // Reinitialize the native CAN interface with the new speed
     const uint32_t errorCode = init_native_can(speed, settingsespcan->mTxPin, settingsespcan->mRxPin);
     if (errorCode != 0) {
-      logging.print("Error Native Can: 0x");
-      logging.println(errorCode, HEX);
+      LOG_ERROR(CAN, "Error Native Can: 0x%lX\n", (unsigned long)errorCode);
       return false;
     }
     return true;
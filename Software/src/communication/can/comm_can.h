@@ -1,15 +1,53 @@
 #ifndef _COMM_CAN_H_
 #define _COMM_CAN_H_
 
+#include <functional>
+#include <span>
 #include "../../devboard/utils/types.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
 
 extern bool use_canfd_as_can;
 extern uint8_t user_selected_can_addon_crystal_frequency_mhz;
 extern uint8_t user_selected_canfd_addon_crystal_frequency_mhz;
 
-void dump_can_frame(CAN_frame& frame, CAN_Interface interface, frameDirection msgDir);
+void dump_can_frame(const CAN_frame& frame, CAN_Interface interface, frameDirection msgDir);
+
+// The web CAN logger keeps frames in binary, they only become text when the log is shown or exported
+void clear_web_can_log();
+bool web_can_log_empty();
+// Calls visit with each logged frame as a text line, oldest first, until visit returns false
+void for_each_web_can_log_line(const std::function<bool(const char* line, size_t len)>& visit);
+
+// Time to log a frame with in microseconds: the receive time of received frames, the current time otherwise
+int64_t can_frame_log_time_us(const CAN_frame& frame);
 void transmit_can_frame_to_interface(const CAN_frame* tx_frame, CAN_Interface interface);
 
+// Send several frames in order. They are converted once and handed to the driver in batches of
+// CAN_TX_BATCH_MAX_FRAMES, which takes the SPI bus lock of the add-on controllers once per batch.
+// Frames the driver cannot take right away are queued per controller, see retry_can_tx_queues().
+void transmit_can_frames(std::span<const CAN_frame> frames, CAN_Interface interface);
+
+// Hand a frame to the receivers of the interface as if it had been received, from any single task. Returns false
+// if the queue to the core task is full.
+bool inject_can_frame(const CAN_frame& frame, CAN_Interface interface);
+
+// While suppressed, transmitted frames are logged as usual but not handed to the drivers, nor timed
+void set_can_tx_suppressed(bool suppressed);
+
+// Switch the web CAN logger on or off. While it runs the hardware filters are open so the log shows the whole
+// bus, the controllers get the new filters shortly after.
+void set_web_can_logging(bool active);
+
+// Retry sending frames the drivers could not take earlier, highest bus priority first. Called every core_loop tick.
+void retry_can_tx_queues();
+
+// Collect interval statistics for a cyclic message, shown in datalayer.system.status.can_tx_timing
+void monitor_can_tx_timing(const CAN_frame& frame, CAN_Interface interface, unsigned long period_ms);
+
+// Clear the collected interval statistics. Takes effect on the next transmitted frame.
+void reset_can_tx_timing();
+
 //These defines are not used if user updates values via Settings page
 #define CRYSTAL_FREQUENCY_MHZ 8
 #define CANFD_ADDON_CRYSTAL_FREQUENCY_MHZ ACAN2517FDSettings::OSC_40MHz
@@ -52,40 +90,54 @@ void register_can_receiver(CanReceiver* receiver, CAN_Interface interface,
 bool init_CAN();
 
 /**
- * @brief Receive CAN messages from all interfaces. Respective CanReceivers are called.
+ * @brief Handle CAN messages queued by the CAN RX task. Respective CanReceivers are called.
+ * Bounded by CAN_RX_BATCH_MAX_FRAMES and CAN_RX_BATCH_MAX_US per call, the rest is left queued.
  *
  * @param[in] void
  *
+ * @return true if frames were left queued because the budget ran out
+ */
+bool receive_can();
+
+/**
+ * @brief Set the task to notify when the CAN RX task has queued frames, so it can call receive_can() right away.
+ * Only the frames this task transmits are timed by the TX timing monitors.
+ *
+ * @param[in] task Handle of the task calling receive_can()
+ *
  * @return void
  */
-void receive_can();
+void set_can_rx_consumer(TaskHandle_t task);
 
 /**
- * @brief Receive CAN messages from CAN tranceiver natively installed on Lilygo hardware
+ * @brief Move received CAN messages from the CAN tranceiver natively installed on Lilygo hardware to the RX queue
  *
  * @param[in] void
  *
- * @return void
+ * @return uint16_t Number of frames received
  */
-void receive_frame_can_native();
+uint16_t receive_frame_can_native();
 
 /**
- * @brief Receive CAN messages from CAN addon chip
+ * @brief Move received CAN messages from the CAN addon chip to the RX queue
  *
  * @param[in] void
  *
- * @return void
+ * @return uint16_t Number of frames received
  */
-void receive_frame_can_addon();
+uint16_t receive_frame_can_addon();
 
 /**
- * @brief Receive CAN messages from CANFD addon chip
+ * @brief Move received CAN messages from the CANFD addon chip to the RX queue
  *
  * @param[in] void
  *
- * @return void
+ * @return uint16_t Number of frames received
  */
-void receive_frame_canfd_addon();
+uint16_t receive_frame_canfd_addon();
+
+// Bit rate the interface was set up with, 0 when nothing uses it
+uint32_t can_interface_speed_bps(CAN_Interface interface);
 
 /**
  * @brief print CAN frames via USB
@@ -94,7 +146,7 @@ void receive_frame_canfd_addon();
  *
  * @return void
  */
-void print_can_frame(CAN_frame frame, CAN_Interface interface, frameDirection msgDir);
+void print_can_frame(const CAN_frame& frame, CAN_Interface interface, frameDirection msgDir);
 
 // Stop/pause CAN communication for all interfaces
 void stop_can();
@@ -0,0 +1,157 @@
+#include "gvret.h"
+#include <string.h>
+
+enum : uint8_t {
+  GVRET_BINARY_MODE = 0xE7,
+  GVRET_START = 0xF1,
+  GVRET_BUILD_CAN_FRAME = 0x00,
+  GVRET_TIME_SYNC = 0x01,
+  GVRET_GET_DIG_INPUTS = 0x02,
+  GVRET_GET_ANALOG_INPUTS = 0x03,
+  GVRET_SET_DIG_OUTPUTS = 0x04,
+  GVRET_SETUP_CANBUS = 0x05,
+  GVRET_GET_CANBUS_PARAMS = 0x06,
+  GVRET_GET_DEVICE_INFO = 0x07,
+  GVRET_SET_SINGLEWIRE_MODE = 0x08,
+  GVRET_KEEPALIVE = 0x09,
+  GVRET_SET_SYSTYPE = 0x0A,
+  GVRET_ECHO_CAN_FRAME = 0x0B,
+  GVRET_GET_NUMBUSES = 0x0C,
+  GVRET_GET_EXT_BUSES = 0x0D,
+  GVRET_SET_EXT_BUSES = 0x0E,
+  GVRET_BUILD_FD_FRAME = 0x14,
+};
+
+// Frames sent by the host: ID(4) bus(1) DLC(1), then the data and a checksum
+static const uint16_t HOST_FRAME_HEADER = 6;
+
+static uint8_t* put_u32(uint8_t* out, uint32_t value) {
+  out[0] = value & 0xFF;
+  out[1] = (value >> 8) & 0xFF;
+  out[2] = (value >> 16) & 0xFF;
+  out[3] = (value >> 24) & 0xFF;
+  return out + 4;
+}
+
+size_t gvret_encode_frame(const CAN_log_record& record, uint8_t* out) {
+  const bool fd = record.flags & CAN_LOG_FLAG_FD;
+  const uint8_t len = record.DLC > 64 ? 64 : record.DLC;
+  uint8_t* pos = out;
+  *pos++ = GVRET_START;
+  *pos++ = fd ? GVRET_BUILD_FD_FRAME : GVRET_BUILD_CAN_FRAME;
+  pos = put_u32(pos, (uint32_t)record.timestamp_us);
+  pos = put_u32(pos, record.ID | ((record.flags & CAN_LOG_FLAG_EXT) ? 0x80000000u : 0));
+  if (fd) {
+    *pos++ = len;
+    *pos++ = record.interface;
+  } else {
+    *pos++ = (record.interface << 4) | (len & 0x0F);
+  }
+  memcpy(pos, record.data, len);
+  pos += len;
+  *pos++ = 0;
+  return pos - out;
+}
+
+// Bytes following the command byte, for commands with a payload of fixed size
+static uint16_t payload_size_of(uint8_t command) {
+  switch (command) {
+    case GVRET_BUILD_CAN_FRAME:
+    case GVRET_ECHO_CAN_FRAME:
+    case GVRET_BUILD_FD_FRAME:
+      return HOST_FRAME_HEADER;  // Grows once the DLC is known
+    case GVRET_SET_DIG_OUTPUTS:
+    case GVRET_SET_SINGLEWIRE_MODE:
+    case GVRET_SET_SYSTYPE:
+      return 1;
+    case GVRET_SETUP_CANBUS:
+      return 8;
+    case GVRET_SET_EXT_BUSES:
+      return 12;
+    default:
+      return 0;
+  }
+}
+
+size_t GvretParser::feed(uint8_t byte, const Gvret_status& status, uint8_t* reply) {
+  switch (state) {
+    case 0:
+      if (byte == GVRET_START) {
+        state = 1;
+      } else if (byte == GVRET_BINARY_MODE) {
+        binary = true;
+      }
+      return 0;
+    case 1:
+      command = byte;
+      payload_read = 0;
+      payload_size = payload_size_of(command);
+      state = 2;
+      break;
+    default:
+      payload_read++;
+      if ((command == GVRET_BUILD_CAN_FRAME || command == GVRET_ECHO_CAN_FRAME || command == GVRET_BUILD_FD_FRAME) &&
+          payload_read == HOST_FRAME_HEADER) {
+        payload_size = HOST_FRAME_HEADER + (byte > 64 ? 64 : byte) + 1;
+      }
+      break;
+  }
+
+  if (payload_read < payload_size) {
+    return 0;
+  }
+  state = 0;
+  return complete(status, reply);
+}
+
+size_t GvretParser::complete(const Gvret_status& status, uint8_t* reply) {
+  uint8_t* pos = reply;
+  *pos++ = GVRET_START;
+  *pos++ = command;
+
+  switch (command) {
+    case GVRET_TIME_SYNC:
+      pos = put_u32(pos, status.time_us);
+      break;
+    case GVRET_GET_DIG_INPUTS:
+      *pos++ = 0;
+      *pos++ = 0;  // Checksum
+      break;
+    case GVRET_GET_ANALOG_INPUTS:
+      memset(pos, 0, 15);  // Seven 16 bit inputs and the checksum
+      pos += 15;
+      break;
+    case GVRET_GET_CANBUS_PARAMS:
+      for (int bus = 0; bus < 2; bus++) {
+        *pos++ = status.speed_bps[bus] != 0 ? 1 : 0;
+        pos = put_u32(pos, status.speed_bps[bus]);
+      }
+      break;
+    case GVRET_GET_DEVICE_INFO:
+      *pos++ = 1;  // Build number, low byte first
+      *pos++ = 0;
+      *pos++ = 0x20;  // EEPROM version
+      *pos++ = 0;     // File output type
+      *pos++ = 0;     // Auto start logging
+      *pos++ = 0;     // Single wire mode
+      break;
+    case GVRET_KEEPALIVE:
+      *pos++ = 0xDE;
+      *pos++ = 0xAD;
+      break;
+    case GVRET_GET_NUMBUSES:
+      *pos++ = GVRET_NUM_BUSES;
+      break;
+    case GVRET_GET_EXT_BUSES:
+      for (int bus = 2; bus < 5; bus++) {
+        const uint32_t speed = bus < GVRET_NUM_BUSES ? status.speed_bps[bus] : 0;
+        *pos++ = speed != 0 ? 1 : 0;
+        pos = put_u32(pos, speed);
+      }
+      break;
+    default:
+      // Settings and frames from the host need no reply
+      return 0;
+  }
+  return pos - reply;
+}
@@ -0,0 +1,57 @@
+#ifndef GVRET_H
+#define GVRET_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "../../devboard/sdcard/can_log_format.h"
+
+/* The binary protocol of GVRET, spoken by SavvyCAN and other bench tools, little endian.
+ *
+ * The host switches to binary mode by sending 0xE7. Commands and frames start with 0xF1 and a command
+ * byte. Received frames go to the host as F1 00 time_us(4) ID(4, bit 31 set for extended IDs)
+ * bus<<4|DLC data checksum, CAN-FD frames with the 0x14 command of ESP32RET as F1 14 time_us(4) ID(4)
+ * DLC bus data checksum. The checksum byte is always sent as 0, like GVRET does.
+ *
+ * Frames sent by the host are read and ignored, the board only sniffs.
+ */
+
+static constexpr uint8_t GVRET_NUM_BUSES = 4;
+// Longest frame message gvret_encode_frame() writes
+static constexpr size_t GVRET_FRAME_MAX_SIZE = 2 + 4 + 4 + 2 + 64 + 1;
+// Longest reply GvretParser::feed() writes
+static constexpr size_t GVRET_REPLY_MAX_SIZE = 32;
+
+typedef struct {
+  /** Bit rate of each bus in bits per second, 0 for buses not in use */
+  uint32_t speed_bps[GVRET_NUM_BUSES];
+  /** Microseconds since boot, truncated to 32 bits like the frame timestamps */
+  uint32_t time_us;
+} Gvret_status;
+
+// Writes the GVRET message for a logged frame to out, which must hold GVRET_FRAME_MAX_SIZE bytes.
+// The bus is the CAN_Interface of the frame. Returns its size.
+size_t gvret_encode_frame(const CAN_log_record& record, uint8_t* out);
+
+// Follows the commands the host sends, one byte at a time
+class GvretParser {
+ public:
+  // Feeds one byte from the host. Writes the reply, if the byte completes a command that has one, to reply,
+  // which must hold GVRET_REPLY_MAX_SIZE bytes, and returns its length.
+  size_t feed(uint8_t byte, const Gvret_status& status, uint8_t* reply);
+
+  // True once the host asked for binary mode, frames are only sent from then on
+  bool binary_mode() const { return binary; }
+
+ private:
+  size_t complete(const Gvret_status& status, uint8_t* reply);
+
+  bool binary = false;
+  // 0: waiting for a command, 1: got 0xF1, 2: got the command byte and reading its payload
+  uint8_t state = 0;
+  uint8_t command = 0;
+  uint16_t payload_read = 0;
+  // Payload length of the current command, for frames it is only known once their DLC is read
+  uint16_t payload_size = 0;
+};
+
+#endif
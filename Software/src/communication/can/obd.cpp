@@ -1,4 +1,5 @@
 #include "obd.h"
+#include "../../datalayer/datalayer.h"
 #include "../../devboard/utils/logging.h"
 #include "comm_can.h"
 
@@ -20,10 +21,10 @@ void show_dtc(uint8_t byte0, uint8_t byte1) {
       letter = 'U';
       break;
   }
-  logging.printf("%c%d\n", letter, ((byte0 & 0x3F) << 8) | byte1);
+  LOG_INFO(CAN, "%c%d\n", letter, ((byte0 & 0x3F) << 8) | byte1);
 }
 
-void handle_obd_frame(CAN_frame& rx_frame, CAN_Interface interface) {
+void handle_obd_frame(const CAN_frame& rx_frame, CAN_Interface interface) {
   if (rx_frame.data.u8[1] == 0x7F) {
     const char* error_str = "?";
     switch (rx_frame.data.u8[3]) {  // See https://automotive.wiki/index.php/ISO_14229
@@ -88,24 +89,26 @@ void handle_obd_frame(CAN_frame& rx_frame, CAN_Interface interface) {
         error_str = "serviceNotSupportedInActiveSession";
         break;
     }
-    logging.printf("ODB reply Request for service 0x%02X: %s\n", rx_frame.data.u8[2], error_str);
+    LOG_INFO(CAN, "ODB reply Request for service 0x%02X: %s\n", rx_frame.data.u8[2], error_str);
   } else {
     switch (rx_frame.data.u8[1] & 0x3F) {
       case 3:
-        logging.printf("ODB reply service 03: Show stored DTCs, %d present:\n", rx_frame.data.u8[2]);
+        LOG_INFO(CAN, "ODB reply service 03: Show stored DTCs, %d present:\n", rx_frame.data.u8[2]);
         for (int i = 0; i < rx_frame.data.u8[2]; i++)
           show_dtc(rx_frame.data.u8[3 + 2 * i], rx_frame.data.u8[4 + 2 * i]);
         break;
       case 7:
-        logging.printf("ODB reply service 07: Show pending DTCs, %d present:\n", rx_frame.data.u8[2]);
+        LOG_INFO(CAN, "ODB reply service 07: Show pending DTCs, %d present:\n", rx_frame.data.u8[2]);
         for (int i = 0; i < rx_frame.data.u8[2]; i++)
           show_dtc(rx_frame.data.u8[3 + 2 * i], rx_frame.data.u8[4 + 2 * i]);
         break;
       default:
-        logging.printf("ODBx reply frame received:\n");
+        LOG_INFO(CAN, "ODBx reply frame received:\n");
     }
   }
-  dump_can_frame(rx_frame, interface, MSG_RX);
+  if (datalayer.system.info.can_logging_active) {
+    dump_can_frame(rx_frame, interface, MSG_RX);
+  }
 }
 
 void transmit_obd_can_frame(unsigned int address, CAN_Interface interface, bool canFD) {
@@ -3,7 +3,7 @@
 
 #include "comm_can.h"
 
-void handle_obd_frame(CAN_frame& rx_frame, CAN_Interface interface);
+void handle_obd_frame(const CAN_frame& rx_frame, CAN_Interface interface);
 
 void transmit_obd_can_frame(unsigned int address, CAN_Interface interface, bool canFD);
 
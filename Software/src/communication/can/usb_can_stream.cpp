@@ -0,0 +1,102 @@
+#include "usb_can_stream.h"
+#include <Arduino.h>
+#include "../../datalayer/datalayer.h"
+#include "../../devboard/hal/hal.h"
+#include "../../devboard/sdcard/can_log_format.h"
+#include "comm_can.h"
+#include "esp_timer.h"
+#include "freertos/ringbuf.h"
+#include "gvret.h"
+
+static RingbufHandle_t usb_can_bufferHandle = NULL;
+
+void add_can_frame_to_usb_stream(const CAN_frame& frame, CAN_Interface interface, frameDirection msgDir) {
+  if (usb_can_bufferHandle == NULL) {
+    return;
+  }
+
+  uint8_t record[CAN_LOG_RECORD_MAX_SIZE];
+  const size_t size = encode_can_log_record(frame, msgDir, interface, can_frame_log_time_us(frame), record);
+
+  // Never wait for the USB host here, this runs on the CAN tasks
+  if (xRingbufferSend(usb_can_bufferHandle, record, size, 0) != pdTRUE) {
+    datalayer.system.status.can_usb_log_drops++;
+  }
+}
+
+static Gvret_status gvret_status() {
+  Gvret_status status = {};
+  for (int bus = 0; bus < GVRET_NUM_BUSES; bus++) {
+    status.speed_bps[bus] = can_interface_speed_bps((CAN_Interface)bus);
+  }
+  status.time_us = (uint32_t)esp_timer_get_time();
+  return status;
+}
+
+// Answers what the host asked. Replies are added to out after the frames gathered so far, as writing them straight
+// to the port could split a frame the port only took part of. Commands wait while out has no room for a reply.
+static void handle_gvret_commands(GvretParser& parser, uint8_t* out, size_t out_size, size_t& out_used) {
+  while (out_used + GVRET_REPLY_MAX_SIZE <= out_size && Serial.available() > 0) {
+    out_used += parser.feed(Serial.read(), gvret_status(), out + out_used);
+  }
+}
+
+static void usb_can_stream_task(void*) {
+  const bool gvret = datalayer.system.info.CAN_usb_log_gvret;
+  GvretParser parser;
+  // Formatted frames not yet taken by the USB serial port. A line is the longest form of a frame.
+  static uint8_t out[USB_CAN_WRITE_BLOCK_SIZE];
+  size_t out_used = 0;
+  size_t out_written = 0;
+
+  while (true) {
+    if (gvret) {
+      handle_gvret_commands(parser, out, sizeof(out), out_used);
+    }
+
+    // Gather frames while there is room for another one, only waiting when there is nothing to write
+    while (out_used + CAN_LOG_LINE_MAX_SIZE <= sizeof(out)) {
+      size_t size;
+      const TickType_t wait = (out_used > out_written) ? 0 : pdMS_TO_TICKS(USB_CAN_IDLE_WAIT_MS);
+      uint8_t* item = (uint8_t*)xRingbufferReceive(usb_can_bufferHandle, &size, wait);
+      if (item == NULL) {
+        break;
+      }
+      CAN_log_record record;
+      if (decode_can_log_record(item, size, record) > 0) {
+        if (!gvret) {
+          out_used += format_can_log_line(record, (char*)out + out_used, sizeof(out) - out_used);
+        } else if (parser.binary_mode()) {
+          out_used += gvret_encode_frame(record, out + out_used);
+        }
+      }
+      vRingbufferReturnItem(usb_can_bufferHandle, item);
+    }
+
+    // Only hand the port what it takes without blocking, frames queue up in the ring buffer meanwhile
+    const int room = Serial.availableForWrite();
+    if (room > 0 && out_used > out_written) {
+      out_written += Serial.write(out + out_written, min((size_t)room, out_used - out_written));
+    }
+    if (out_written == out_used) {
+      out_used = 0;
+      out_written = 0;
+    } else if (room <= 0) {
+      vTaskDelay(1);
+    }
+  }
+}
+
+void init_usb_can_stream() {
+  if (!datalayer.system.info.CAN_usb_logging_active) {
+    return;
+  }
+
+  usb_can_bufferHandle = xRingbufferCreate(USB_CAN_RING_BUFFER_SIZE, RINGBUF_TYPE_NOSPLIT);
+  if (usb_can_bufferHandle == NULL) {
+    return;
+  }
+
+  xTaskCreatePinnedToCore(usb_can_stream_task, "usb_can_stream", 4096, NULL, TASK_USB_CAN_PRIO, NULL,
+                          esp32hal->WIFICORE());
+}
@@ -0,0 +1,15 @@
+#ifndef USB_CAN_STREAM_H
+#define USB_CAN_STREAM_H
+
+#include "../../devboard/utils/types.h"
+
+// Streams CAN frames over USB serial, as text lines or in the GVRET binary protocol (CANLOGGVRET setting).
+// The CAN tasks only queue frames, a separate task does the formatting and writes to the USB serial port.
+
+// Creates the buffer and starts the streaming task, if CAN logging via USB is enabled
+void init_usb_can_stream();
+
+// Queues a frame for streaming, never waits. Frames that don't fit are counted in can_usb_log_drops.
+void add_can_frame_to_usb_stream(const CAN_frame& frame, CAN_Interface interface, frameDirection msgDir);
+
+#endif
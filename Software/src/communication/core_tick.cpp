@@ -0,0 +1,30 @@
+#include "core_tick.h"
+#include <Arduino.h>
+#include "../devboard/utils/logging.h"
+#include "can/comm_can.h"
+
+static CyclicScheduler cyclic_scheduler;
+static bool cyclic_tasks_running = false;
+
+void register_cyclic_task(unsigned long period_ms, CyclicScheduler::Callback callback, long phase_ms) {
+  [[maybe_unused]] unsigned long phase = cyclic_scheduler.add(period_ms, callback, millis(), phase_ms);
+  DEBUG_PRINTF("cyclic task registered, %lums phase %lu, total: %d\n", period_ms, phase, cyclic_scheduler.size());
+}
+
+void run_core_tick(unsigned long now_ms) {
+  // Frames the CAN drivers could not take on an earlier tick
+  retry_can_tx_queues();
+
+  // Run the cyclic tasks that are due, mostly sending of periodic CAN messages
+  cyclic_tasks_running = true;
+  cyclic_scheduler.run(now_ms);
+  cyclic_tasks_running = false;
+}
+
+bool in_cyclic_task() {
+  return cyclic_tasks_running;
+}
+
+void clear_cyclic_tasks() {
+  cyclic_scheduler.clear();
+}
@@ -0,0 +1,16 @@
+#ifndef _CORE_TICK_H
+#define _CORE_TICK_H
+
+#include "CyclicScheduler.h"
+
+// The CAN work core_loop does every 1 ms tick: frames the drivers could not take earlier are retried, then the
+// cyclic tasks that are due run. Kept apart from core_loop so the host build can drive it from a simulated clock.
+void run_core_tick(unsigned long now_ms);
+
+// True while the cyclic tasks run, so frames they send can be told from one-off frames
+bool in_cyclic_task();
+
+// Drops every task registered with register_cyclic_task(), so a host test can set up a new charger
+void clear_cyclic_tasks();
+
+#endif
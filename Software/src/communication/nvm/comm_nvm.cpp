@@ -56,10 +56,17 @@ void init_stored_settings() {
 
   datalayer.system.info.performance_measurement_active = settings.getBool("PERFPROFILE", false);
   datalayer.system.info.CAN_usb_logging_active = settings.getBool("CANLOGUSB", false);
-  datalayer.system.info.usb_logging_active = settings.getBool("USBENABLED", false);
+  datalayer.system.info.CAN_usb_log_gvret = settings.getBool("CANLOGGVRET", false);
+  // Debug text would corrupt the binary stream
+  datalayer.system.info.usb_logging_active =
+      settings.getBool("USBENABLED", false) &&
+      !(datalayer.system.info.CAN_usb_logging_active && datalayer.system.info.CAN_usb_log_gvret);
   datalayer.system.info.web_logging_active = settings.getBool("WEBENABLED", false);
   datalayer.system.info.CAN_SD_logging_active = settings.getBool("CANLOGSD", false);
   datalayer.system.info.SD_logging_active = settings.getBool("SDLOGENABLED", false);
+  for (int module = 0; module < LOG_MODULE_COUNT; module++) {
+    log_module_levels[module] = settings.getUInt(log_level_setting((LogModule)module), LOG_LEVEL_DEFAULT);
+  }
   datalayer.battery.status.led_mode = (led_mode_enum)settings.getUInt("LEDMODE", false);
 
   // WIFI AP is enabled by default unless disabled in the settings
@@ -84,6 +91,8 @@ void init_stored_settings() {
   static_subnet4 = settings.getUInt("SUBNET4", 0);
 
   settings.end();
+  LOG_DEBUG(NVM, "Settings loaded, charger type %d on %s\n", (int)user_selected_charger_type,
+            getCANInterfaceName(can_config.charger));
 }
 
 void store_settings_equipment_stop() {
@@ -96,6 +105,7 @@ void store_settings() {
   //  ATTENTION ! The maximum length for settings keys is 15 characters
   if (!settings.begin("batterySettings", false)) {
     set_event(EVENT_PERSISTENT_SAVE_INFO, 0);
+    LOG_ERROR(NVM, "Could not open settings storage\n");
     return;
   }
 
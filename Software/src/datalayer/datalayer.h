@@ -1,6 +1,8 @@
 #ifndef _DATALAYER_H_
 #define _DATALAYER_H_
 
+#include "../communication/can/CanTxQueue.h"
+#include "../communication/can/CanTxTiming.h"
 #include "../devboard/utils/types.h"
 #include "../system_settings.h"
 
@@ -249,13 +251,12 @@ struct DATALAYER_SYSTEM_INFO_TYPE {
   char shunt_protocol[64] = {0};
   /** array with type of inverter brand used, for displaying on webserver */
   char inverter_brand[8] = {0};
-  /** array with incoming CAN messages, for displaying on webserver */
-  char logged_can_messages[15000] = {0};
-  size_t logged_can_messages_offset = 0;
   /** bool, determines if CAN messages should be logged for webserver */
   bool can_logging_active = false;
   /** bool, determines if USB serial logging should occur */
   bool CAN_usb_logging_active = false;
+  /** bool, CAN frames go to USB in the GVRET binary protocol instead of text lines */
+  bool CAN_usb_log_gvret = false;
   /** bool, determines if USB serial logging should occur */
   bool CAN_SD_logging_active = false;
   /** bool, determines if USB serial logging should occur */
@@ -319,6 +320,45 @@ struct DATALAYER_SYSTEM_STATUS_TYPE {
    * This will show the performance of CAN TX when the total time reached a new worst case
    */
   int64_t time_snap_cantx_us = 0;
+
+  /** Number of times the native CAN driver receive queue overflowed and frames were lost */
+  uint32_t can_native_rx_overruns = 0;
+  /** Number of times the MCP2515 add-on driver receive queue overflowed and frames were lost */
+  uint32_t can_2515_rx_overruns = 0;
+  /** Number of times the MCP2518 add-on receive queue (driver or hardware FIFO) overflowed and frames were lost */
+  uint32_t can_2518_rx_overruns = 0;
+  /** Highest number of queued CAN frames handled by a single receive_can() call */
+  uint16_t can_rx_batch_max = 0;
+  /** Number of receive_can() calls where the receive budget ran out with frames still queued */
+  uint32_t can_rx_budget_exhausted = 0;
+  /** Number of frames lost because the queue from the CAN RX task to core_loop was full */
+  uint32_t can_rx_queue_overruns = 0;
+  /** Longest time in microseconds from a frame being received until it was handled */
+  uint32_t can_rx_latency_max_us = 0;
+  /** Frames waiting for a retry because the native CAN driver could not take them */
+  CAN_tx_queue_stats can_native_tx_queue = {};
+  /** Frames waiting for a retry because the MCP2515 add-on driver could not take them */
+  CAN_tx_queue_stats can_2515_tx_queue = {};
+  /** Frames waiting for a retry because the MCP2518 add-on driver could not take them */
+  CAN_tx_queue_stats can_2518_tx_queue = {};
+  /** Number of CAN frames left out of the SD card log because the buffer towards the SD writer was full */
+  uint32_t can_sd_log_drops = 0;
+  /** Number of CAN frames left out of the USB stream because the host did not keep up */
+  uint32_t can_usb_log_drops = 0;
+  /** Debug log writes dropped because the SD card ring buffer was full */
+  uint32_t sd_log_drops = 0;
+  /** Bytes per second written to the SD card, measured over the last second with writes */
+  uint32_t sd_write_bytes_per_s = 0;
+  /** Longest time in microseconds a single block write and flush to the SD card took */
+  uint32_t sd_write_max_us = 0;
+  /** Highest amount of bytes waiting in the buffer between CAN logging and the SD card writer */
+  uint32_t sd_can_buffer_high_water = 0;
+  /** Highest amount of bytes waiting in the buffer between debug logging and the SD card writer */
+  uint32_t sd_log_buffer_high_water = 0;
+  /** Transmit interval statistics of the cyclic CAN messages registered with monitor_can_tx_timing() */
+  CAN_tx_timing can_tx_timing[CAN_TX_TIMING_MAX_MESSAGES];
+  /** Number of used entries in can_tx_timing */
+  uint8_t can_tx_timing_count = 0;
   /** uint8_t */
   /** A counter set each time a new message comes from inverter.
    * This value then gets decremented every second. Incase we reach 0
@@ -4,6 +4,7 @@
 #include <soc/gpio_num.h>
 #include <chrono>
 #include <unordered_map>
+#include <vector>
 #include "../../../src/communication/nvm/comm_nvm.h"
 #include "../../../src/devboard/utils/events.h"
 #include "../../../src/devboard/utils/logging.h"
@@ -24,6 +25,8 @@ class Esp32Hal {
   virtual int CORE_FUNCTION_CORE() { return 1; }
   virtual int MODBUS_CORE() { return 0; }
   virtual int WIFICORE() { return 0; }
+  // Must differ from CORE_FUNCTION_CORE, SD card writes can block for tens of milliseconds
+  virtual int SDCARD_CORE() { return 0; }
 
   virtual void set_default_configuration_values() {}
 
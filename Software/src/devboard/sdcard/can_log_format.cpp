@@ -0,0 +1,238 @@
+#include "can_log_format.h"
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+static_assert(offsetof(CAN_log_record, flags) == 12, "CAN log header layout changed");
+static_assert(offsetof(CAN_log_record, data) == CAN_LOG_HEADER_SIZE, "CAN log header layout changed");
+
+size_t can_log_record_size(uint8_t flags) {
+  return CAN_LOG_HEADER_SIZE + ((flags & CAN_LOG_FLAG_FD) ? 64 : 8);
+}
+
+size_t encode_can_log_record(const CAN_frame& frame, frameDirection direction, CAN_Interface interface,
+                             int64_t timestamp_us, uint8_t* out) {
+  CAN_log_record record;
+  record.timestamp_us = timestamp_us;
+  record.ID = frame.ID;
+  record.flags = (frame.ext_ID ? CAN_LOG_FLAG_EXT : 0) | (frame.FD ? CAN_LOG_FLAG_FD : 0) |
+                 (direction == MSG_TX ? CAN_LOG_FLAG_TX : 0);
+  record.DLC = frame.DLC;
+  record.interface = interface;
+  record.reserved = 0;
+  memcpy(record.data, frame.data.u8, sizeof(record.data));
+  return encode_can_log_record(record, out);
+}
+
+size_t encode_can_log_record(const CAN_log_record& record, uint8_t* out) {
+  const size_t payload = can_log_record_size(record.flags) - CAN_LOG_HEADER_SIZE;
+  const size_t used = record.DLC < payload ? record.DLC : payload;
+
+  // The struct has no padding up to data, and both the ESP32 and the hosts reading the logs are little endian
+  memcpy(out, &record, CAN_LOG_HEADER_SIZE + used);
+  memset(out + CAN_LOG_HEADER_SIZE + used, 0, payload - used);
+  return CAN_LOG_HEADER_SIZE + payload;
+}
+
+size_t decode_can_log_record(const uint8_t* in, size_t len, CAN_log_record& record) {
+  if (len < CAN_LOG_HEADER_SIZE) {
+    return 0;
+  }
+  const size_t size = can_log_record_size(in[12]);
+  if (len < size) {
+    return 0;
+  }
+  memset(&record, 0, sizeof(record));
+  memcpy(&record, in, size);
+  return size;
+}
+
+void CanLogBlockDecoder::set_block(const uint8_t* data, size_t len) {
+  block = data;
+  block_len = len;
+  pos = 0;
+}
+
+bool CanLogBlockDecoder::next(CAN_log_record& record) {
+  while (magic_read < sizeof(CAN_LOG_MAGIC) && pos < block_len) {
+    if (block[pos++] != (uint8_t)CAN_LOG_MAGIC[magic_read++]) {
+      magic_read = sizeof(CAN_LOG_MAGIC) + 1;
+    }
+  }
+  if (magic_read != sizeof(CAN_LOG_MAGIC)) {
+    return false;
+  }
+
+  if (carry_used > 0) {
+    // Complete the header first, it tells the size of the rest
+    while (carry_used < CAN_LOG_HEADER_SIZE || carry_used < can_log_record_size(carry[12])) {
+      if (pos == block_len) {
+        return false;
+      }
+      const size_t want =
+          (carry_used < CAN_LOG_HEADER_SIZE ? CAN_LOG_HEADER_SIZE : can_log_record_size(carry[12])) - carry_used;
+      const size_t take = (want < block_len - pos) ? want : block_len - pos;
+      memcpy(carry + carry_used, block + pos, take);
+      carry_used += take;
+      pos += take;
+    }
+    decode_can_log_record(carry, carry_used, record);
+    carry_used = 0;
+    return true;
+  }
+
+  const size_t used = decode_can_log_record(block + pos, block_len - pos, record);
+  if (used == 0) {
+    carry_used = block_len - pos;
+    memcpy(carry, block + pos, carry_used);
+    pos = block_len;
+    return false;
+  }
+  pos += used;
+  return true;
+}
+
+void can_log_record_to_frame(const CAN_log_record& record, CAN_frame& frame) {
+  frame.FD = record.flags & CAN_LOG_FLAG_FD;
+  frame.ext_ID = record.flags & CAN_LOG_FLAG_EXT;
+  frame.DLC = record.DLC;
+  frame.ID = record.ID;
+  memcpy(frame.data.u8, record.data, sizeof(record.data));
+  frame.timestamp_us = 0;  // The time it was logged at is not when it is handled again
+}
+
+uint8_t can_log_bus_number(const CAN_log_record& record) {
+  // Multiplying the interface by two ensures that SavvyCAN puts TX and RX in a different bus
+  return record.interface * 2 + ((record.flags & CAN_LOG_FLAG_TX) ? 1 : 0);
+}
+
+size_t format_can_log_line(const CAN_log_record& record, char* out, size_t size) {
+  const bool tx = record.flags & CAN_LOG_FLAG_TX;
+  // Extended IDs always get all eight digits, or small ones would be read back as standard IDs
+  const char* format = (record.flags & CAN_LOG_FLAG_EXT) ? "(%lu.%06lu) %s%d %08lX [%u]" : "(%lu.%06lu) %s%d %lX [%u]";
+  int len = snprintf(out, size, format, (unsigned long)(record.timestamp_us / 1000000),
+                     (unsigned long)(record.timestamp_us % 1000000), tx ? "TX" : "RX", can_log_bus_number(record),
+                     (unsigned long)record.ID, record.DLC);
+  for (uint8_t i = 0; i < record.DLC && i < sizeof(record.data) && len > 0 && (size_t)len < size; i++) {
+    len += snprintf(out + len, size - len, " %02X", record.data[i]);
+  }
+  if (len > 0 && (size_t)len < size) {
+    len += snprintf(out + len, size - len, "\n");
+  }
+  return (len < 0) ? 0 : ((size_t)len < size ? len : size - 1);
+}
+
+static int hex_value(char c) {
+  if (c >= '0' && c <= '9') {
+    return c - '0';
+  }
+  if (c >= 'a' && c <= 'f') {
+    return c - 'a' + 10;
+  }
+  if (c >= 'A' && c <= 'F') {
+    return c - 'A' + 10;
+  }
+  return -1;
+}
+
+static bool is_space(char c) {
+  return c == ' ' || c == '\t' || c == '\r';
+}
+
+bool parse_can_log_line(const char* line, size_t len, CAN_log_record& record) {
+  const char* pos = line;
+  const char* end = line + len;
+  auto skip_spaces = [&]() {
+    while (pos < end && is_space(*pos)) {
+      pos++;
+    }
+  };
+
+  memset(&record, 0, sizeof(record));
+  skip_spaces();
+  if (pos == end || *pos++ != '(') {
+    return false;
+  }
+
+  // Timestamps are "seconds.fraction" with any resolution, kept as integer microseconds
+  int64_t seconds = 0;
+  const char* digits = pos;
+  while (pos < end && *pos >= '0' && *pos <= '9') {
+    seconds = seconds * 10 + (*pos++ - '0');
+  }
+  if (pos == digits) {
+    return false;
+  }
+  record.timestamp_us = seconds * 1000000;
+  if (pos < end && *pos == '.') {
+    pos++;
+    for (int64_t scale = 100000; pos < end && *pos >= '0' && *pos <= '9'; pos++, scale /= 10) {
+      record.timestamp_us += (*pos - '0') * scale;
+    }
+  }
+  if (pos == end || *pos++ != ')') {
+    return false;
+  }
+
+  // Bus column, RXn or TXn
+  skip_spaces();
+  if (end - pos >= 2 && pos[0] == 'T' && pos[1] == 'X') {
+    record.flags |= CAN_LOG_FLAG_TX;
+  }
+  while (pos < end && !is_space(*pos) && !(*pos >= '0' && *pos <= '9')) {
+    pos++;
+  }
+  unsigned bus = 0;
+  while (pos < end && *pos >= '0' && *pos <= '9') {
+    bus = bus * 10 + (*pos++ - '0');
+  }
+  record.interface = bus > UINT8_MAX ? UINT8_MAX : bus;
+
+  skip_spaces();
+  int id_digits = 0;
+  for (int digit; pos < end && (digit = hex_value(*pos)) >= 0; pos++, id_digits++) {
+    record.ID = (record.ID << 4) | digit;
+  }
+  if (id_digits == 0 || id_digits > 8) {
+    return false;
+  }
+  if (id_digits > 3 || record.ID > 0x7FF) {
+    record.flags |= CAN_LOG_FLAG_EXT;
+  }
+
+  skip_spaces();
+  if (pos == end || *pos++ != '[') {
+    return false;
+  }
+  unsigned dlc = 0;
+  digits = pos;
+  while (pos < end && *pos >= '0' && *pos <= '9') {
+    dlc = dlc * 10 + (*pos++ - '0');
+  }
+  if (pos == digits || pos == end || *pos++ != ']' || dlc > 64) {
+    return false;
+  }
+  record.DLC = dlc;
+  if (dlc > 8) {
+    record.flags |= CAN_LOG_FLAG_FD;
+  }
+
+  // Missing data bytes are left zero, like the replay always did
+  for (uint8_t i = 0; i < record.DLC; i++) {
+    skip_spaces();
+    if (end - pos < 2 || hex_value(pos[0]) < 0 || hex_value(pos[1]) < 0) {
+      break;
+    }
+    record.data[i] = (hex_value(pos[0]) << 4) | hex_value(pos[1]);
+    pos += 2;
+  }
+  return true;
+}
+
+bool CanLogLineParser::is_blank_or_comment(const char* text, size_t len) {
+  size_t i = 0;
+  while (i < len && is_space(text[i])) {
+    i++;
+  }
+  return i == len || text[i] == '#';
+}
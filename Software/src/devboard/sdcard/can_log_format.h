@@ -0,0 +1,142 @@
+#ifndef CAN_LOG_FORMAT_H
+#define CAN_LOG_FORMAT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "../utils/types.h"
+
+/* Binary CAN log as written to the SD card, little endian.
+ *
+ * The file starts with the 8 byte CAN_LOG_MAGIC, followed by records. A record is a 16 byte header and the
+ * payload, 8 bytes for classic CAN frames and 64 bytes for CAN-FD frames (CAN_LOG_FLAG_FD). Unused payload
+ * bytes are zero. tools/canlog_convert.cpp turns these files into text.
+ */
+
+static constexpr char CAN_LOG_MAGIC[8] = {'B', 'E', 'C', 'A', 'N', 'L', 'O', '1'};
+
+static constexpr uint8_t CAN_LOG_FLAG_EXT = 0x01;
+static constexpr uint8_t CAN_LOG_FLAG_FD = 0x02;
+static constexpr uint8_t CAN_LOG_FLAG_TX = 0x04;
+
+static constexpr size_t CAN_LOG_HEADER_SIZE = 16;
+static constexpr size_t CAN_LOG_RECORD_MAX_SIZE = CAN_LOG_HEADER_SIZE + 64;
+// Longest line format_can_log_line() writes, terminator included
+static constexpr size_t CAN_LOG_LINE_MAX_SIZE = 256;
+
+typedef struct {
+  int64_t timestamp_us;
+  uint32_t ID;
+  uint8_t flags;
+  uint8_t DLC;
+  uint8_t interface;
+  uint8_t reserved;
+  uint8_t data[64];
+} CAN_log_record;
+
+// Size of the record with the given flags, header included
+size_t can_log_record_size(uint8_t flags);
+
+// Writes the record for a frame to out, which must hold CAN_LOG_RECORD_MAX_SIZE bytes. Returns its size.
+size_t encode_can_log_record(const CAN_frame& frame, frameDirection direction, CAN_Interface interface,
+                             int64_t timestamp_us, uint8_t* out);
+
+// Writes a record as it is, for records that did not come from a CAN_frame. Returns its size.
+size_t encode_can_log_record(const CAN_log_record& record, uint8_t* out);
+
+// Reads one record from in. Returns the amount of bytes used, or 0 if len does not hold a whole record.
+size_t decode_can_log_record(const uint8_t* in, size_t len, CAN_log_record& record);
+
+// Takes the records out of a binary CAN log read in blocks of any size. The CAN_LOG_MAGIC the log starts with
+// is checked and skipped, a record split over two blocks is put back together.
+class CanLogBlockDecoder {
+ public:
+  // Hands over the next block, which must stay valid until next() returns false
+  void set_block(const uint8_t* data, size_t len);
+
+  // Reads the next record of the block. Returns false when the block is used up, or if the log does not start
+  // with CAN_LOG_MAGIC.
+  bool next(CAN_log_record& record);
+
+  bool bad_magic() const { return magic_read == sizeof(CAN_LOG_MAGIC) + 1; }
+
+ private:
+  const uint8_t* block = nullptr;
+  size_t block_len = 0;
+  size_t pos = 0;
+  // Start of a record that continues in the next block
+  uint8_t carry[CAN_LOG_RECORD_MAX_SIZE];
+  size_t carry_used = 0;
+  // Bytes of the magic checked so far, one more than its size once it did not match
+  size_t magic_read = 0;
+};
+
+// The frame a record was made from
+void can_log_record_to_frame(const CAN_log_record& record, CAN_frame& frame);
+
+// Number of the RXn/TXn column of the text logs for a record of the SD card or USB logs: the interface times two,
+// plus one for transmitted frames
+uint8_t can_log_bus_number(const CAN_log_record& record);
+
+// Writes the record as a "(seconds) RX0 ID [DLC] data" line, the text format of the web CAN logger that CAN
+// replay reads back. Returns its length.
+size_t format_can_log_line(const CAN_log_record& record, char* out, size_t size);
+
+// Reads a "(seconds) RX0 ID [DLC] data" line, as written by format_can_log_line() and the web CAN logger. The
+// ID#DATA lines of candump -l have no [DLC] and are not frames to it.
+// The bus number of the RXn/TXn column goes to record.interface as it is, TX sets CAN_LOG_FLAG_TX. IDs
+// written with more than three digits or above 0x7FF are extended, DLCs above 8 are CAN-FD. Returns false
+// for comments, blank lines and lines that are not frames.
+bool parse_can_log_line(const char* line, size_t len, CAN_log_record& record);
+
+// Splits text arriving in chunks of any size into lines and parses them with parse_can_log_line()
+class CanLogLineParser {
+ public:
+  // Calls on_record(const CAN_log_record&) for every frame completed by data
+  template <typename F>
+  void feed(const uint8_t* data, size_t len, F&& on_record) {
+    for (size_t i = 0; i < len; i++) {
+      if (data[i] != '\n') {
+        if (used < sizeof(line)) {
+          line[used++] = data[i];
+        } else {
+          overflow = true;
+        }
+        continue;
+      }
+      end_line(on_record);
+    }
+  }
+
+  // Parses what is left after the last newline
+  template <typename F>
+  void finish(F&& on_record) {
+    if (used > 0 || overflow) {
+      end_line(on_record);
+    }
+  }
+
+  /** Lines that were not frames, comments and blank lines excluded */
+  uint32_t lines_skipped() const { return skipped; }
+
+ private:
+  template <typename F>
+  void end_line(F&& on_record) {
+    CAN_log_record record;
+    if (!overflow && parse_can_log_line(line, used, record)) {
+      on_record(record);
+    } else if (overflow || !is_blank_or_comment(line, used)) {
+      skipped++;
+    }
+    used = 0;
+    overflow = false;
+  }
+
+  static bool is_blank_or_comment(const char* text, size_t len);
+
+  char line[CAN_LOG_LINE_MAX_SIZE];
+  size_t used = 0;
+  bool overflow = false;
+  uint32_t skipped = 0;
+};
+
+#endif
@@ -0,0 +1,63 @@
+#include "log_segments.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+std::string format_index(const std::vector<Log_segment>& segments) {
+  std::string content;
+  char line[24];
+  for (const Log_segment& segment : segments) {
+    snprintf(line, sizeof(line), "%lu,%lu\n", (unsigned long)segment.number, (unsigned long)segment.start_s);
+    content += line;
+  }
+  return content;
+}
+
+std::vector<Log_segment> parse_index(const std::string& content) {
+  std::vector<Log_segment> segments;
+  const char* p = content.c_str();
+  while (*p != '\0') {
+    char* end;
+    const unsigned long number = strtoul(p, &end, 10);
+    if (end != p && *end == ',') {
+      const char* start = end + 1;
+      const unsigned long start_s = strtoul(start, &end, 10);
+      if (end != start && number > 0) {
+        segments.push_back({(uint32_t)number, (uint32_t)start_s, 0});
+      }
+    }
+    // Skip to the next line, also past anything unparsable
+    while (*end != '\0' && *end != '\n') {
+      end++;
+    }
+    p = (*end == '\n') ? end + 1 : end;
+  }
+  return segments;
+}
+
+bool segment_should_rotate(const Log_segment& segment, uint32_t now_s, uint32_t max_bytes, uint32_t max_age_s) {
+  return segment.size >= max_bytes || now_s - segment.start_s >= max_age_s;
+}
+
+size_t segments_to_drop(const std::vector<Log_segment>& segments, uint64_t max_total_bytes) {
+  uint64_t total = 0;
+  for (const Log_segment& segment : segments) {
+    total += segment.size;
+  }
+  size_t drop = 0;
+  while (total > max_total_bytes && drop + 1 < segments.size()) {
+    total -= segments[drop].size;
+    drop++;
+  }
+  return drop;
+}
+
+std::vector<Log_segment> segments_in_range(const std::vector<Log_segment>& segments, uint32_t from_s, uint32_t to_s) {
+  std::vector<Log_segment> result;
+  for (size_t i = 0; i < segments.size(); i++) {
+    const bool newest = i + 1 == segments.size();
+    if (segments[i].start_s <= to_s && (newest || segments[i + 1].start_s > from_s)) {
+      result.push_back(segments[i]);
+    }
+  }
+  return result;
+}
@@ -0,0 +1,33 @@
+#ifndef LOG_SEGMENTS_H
+#define LOG_SEGMENTS_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+// Bookkeeping for logs split into numbered segment files. Only arithmetic and index parsing live here,
+// so it can be tested on the host; sdcard.cpp does the file handling.
+
+typedef struct {
+  /** Segment files are named after this number */
+  uint32_t number;
+  /** Log clock in seconds when the segment was started, see sd_log_clock_s() */
+  uint32_t start_s;
+  /** Size of the segment file in bytes */
+  uint32_t size;
+} Log_segment;
+
+// The index file holds one "number,start_s" line per segment, oldest first
+std::string format_index(const std::vector<Log_segment>& segments);
+std::vector<Log_segment> parse_index(const std::string& content);
+
+bool segment_should_rotate(const Log_segment& segment, uint32_t now_s, uint32_t max_bytes, uint32_t max_age_s);
+
+// Amount of the oldest segments to remove for the total size to fit max_total_bytes. The newest segment is kept.
+size_t segments_to_drop(const std::vector<Log_segment>& segments, uint64_t max_total_bytes);
+
+// Segments holding data from [from_s, to_s]. A segment covers the time until the next one starts,
+// the newest one until now.
+std::vector<Log_segment> segments_in_range(const std::vector<Log_segment>& segments, uint32_t from_s, uint32_t to_s);
+
+#endif
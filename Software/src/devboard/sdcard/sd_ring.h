@@ -0,0 +1,25 @@
+#ifndef SD_RING_H
+#define SD_RING_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/ringbuf.h"
+
+// Takes the next item out of a ring buffer towards the SD card and calls write(const uint8_t* data, size_t size)
+// with it, which may ignore it while the log is paused. On a RINGBUF_TYPE_NOSPLIT ring an item is always one
+// whole record, also where the ring wraps, so what is written stays aligned to records whatever gets dropped.
+// Returns false if nothing arrived within max_wait.
+template <typename F>
+bool take_sd_ring_item(RingbufHandle_t handle, TickType_t max_wait, F&& write) {
+  size_t size;
+  uint8_t* item = (uint8_t*)xRingbufferReceive(handle, &size, max_wait);
+  if (item == NULL) {
+    return false;
+  }
+  write((const uint8_t*)item, size);
+  vRingbufferReturnItem(handle, (void*)item);
+  return true;
+}
+
+#endif
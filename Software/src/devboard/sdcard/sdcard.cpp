@@ -1,178 +1,489 @@
 #include "sdcard.h"
+#include "can_log_format.h"
+#include "esp_heap_caps.h"
+#include "esp_task_wdt.h"
+#include "esp_timer.h"
 #include "freertos/ringbuf.h"
+#include "sd_ring.h"
 
-File can_log_file;
-File log_file;
-RingbufHandle_t can_bufferHandle;
-RingbufHandle_t log_bufferHandle;
+RingbufHandle_t can_bufferHandle = NULL;
+RingbufHandle_t log_bufferHandle = NULL;
+static TaskHandle_t sd_writer_task_handle = NULL;
 
-bool can_logging_paused = false;
-bool can_file_open = false;
-bool delete_can_file = false;
+bool sd_card_active = false;
 
-bool logging_paused = false;
-bool log_file_open = false;
-bool delete_log_file = false;
+// Ring buffer items are gathered here and written in large blocks, instead of a write and flush per item
+typedef struct {
+  uint8_t* data;
+  size_t size;
+  size_t used;
+  // Offset in the file where data starts, used to end blocks on sector boundaries
+  size_t file_offset;
+  // millis() when the oldest byte not yet on the card was added
+  unsigned long oldest_ms;
+} SD_write_block;
+
+// A log kept as numbered segment files in a directory, with an index of when each segment was started.
+// Only the SD writer touches the files, the other tasks set the flags and wait.
+typedef struct {
+  const char* dir;
+  const char* extension;
+  // Written at the start of every segment
+  const uint8_t* header;
+  size_t header_size;
+  uint64_t max_total_bytes;
+  SD_write_block block;
+  File file;
+  volatile bool open;
+  volatile bool paused;
+  volatile bool delete_requested;
+  // Set once a segment was started since boot, later opens append to the newest segment
+  bool started;
+  std::vector<Log_segment> segments;
+} SD_log_stream;
+
+static SD_log_stream can_stream = {.dir = CAN_LOG_DIR,
+                                   .extension = ".bin",
+                                   .header = (const uint8_t*)CAN_LOG_MAGIC,
+                                   .header_size = sizeof(CAN_LOG_MAGIC),
+                                   .max_total_bytes = SD_CAN_LOG_MAX_TOTAL_BYTES};
+static SD_log_stream log_stream = {.dir = LOG_DIR, .extension = ".txt", .max_total_bytes = SD_LOG_MAX_TOTAL_BYTES};
+
+#define SD_SECTOR_SIZE 512
+
+// Bytes written to the card since throughput_start_ms
+static uint32_t throughput_bytes = 0;
+static unsigned long throughput_start_ms = 0;
+
+// Added to time(nullptr) so segment start times keep increasing over reboots while the clock is not set
+static uint32_t log_clock_offset_s = 0;
+
+uint32_t sd_log_clock_s() {
+  return (uint32_t)time(nullptr) + log_clock_offset_s;
+}
 
-bool sd_card_active = false;
+static bool allocate_block(SD_write_block& block, size_t size) {
+  // PSRAM when the board has it, SD_MMC copies through an internal DMA buffer either way
+  block.data = (uint8_t*)heap_caps_malloc(size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+  if (block.data == NULL) {
+    block.data = (uint8_t*)heap_caps_malloc(size, MALLOC_CAP_8BIT);
+  }
+  block.size = (block.data != NULL) ? size : 0;
+  block.used = 0;
+  return block.data != NULL;
+}
 
-void delete_can_log() {
-  can_logging_paused = true;
-  delete_can_file = true;
+// Bytes that fit in the block before it ends on a sector boundary of the file
+static size_t block_room(const SD_write_block& block) {
+  const size_t end = block.size - ((block.file_offset + block.size) % SD_SECTOR_SIZE);
+  return (end > block.used) ? end - block.used : 0;
 }
 
-void resume_can_writing() {
-  can_logging_paused = false;
-  can_log_file = SD_MMC.open(CAN_LOG_FILE, FILE_APPEND);
-  can_file_open = true;
+static void flush_block(SD_log_stream& stream) {
+  SD_write_block& block = stream.block;
+  if (block.used == 0) {
+    return;
+  }
+
+  const int64_t start_us = esp_timer_get_time();
+  stream.file.write(block.data, block.used);
+  stream.file.flush();
+  const int64_t duration_us = esp_timer_get_time() - start_us;
+
+  auto& status = datalayer.system.status;
+  status.sd_write_max_us = max(status.sd_write_max_us, (uint32_t)duration_us);
+  throughput_bytes += block.used;
+  const unsigned long now = millis();
+  if (now - throughput_start_ms >= 1000) {
+    status.sd_write_bytes_per_s = (uint64_t)throughput_bytes * 1000 / (now - throughput_start_ms);
+    throughput_bytes = 0;
+    throughput_start_ms = now;
+  }
+
+  stream.segments.back().size += block.used;
+  block.file_offset += block.used;
+  block.used = 0;
 }
 
-void pause_can_writing() {
-  can_logging_paused = true;
+static void add_to_block(SD_log_stream& stream, const uint8_t* data, size_t size) {
+  SD_write_block& block = stream.block;
+  while (size > 0) {
+    if (block.used == 0) {
+      block.oldest_ms = millis();
+    }
+    size_t room = block_room(block);
+    if (room == 0) {
+      flush_block(stream);
+      continue;
+    }
+    const size_t chunk = min(room, size);
+    memcpy(block.data + block.used, data, chunk);
+    block.used += chunk;
+    data += chunk;
+    size -= chunk;
+  }
+  if (block_room(block) == 0 || millis() - block.oldest_ms >= SD_WRITE_FLUSH_INTERVAL_MS) {
+    flush_block(stream);
+  }
 }
 
-void delete_log() {
-  logging_paused = true;
-  if (log_file_open) {
-    log_file.close();
-    log_file_open = false;
+// Tracks the highest fill level of a ring buffer towards the SD card
+static void update_high_water(RingbufHandle_t handle, size_t total, uint32_t& high_water) {
+  const uint32_t used = total - xRingbufferGetCurFreeSize(handle);
+  if (used > high_water) {
+    high_water = used;
   }
-  SD_MMC.remove(LOG_FILE);
-  logging_paused = false;
 }
 
-void resume_log_writing() {
-  logging_paused = false;
-  log_file = SD_MMC.open(LOG_FILE, FILE_APPEND);
-  log_file_open = true;
+static String segment_path(const SD_log_stream& stream, uint32_t number) {
+  char name[16];
+  snprintf(name, sizeof(name), "/%08lu", (unsigned long)number);
+  return String(stream.dir) + name + stream.extension;
 }
 
-void pause_log_writing() {
-  logging_paused = true;
+static String index_path(const SD_log_stream& stream) {
+  return String(stream.dir) + "/index.csv";
 }
 
-void add_can_frame_to_buffer(CAN_frame frame, frameDirection msgDir) {
+static void write_index(const SD_log_stream& stream) {
+  File index = SD_MMC.open(index_path(stream), FILE_WRITE);
+  const std::string content = format_index(stream.segments);
+  index.write((const uint8_t*)content.data(), content.size());
+  index.close();
+}
 
-  if (!sd_card_active)
-    return;
+// Reads the index and the segment sizes, segments whose file is gone are forgotten
+static void load_segments(SD_log_stream& stream) {
+  SD_MMC.mkdir(stream.dir);
 
-  unsigned long currentTime = millis();
-  static char messagestr_buffer[32];
-  size_t size =
-      snprintf(messagestr_buffer + size, sizeof(messagestr_buffer) - size, "(%lu.%03lu) %s %X [%u] ",
-               currentTime / 1000, currentTime % 1000, (msgDir == MSG_RX ? "RX0" : "TX1"), frame.ID, frame.DLC);
+  std::string content;
+  File index = SD_MMC.open(index_path(stream), FILE_READ);
+  if (index) {
+    while (index.available()) {
+      content += (char)index.read();
+    }
+    index.close();
+  }
 
-  if (xRingbufferSend(can_bufferHandle, &messagestr_buffer, size, pdMS_TO_TICKS(2)) != pdTRUE) {
-    logging.println("Failed to send message to can ring buffer!");
-    return;
+  stream.segments.clear();
+  for (Log_segment& segment : parse_index(content)) {
+    File file = SD_MMC.open(segment_path(stream, segment.number), FILE_READ);
+    if (file) {
+      segment.size = file.size();
+      file.close();
+      stream.segments.push_back(segment);
+    }
+  }
+
+  if (!stream.segments.empty()) {
+    const uint32_t newest_s = stream.segments.back().start_s;
+    if ((int32_t)(newest_s + 1 - sd_log_clock_s()) > 0) {
+      log_clock_offset_s += newest_s + 1 - sd_log_clock_s();
+    }
+  }
+}
+
+// Deletes the oldest segments until the log fits its maximum size
+static void enforce_total_size(SD_log_stream& stream) {
+  const size_t drop = segments_to_drop(stream.segments, stream.max_total_bytes);
+  for (size_t i = 0; i < drop; i++) {
+    SD_MMC.remove(segment_path(stream, stream.segments[i].number));
+  }
+  stream.segments.erase(stream.segments.begin(), stream.segments.begin() + drop);
+}
+
+static void open_stream_file(SD_log_stream& stream) {
+  if (stream.started && !stream.segments.empty()) {
+    stream.file = SD_MMC.open(segment_path(stream, stream.segments.back().number), FILE_APPEND);
+  } else {
+    const uint32_t number = stream.segments.empty() ? 1 : stream.segments.back().number + 1;
+    stream.segments.push_back({number, sd_log_clock_s(), 0});
+    stream.file = SD_MMC.open(segment_path(stream, number), FILE_WRITE);
+    if (stream.header_size > 0) {
+      stream.file.write(stream.header, stream.header_size);
+      stream.segments.back().size = stream.header_size;
+    }
+    stream.started = true;
+    enforce_total_size(stream);
+    write_index(stream);
+  }
+  stream.block.file_offset = stream.file.size();
+  stream.open = true;
+}
+
+static void close_stream_file(SD_log_stream& stream) {
+  if (stream.open) {
+    flush_block(stream);
+    stream.file.close();
+    stream.open = false;
   }
+}
 
-  uint8_t i = 0;
-  for (i = 0; i < frame.DLC; i++) {
-    if (i < frame.DLC - 1)
-      size = snprintf(messagestr_buffer, sizeof(messagestr_buffer), "%02X ", frame.data.u8[i]);
-    else
-      size = snprintf(messagestr_buffer, sizeof(messagestr_buffer), "%02X\n", frame.data.u8[i]);
+static void delete_stream_files(SD_log_stream& stream) {
+  for (const Log_segment& segment : stream.segments) {
+    SD_MMC.remove(segment_path(stream, segment.number));
+  }
+  stream.segments.clear();
+  SD_MMC.remove(index_path(stream));
+  stream.started = false;
+}
 
-    if (xRingbufferSend(can_bufferHandle, &messagestr_buffer, size, pdMS_TO_TICKS(2)) != pdTRUE) {
-      logging.println("Failed to send message to can ring buffer!");
-      return;
+// Handles pause and delete requests and segment rotation, returns false while the stream is paused.
+// Called between ring buffer items only. The CAN ring holds one record per item, so every CAN segment starts
+// with its magic followed by a whole record and decodes on its own, also when the segment before it is deleted
+// or an export starts at it.
+static bool prepare_stream(SD_log_stream& stream) {
+  if (stream.paused) {
+    close_stream_file(stream);
+    if (stream.delete_requested) {
+      delete_stream_files(stream);
+      stream.delete_requested = false;
+      stream.paused = false;
     }
+    return !stream.paused;
+  }
+
+  if (stream.open && segment_should_rotate(stream.segments.back(), sd_log_clock_s(), SD_LOG_SEGMENT_MAX_BYTES,
+                                           SD_LOG_SEGMENT_MAX_AGE_S)) {
+    close_stream_file(stream);
+    stream.started = false;
   }
+  return true;
 }
 
-void write_can_frame_to_sdcard() {
+static void write_item(SD_log_stream& stream, const uint8_t* data, size_t size) {
+  if (!stream.open) {
+    open_stream_file(stream);
+  }
+  add_to_block(stream, data, size);
+}
 
-  if (!sd_card_active)
-    return;
+static void flush_if_old(SD_log_stream& stream) {
+  if (stream.open && stream.block.used > 0 && millis() - stream.block.oldest_ms >= SD_WRITE_FLUSH_INTERVAL_MS) {
+    flush_block(stream);
+  }
+}
 
-  size_t receivedMessageSize;
-  uint8_t* buffer = (uint8_t*)xRingbufferReceive(can_bufferHandle, &receivedMessageSize, pdMS_TO_TICKS(10));
+// Waits until the SD writer has written out what it buffered and closed the file, or until it times out
+static void wait_for_close(const SD_log_stream& stream) {
+  for (int i = 0; i < SD_WRITE_FLUSH_WAIT_MS && stream.open; i++) {
+    delay(1);
+  }
+}
 
-  if (buffer != NULL) {
+LogSegmentReader::LogSegmentReader(const char* dir, const char* extension, const std::vector<Log_segment>& segments,
+                                   size_t header_size) {
+  if (!segments.empty()) {
+    first_start_s = segments.front().start_s;
+  }
+  for (size_t i = 0; i < segments.size(); i++) {
+    char name[16];
+    snprintf(name, sizeof(name), "/%08lu", (unsigned long)segments[i].number);
+    // Only the first segment keeps its header, so the parts join into one valid log
+    const size_t skip = (i > 0) ? min((size_t)segments[i].size, header_size) : 0;
+    parts.push_back({String(dir) + name + extension, skip, skip, segments[i].size});
+    total_size += segments[i].size - skip;
+  }
+}
 
-    if (can_logging_paused) {
-      if (can_file_open) {
-        can_log_file.close();
-        can_file_open = false;
+size_t LogSegmentReader::read(uint8_t* buffer, size_t max_len) {
+  size_t done = 0;
+  while (done < max_len && current < parts.size()) {
+    Part& part = parts[current];
+    if (!file) {
+      file = SD_MMC.open(part.path, FILE_READ);
+      if (!file || !file.seek(part.offset)) {
+        file.close();
+        current++;
+        continue;
       }
-      if (delete_can_file) {
-        SD_MMC.remove(CAN_LOG_FILE);
-        delete_can_file = false;
-        can_logging_paused = false;
-      }
-      vRingbufferReturnItem(can_bufferHandle, (void*)buffer);
-      return;
     }
-
-    if (can_file_open == false) {
-      can_log_file = SD_MMC.open(CAN_LOG_FILE, FILE_APPEND);
-      can_file_open = true;
+    // Never past the size known when the export started, the newest segment may be growing
+    const size_t want = min(max_len - done, part.end - part.offset);
+    const int got = (want > 0) ? file.read(buffer + done, want) : 0;
+    if (got <= 0) {
+      file.close();
+      current++;
+      continue;
     }
+    part.offset += got;
+    done += got;
+  }
+  return done;
+}
 
-    can_log_file.write(buffer, receivedMessageSize);
-    can_log_file.flush();
+void LogSegmentReader::rewind() {
+  file.close();
+  for (Part& part : parts) {
+    part.offset = part.start;
+  }
+  current = 0;
+}
+
+std::shared_ptr<LogSegmentReader> export_can_log(uint32_t from_s, uint32_t to_s) {
+  pause_can_writing();
+  auto reader = std::make_shared<LogSegmentReader>(can_stream.dir, can_stream.extension,
+                                                   segments_in_range(can_stream.segments, from_s, to_s),
+                                                   can_stream.header_size);
+  resume_can_writing();
+  return reader;
+}
+
+std::shared_ptr<LogSegmentReader> export_log() {
+  pause_log_writing();
+  auto reader = std::make_shared<LogSegmentReader>(log_stream.dir, log_stream.extension, log_stream.segments,
+                                                   log_stream.header_size);
+  resume_log_writing();
+  return reader;
+}
+
+void delete_can_log() {
+  can_stream.paused = true;
+  can_stream.delete_requested = true;
+}
 
-    vRingbufferReturnItem(can_bufferHandle, (void*)buffer);
+void resume_can_writing() {
+  can_stream.paused = false;
+}
+
+void pause_can_writing() {
+  can_stream.paused = true;
+  wait_for_close(can_stream);
+}
+
+void delete_log() {
+  log_stream.paused = true;
+  log_stream.delete_requested = true;
+}
+
+void resume_log_writing() {
+  log_stream.paused = false;
+}
+
+void pause_log_writing() {
+  log_stream.paused = true;
+  wait_for_close(log_stream);
+}
+
+void add_can_frame_to_buffer(const CAN_frame& frame, CAN_Interface interface, frameDirection msgDir) {
+
+  if (!sd_card_active || can_bufferHandle == NULL)
+    return;
+
+  uint8_t record[CAN_LOG_RECORD_MAX_SIZE];
+  const size_t size = encode_can_log_record(frame, msgDir, interface, can_frame_log_time_us(frame), record);
+
+  // Never wait for the SD writer here, this runs on the core task
+  if (xRingbufferSend(can_bufferHandle, record, size, 0) != pdTRUE) {
+    datalayer.system.status.can_sd_log_drops++;
+  }
+}
+
+static void write_can_frame_to_sdcard(TickType_t max_wait) {
+
+  const bool writing = prepare_stream(can_stream);
+
+  update_high_water(can_bufferHandle, SD_CAN_RING_BUFFER_SIZE, datalayer.system.status.sd_can_buffer_high_water);
+
+  // One record per item, so records dropped while paused never leave a partial record in the file
+  const bool received = take_sd_ring_item(can_bufferHandle, max_wait, [&](const uint8_t* record, size_t size) {
+    if (writing && !can_stream.paused) {
+      write_item(can_stream, record, size);
+    }
+  });
+
+  if (!received) {
+    flush_if_old(can_stream);
   }
 }
 
 void add_log_to_buffer(const uint8_t* buffer, size_t size) {
 
-  if (!sd_card_active)
+  if (!sd_card_active || log_bufferHandle == NULL)
     return;
 
-  if (xRingbufferSend(log_bufferHandle, buffer, size, pdMS_TO_TICKS(1)) != pdTRUE) {
-    logging.println("Failed to send message to log ring buffer!");
-    return;
+  // Called from any task that logs, so never wait for the SD writer. Not logged, that would come right back here.
+  if (xRingbufferSend(log_bufferHandle, buffer, size, 0) != pdTRUE) {
+    datalayer.system.status.sd_log_drops++;
   }
 }
 
-void write_log_to_sdcard() {
+static void write_log_to_sdcard(TickType_t max_wait) {
 
-  if (!sd_card_active)
-    return;
+  const bool writing = prepare_stream(log_stream);
+
+  update_high_water(log_bufferHandle, SD_LOG_RING_BUFFER_SIZE, datalayer.system.status.sd_log_buffer_high_water);
 
   size_t receivedMessageSize;
-  uint8_t* buffer = (uint8_t*)xRingbufferReceive(log_bufferHandle, &receivedMessageSize, pdMS_TO_TICKS(10));
+  uint8_t* buffer = (uint8_t*)xRingbufferReceive(log_bufferHandle, &receivedMessageSize, max_wait);
 
   if (buffer != NULL) {
-
-    if (logging_paused) {
-      vRingbufferReturnItem(log_bufferHandle, (void*)buffer);
-      return;
+    if (writing && !log_stream.paused) {
+      write_item(log_stream, buffer, receivedMessageSize);
     }
+    vRingbufferReturnItem(log_bufferHandle, (void*)buffer);
+  } else {
+    flush_if_old(log_stream);
+  }
+}
 
-    if (log_file_open == false) {
-      log_file = SD_MMC.open(LOG_FILE, FILE_APPEND);
-      log_file_open = true;
-    }
+static void sd_writer_task(void*) {
+  esp_task_wdt_add(NULL);  // Register this task with WDT
 
-    log_file.write(buffer, receivedMessageSize);
-    log_file.flush();
-    vRingbufferReturnItem(log_bufferHandle, (void*)buffer);
+  // Blocks on the ring buffers, waking up now and then for time based flushes, rotation and pause requests
+  const bool both = can_bufferHandle != NULL && log_bufferHandle != NULL;
+  const TickType_t max_wait = pdMS_TO_TICKS(both ? SD_WRITER_IDLE_WAIT_MS / 4 : SD_WRITER_IDLE_WAIT_MS);
+
+  while (true) {
+    if (can_bufferHandle != NULL) {
+      write_can_frame_to_sdcard(max_wait);
+    }
+    if (log_bufferHandle != NULL) {
+      write_log_to_sdcard(max_wait);
+    }
+    esp_task_wdt_reset();  // Reset watchdog
   }
 }
 
 void init_logging_buffers() {
 
   if (datalayer.system.info.CAN_SD_logging_active) {
-    can_bufferHandle = xRingbufferCreate(32 * 1024, RINGBUF_TYPE_BYTEBUF);
-    if (can_bufferHandle == NULL) {
+    // Not a byte buffer, that hands out a record in two parts where it wraps
+    can_bufferHandle = xRingbufferCreate(SD_CAN_RING_BUFFER_SIZE, RINGBUF_TYPE_NOSPLIT);
+    if (can_bufferHandle == NULL || !allocate_block(can_stream.block, SD_CAN_WRITE_BLOCK_SIZE)) {
       logging.println("Failed to create CAN ring buffer!");
-      return;
+      can_bufferHandle = NULL;
     }
   }
 
   if (datalayer.system.info.SD_logging_active) {
-    log_bufferHandle = xRingbufferCreate(1024, RINGBUF_TYPE_BYTEBUF);
-    if (log_bufferHandle == NULL) {
+    log_bufferHandle = xRingbufferCreate(SD_LOG_RING_BUFFER_SIZE, RINGBUF_TYPE_BYTEBUF);
+    if (log_bufferHandle == NULL || !allocate_block(log_stream.block, SD_LOG_WRITE_BLOCK_SIZE)) {
       logging.println("Failed to create log ring buffer!");
-      return;
+      log_bufferHandle = NULL;
     }
   }
 }
 
+void init_sd_writer() {
+  if (!datalayer.system.info.CAN_SD_logging_active && !datalayer.system.info.SD_logging_active) {
+    return;
+  }
+
+  // The buffers come first, producers may start logging as soon as the card is marked active
+  init_logging_buffers();
+  if (can_bufferHandle == NULL && log_bufferHandle == NULL) {
+    return;
+  }
+
+  if (!init_sdcard()) {
+    return;
+  }
+
+  xTaskCreatePinnedToCore(sd_writer_task, "sd_writer", 4096, NULL, TASK_SD_WRITER_PRIO, &sd_writer_task_handle,
+                          esp32hal->SDCARD_CORE());
+}
+
 bool init_sdcard() {
   auto miso_pin = esp32hal->SD_MISO_PIN();
   auto mosi_pin = esp32hal->SD_MOSI_PIN();
@@ -194,6 +505,13 @@ bool init_sdcard() {
   clear_event(EVENT_SD_INIT_FAILED);
   logging.println("SD Card initialization successful.");
 
+  if (can_bufferHandle != NULL) {
+    load_segments(can_stream);
+  }
+  if (log_bufferHandle != NULL) {
+    load_segments(log_stream);
+  }
+
   sd_card_active = true;
 
   log_sdcard_details();
@@ -2,20 +2,52 @@
 #define SDCARD_H
 
 #include <SD_MMC.h>
+#include <memory>
+#include <vector>
 #include "../../communication/can/comm_can.h"
 #include "../hal/hal.h"
 #include "../utils/events.h"
+#include "log_segments.h"
 
-#define CAN_LOG_FILE "/canlog.txt"
-#define LOG_FILE "/log.txt"
+// Directories holding the log segments and their index.csv
+#define CAN_LOG_DIR "/canlog"
+#define LOG_DIR "/log"
+
+// Reads the segments picked for an export back to back, as one file
+class LogSegmentReader {
+ public:
+  LogSegmentReader(const char* dir, const char* extension, const std::vector<Log_segment>& segments,
+                   size_t header_size);
+  size_t size() const { return total_size; }
+  // Log clock when the first segment was started, 0 without segments
+  uint32_t start_s() const { return first_start_s; }
+  size_t read(uint8_t* buffer, size_t max_len);
+  // Starts reading from the beginning again, the same segments up to the same sizes
+  void rewind();
+
+ private:
+  struct Part {
+    String path;
+    size_t start;
+    size_t offset;
+    size_t end;
+  };
+  std::vector<Part> parts;
+  size_t current = 0;
+  size_t total_size = 0;
+  uint32_t first_start_s = 0;
+  File file;
+};
 
 void init_logging_buffers();
 
 bool init_sdcard();
 void log_sdcard_details();
 
-void add_can_frame_to_buffer(CAN_frame frame, frameDirection msgDir);
-void write_can_frame_to_sdcard();
+// Mounts the card and starts the task writing the logs enabled in the settings, on a core apart from core_loop
+void init_sd_writer();
+
+void add_can_frame_to_buffer(const CAN_frame& frame, CAN_Interface interface, frameDirection msgDir);
 
 void pause_can_writing();
 void resume_can_writing();
@@ -24,7 +56,12 @@ void delete_log();
 void resume_log_writing();
 void pause_log_writing();
 
+// Log clock the segment start times are in, seconds
+uint32_t sd_log_clock_s();
+// The CAN log segments holding frames from [from_s, to_s]
+std::shared_ptr<LogSegmentReader> export_can_log(uint32_t from_s, uint32_t to_s);
+std::shared_ptr<LogSegmentReader> export_log();
+
 void add_log_to_buffer(const uint8_t* buffer, size_t size);
-void write_log_to_sdcard();
 
 #endif  // SDCARD_H
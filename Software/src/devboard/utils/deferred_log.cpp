@@ -0,0 +1,178 @@
+#include "deferred_log.h"
+#include <stdio.h>
+
+static const size_t HEADER_SIZE = sizeof(uint32_t) + sizeof(const char*);
+
+void DeferredLogRecord::add_string(const char* str) {
+  if (str == nullptr) {
+    str = "(null)";
+  }
+  const size_t len = strnlen(str, DEFERRED_LOG_MAX_STRING);
+  if (used + 2 + len > sizeof(data)) {
+    used = sizeof(data);
+    return;
+  }
+  data[used] = DEFERRED_ARG_STRING;
+  data[used + 1] = len;
+  memcpy(data + used + 2, str, len);
+  used += 2 + len;
+}
+
+bool deferred_log_time(const uint8_t* record, size_t size, uint32_t& time_ms) {
+  if (size < HEADER_SIZE) {
+    return false;
+  }
+  memcpy(&time_ms, record, sizeof(time_ms));
+  return true;
+}
+
+// Walks the arguments of a record in order
+class ArgReader {
+ public:
+  ArgReader(const uint8_t* record, size_t size) : pos(record + HEADER_SIZE), end(record + size) {}
+
+  // Returns the type of the next argument, or 0 when there are none left
+  uint8_t peek() const { return pos < end ? *pos : 0; }
+
+  template <typename V>
+  V take() {
+    V value;
+    memcpy(&value, pos + 1, sizeof(value));
+    pos += 1 + sizeof(value);
+    return value;
+  }
+
+  // Copies a string argument into str, which must hold DEFERRED_LOG_MAX_STRING + 1 characters
+  void take_string(char* str) {
+    const size_t len = pos[1];
+    memcpy(str, pos + 2, len);
+    str[len] = '\0';
+    pos += 2 + len;
+  }
+
+  bool valid() const {
+    if (pos >= end) {
+      return true;
+    }
+    switch (*pos) {
+      case DEFERRED_ARG_INT32:
+        return end - pos >= 1 + 4;
+      case DEFERRED_ARG_INT64:
+      case DEFERRED_ARG_DOUBLE:
+        return end - pos >= 1 + 8;
+      case DEFERRED_ARG_POINTER:
+        return (size_t)(end - pos) >= 1 + sizeof(void*);
+      case DEFERRED_ARG_STRING:
+        return end - pos >= 2 && pos[1] <= DEFERRED_LOG_MAX_STRING && end - pos >= 2 + pos[1];
+      default:
+        return false;
+    }
+  }
+
+ private:
+  const uint8_t* pos;
+  const uint8_t* end;
+};
+
+// Length of the conversion specification starting at the '%' of fmt, 0 if it is not a complete one
+static size_t conversion_length(const char* fmt) {
+  size_t i = 1;
+  while (fmt[i] != '\0' && strchr("-+ #0123456789.*hlLqjzt", fmt[i]) != nullptr) {
+    i++;
+  }
+  return fmt[i] == '\0' ? 0 : i + 1;
+}
+
+size_t format_deferred_log(const uint8_t* record, size_t size, char* out, size_t out_size) {
+  if (out_size == 0) {
+    return 0;
+  }
+  out[0] = '\0';
+  if (size < HEADER_SIZE) {
+    return 0;
+  }
+
+  const char* fmt;
+  memcpy(&fmt, record + sizeof(uint32_t), sizeof(fmt));
+  ArgReader args(record, size);
+  size_t len = 0;
+
+  // Appends the snprintf() result, keeping len at the truncated length
+  auto append = [&](int written) {
+    if (written > 0) {
+      len += written;
+    }
+    if (len >= out_size) {
+      len = out_size - 1;
+    }
+  };
+
+  while (*fmt != '\0' && len < out_size - 1) {
+    if (*fmt != '%') {
+      out[len++] = *fmt++;
+      continue;
+    }
+    if (fmt[1] == '%') {
+      out[len++] = '%';
+      fmt += 2;
+      continue;
+    }
+
+    const size_t spec_len = conversion_length(fmt);
+    char spec[32];
+    if (spec_len == 0 || spec_len >= sizeof(spec)) {
+      // Not something printf would have consumed an argument for, copy it as is
+      out[len++] = *fmt++;
+      continue;
+    }
+
+    // Widths and precisions given as '*' come from the arguments, put them in the spec as digits
+    size_t spec_used = 0;
+    bool complete = true;
+    for (size_t i = 0; i < spec_len && complete; i++) {
+      if (fmt[i] != '*') {
+        spec[spec_used++] = fmt[i];
+      } else if (args.valid() && args.peek() == DEFERRED_ARG_INT32) {
+        spec_used += snprintf(spec + spec_used, sizeof(spec) - spec_used, "%d", (int)args.take<int32_t>());
+        complete = spec_used < sizeof(spec) - 1;
+      } else {
+        complete = false;
+      }
+    }
+    spec[spec_used] = '\0';
+
+    if (!complete || !args.valid() || args.peek() == 0) {
+      // The argument was dropped, show the conversion instead
+      append(snprintf(out + len, out_size - len, "%.*s", (int)spec_len, fmt));
+      fmt += spec_len;
+      continue;
+    }
+
+    char* dest = out + len;
+    const size_t room = out_size - len;
+    switch (args.peek()) {
+      case DEFERRED_ARG_INT32:
+        append(snprintf(dest, room, spec, args.take<int32_t>()));
+        break;
+      case DEFERRED_ARG_INT64:
+        append(snprintf(dest, room, spec, args.take<int64_t>()));
+        break;
+      case DEFERRED_ARG_DOUBLE:
+        append(snprintf(dest, room, spec, args.take<double>()));
+        break;
+      case DEFERRED_ARG_POINTER:
+        append(snprintf(dest, room, spec, args.take<const void*>()));
+        break;
+      case DEFERRED_ARG_STRING: {
+        char str[DEFERRED_LOG_MAX_STRING + 1];
+        args.take_string(str);
+        append(snprintf(dest, room, spec, str));
+        break;
+      }
+    }
+    fmt += spec_len;
+  }
+
+  out[len] = '\0';
+  return len;
+}
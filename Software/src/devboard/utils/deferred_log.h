@@ -0,0 +1,86 @@
+#ifndef __DEFERRED_LOG_H__
+#define __DEFERRED_LOG_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+/**
+ * A log call captured without formatting it: the format string pointer, a timestamp and the raw
+ * arguments, each behind a one byte type tag. Formatting happens later on a task that can afford it,
+ * with format_deferred_log(). The format string is kept by pointer and must be a string literal;
+ * string arguments are copied, up to DEFERRED_LOG_MAX_STRING characters.
+ *
+ * Arguments are stored with the size they had when passed through printf's varargs, so the formatter
+ * hands snprintf exactly what the original call would have. Arguments that don't fit are dropped and
+ * their conversions printed as they appear in the format string.
+ */
+
+#define DEFERRED_LOG_MAX_RECORD 128
+#define DEFERRED_LOG_MAX_STRING 48
+
+enum DeferredLogArg : uint8_t {
+  DEFERRED_ARG_INT32 = 1,
+  DEFERRED_ARG_INT64 = 2,
+  DEFERRED_ARG_DOUBLE = 3,
+  DEFERRED_ARG_STRING = 4,
+  DEFERRED_ARG_POINTER = 5,
+};
+
+class DeferredLogRecord {
+ public:
+  DeferredLogRecord(uint32_t time_ms, const char* fmt) {
+    memcpy(data, &time_ms, sizeof(time_ms));
+    memcpy(data + sizeof(time_ms), &fmt, sizeof(fmt));
+  }
+
+  template <typename T>
+  void add(T value) {
+    if constexpr (std::is_convertible_v<T, const char*>) {
+      add_string(value);
+    } else if constexpr (std::is_pointer_v<T>) {
+      add_raw(DEFERRED_ARG_POINTER, (const void*)value);
+    } else if constexpr (std::is_floating_point_v<T>) {
+      add_raw(DEFERRED_ARG_DOUBLE, (double)value);
+    } else if constexpr (std::is_integral_v<T> || std::is_enum_v<T>) {
+      // Everything smaller than an int is promoted to one by varargs
+      if constexpr (sizeof(T) <= sizeof(int32_t)) {
+        add_raw(DEFERRED_ARG_INT32, (int32_t)value);
+      } else {
+        add_raw(DEFERRED_ARG_INT64, (int64_t)value);
+      }
+    } else {
+      static_assert(sizeof(T) == 0, "Unsupported deferred log argument");
+    }
+  }
+
+  const uint8_t* bytes() const { return data; }
+  size_t size() const { return used; }
+
+ private:
+  template <typename V>
+  void add_raw(DeferredLogArg type, V value) {
+    if (used + 1 + sizeof(value) > sizeof(data)) {
+      used = sizeof(data);  // Later arguments are dropped too, they would end up in the wrong conversions
+      return;
+    }
+    data[used] = type;
+    memcpy(data + used + 1, &value, sizeof(value));
+    used += 1 + sizeof(value);
+  }
+
+  void add_string(const char* str);
+
+  uint8_t data[DEFERRED_LOG_MAX_RECORD];
+  size_t used = sizeof(uint32_t) + sizeof(const char*);
+};
+
+// Reads the timestamp of a record, or returns false if it is too short to be one
+bool deferred_log_time(const uint8_t* record, size_t size, uint32_t& time_ms);
+
+// Formats a record like snprintf() would have at the time of the call. Returns the length written to out,
+// which is always NUL terminated and truncated to out_size - 1 characters.
+size_t format_deferred_log(const uint8_t* record, size_t size, char* out, size_t out_size);
+
+#endif  // __DEFERRED_LOG_H__
@@ -0,0 +1,155 @@
+#ifndef __LOG_RING_H__
+#define __LOG_RING_H__
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+/**
+ * Lock-free ring of variable length records for any number of producers, on any task or core, and any
+ * number of readers. Producers mark the slot at head as being written and reserve it by moving head with
+ * a compare-and-swap, then copy their record in and publish it by writing its position into the record
+ * header. When full, new records overwrite the oldest ones, one record at a time.
+ *
+ * Readers keep their own cursor, a position in the ring, and never block producers. A record changed
+ * while it is read is detected and skipped, like records overwritten before the reader got to them.
+ * A producer stalled for a whole lap of the ring can still corrupt the record written over its slot.
+ * Size must be a power of two.
+ */
+template <size_t Size>
+class LogRing {
+  static_assert(Size >= 64 && (Size & (Size - 1)) == 0, "LogRing size must be a power of two");
+
+ public:
+  /** Longest record accepted by write() */
+  static constexpr size_t MAX_RECORD = Size / 4 - 8;
+
+  // Position 0 is the only one a zeroed buffer would claim to hold a record for
+  LogRing() { tag(buffer).store(~0u, std::memory_order_relaxed); }
+
+  /** Producer side, safe from any task. Returns false if the record is longer than MAX_RECORD */
+  bool write(const void* data, size_t len) {
+    if (len > MAX_RECORD) {
+      return false;
+    }
+    if (len == 0) {
+      return true;
+    }
+    const uint32_t size = record_size(len);
+    uint32_t start = head.load(std::memory_order_relaxed);
+    uint32_t pad;
+    do {
+      // Records never wrap around the end of the buffer, the rest of it is filled with padding instead
+      const uint32_t offset = start & (Size - 1);
+      pad = (offset + size > Size) ? Size - offset : 0;
+      // Readers never see head past a slot that still holds the tag of an earlier lap
+      mark_being_written(start);
+    } while (!head.compare_exchange_weak(start, start + pad + size, std::memory_order_release,
+                                         std::memory_order_relaxed));
+
+    // The record goes first, readers wait at the padding until both are done
+    publish(start + pad, data, len, 0);
+    if (pad > 0) {
+      publish(start, nullptr, pad - HEADER, FLAG_PADDING);
+    }
+    return true;
+  }
+
+  /** Cursor at the oldest data still kept. Reading from here returns every record that was not overwritten. */
+  uint32_t oldest() const {
+    const uint32_t head_now = head.load(std::memory_order_acquire);
+    return (head_now < Size) ? 0 : head_now - Size;
+  }
+
+  /** Cursor after the newest record, reading from here only returns records written later */
+  uint32_t newest() const { return head.load(std::memory_order_acquire); }
+
+  /**
+   * Copies the record at cursor into out, up to max_len bytes, and moves cursor past it. Returns the
+   * length copied, or 0 when there is no complete record to read yet. Records overwritten before they
+   * could be read are skipped.
+   */
+  size_t read(uint32_t& cursor, void* out, size_t max_len) const {
+    while (true) {
+      const uint32_t head_now = head.load(std::memory_order_acquire);
+      if (head_now - cursor > Size) {
+        cursor = head_now - Size;
+      }
+      if (cursor == head_now) {
+        return 0;
+      }
+
+      const uint32_t offset = cursor & (Size - 1);
+      const uint8_t* slot = buffer + offset;
+      const uint32_t tag_now = tag(slot).load(std::memory_order_acquire);
+      if (tag_now == cursor + 1) {
+        return 0;  // Still being written
+      }
+      if (tag_now != cursor) {
+        // Not the start of a current record, search forward for one
+        cursor += ALIGN;
+        continue;
+      }
+
+      uint16_t len, flags;
+      memcpy(&len, slot + 4, sizeof(len));
+      memcpy(&flags, slot + 6, sizeof(flags));
+      const bool sane = offset + record_size(len) <= Size;
+      const size_t copied = (!sane || (flags & FLAG_PADDING)) ? 0 : (len < max_len ? len : max_len);
+      memcpy(out, slot + HEADER, copied);
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (!sane || tag(slot).load(std::memory_order_relaxed) != cursor) {
+        // Overwritten while we were reading it
+        cursor += ALIGN;
+        continue;
+      }
+
+      cursor += record_size(len);
+      if (!(flags & FLAG_PADDING)) {
+        return copied;
+      }
+    }
+  }
+
+  static constexpr size_t capacity() { return Size; }
+
+ private:
+  static constexpr uint32_t HEADER = 8;
+  static constexpr uint32_t ALIGN = 8;
+  static constexpr uint16_t FLAG_PADDING = 1;
+
+  static uint32_t record_size(size_t len) { return (HEADER + len + ALIGN - 1) & ~(ALIGN - 1); }
+
+  // The first four bytes of a record hold its position once complete, and the position + 1 while written
+  static std::atomic_ref<uint32_t> tag(const uint8_t* slot) { return std::atomic_ref<uint32_t>(*(uint32_t*)slot); }
+
+  // Every producer trying to reserve position marks it the same way, a tag this lap already wrote is kept
+  void mark_being_written(uint32_t position) {
+    std::atomic_ref<uint32_t> slot_tag = tag(buffer + (position & (Size - 1)));
+    // Acquire and release, so the mark of another producer is passed on to readers by the one moving head
+    uint32_t tag_now = slot_tag.load(std::memory_order_acquire);
+    if ((int32_t)(position - tag_now) > 0) {
+      slot_tag.compare_exchange_strong(tag_now, position + 1, std::memory_order_acq_rel, std::memory_order_acquire);
+    }
+  }
+
+  void publish(uint32_t position, const void* data, size_t len, uint16_t flags) {
+    uint8_t* slot = buffer + (position & (Size - 1));
+    tag(slot).store(position + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    const uint16_t len16 = len;
+    memcpy(slot + 4, &len16, sizeof(len16));
+    memcpy(slot + 6, &flags, sizeof(flags));
+    if (data != nullptr) {
+      memcpy(slot + HEADER, data, len);
+    }
+    tag(slot).store(position, std::memory_order_release);
+  }
+
+  alignas(8) uint8_t buffer[Size] = {};
+  // Free running position where the next record goes, wrapping is harmless as Size divides 2^32
+  std::atomic<uint32_t> head{0};
+};
+
+#endif  // __LOG_RING_H__
@@ -1,88 +1,140 @@
 #include "logging.h"
 #include "../../datalayer/datalayer.h"
+#include "../hal/hal.h"
 #include "../sdcard/sdcard.h"
+#include "log_ring.h"
 
 #define MAX_LINE_LENGTH_PRINTF 128
 #define MAX_LENGTH_TIME_STR 14
 
-bool previous_message_was_newline = true;
-
-void Logging::add_timestamp(size_t size) {
-  // Check if any logging is enabled at runtime
-  if (!datalayer.system.info.web_logging_active && !datalayer.system.info.usb_logging_active) {
-    return;
+// Per task, so a line is only timestamped when the task writing it ended its previous one
+static thread_local bool previous_message_was_newline = true;
+
+// Loaded by init_stored_settings(), logging is off until then anyway
+volatile uint8_t log_module_levels[LOG_MODULE_COUNT] = {};
+
+const char* name_for_log_module(LogModule module) {
+  switch (module) {
+    case LOG_MODULE_SYSTEM:
+      return "System";
+    case LOG_MODULE_CAN:
+      return "CAN";
+    case LOG_MODULE_CHARGER:
+      return "Charger";
+    case LOG_MODULE_WIFI:
+      return "Wi-Fi";
+    case LOG_MODULE_WEBSERVER:
+      return "Webserver";
+    case LOG_MODULE_NVM:
+      return "Settings storage";
+    default:
+      return nullptr;
   }
+}
 
-  char* message_string = datalayer.system.info.logged_can_messages;
-  int offset = datalayer.system.info.logged_can_messages_offset;  // Keeps track of the current position in the buffer
-  size_t message_string_size = sizeof(datalayer.system.info.logged_can_messages);
-  unsigned long currentTime = millis();
-  char* timestr;
-  static char timestr_buffer[MAX_LENGTH_TIME_STR];
+const char* name_for_log_level(LogLevel level) {
+  switch (level) {
+    case LOG_LEVEL_NONE:
+      return "Off";
+    case LOG_LEVEL_ERROR:
+      return "Error";
+    case LOG_LEVEL_WARN:
+      return "Warning";
+    case LOG_LEVEL_INFO:
+      return "Info";
+    case LOG_LEVEL_DEBUG:
+      return "Debug";
+    case LOG_LEVEL_TRACE:
+      return "Trace";
+    default:
+      return nullptr;
+  }
+}
 
-  if (datalayer.system.info.web_logging_active) {
-    if (!datalayer.system.info.can_logging_active) {
-      /* If web debug is active and can logging is inactive, 
-       * we use the debug logging memory directly for writing the timestring */
-      if (offset + size + MAX_LENGTH_TIME_STR > message_string_size) {
-        offset = 0;
-      }
-      timestr = datalayer.system.info.logged_can_messages + offset;
-    } else {
-      timestr = timestr_buffer;
-    }
-  } else {
-    timestr = timestr_buffer;
+const char* log_level_setting(LogModule module) {
+  //  ATTENTION ! The maximum length for settings keys is 15 characters
+  switch (module) {
+    case LOG_MODULE_SYSTEM:
+      return "LOGLVLSYS";
+    case LOG_MODULE_CAN:
+      return "LOGLVLCAN";
+    case LOG_MODULE_CHARGER:
+      return "LOGLVLCHG";
+    case LOG_MODULE_WIFI:
+      return "LOGLVLWIFI";
+    case LOG_MODULE_WEBSERVER:
+      return "LOGLVLWEB";
+    case LOG_MODULE_NVM:
+      return "LOGLVLNVM";
+    default:
+      return nullptr;
   }
+}
 
-  offset += min(MAX_LENGTH_TIME_STR - 1,
-                snprintf(timestr, MAX_LENGTH_TIME_STR, "%8lu.%03lu ", currentTime / 1000, currentTime % 1000));
+// Written from every task that logs, read by the webserver
+static LogRing<WEB_LOG_BUFFER_SIZE> web_log;
 
-  if (datalayer.system.info.web_logging_active && !datalayer.system.info.can_logging_active) {
-    datalayer.system.info.logged_can_messages_offset = offset;  // Update offset in buffer
-  }
+#if DEFERRED_LOGGING
+// Written from every task that logs, read by the formatting task only
+static LogRing<DEFERRED_LOG_BUFFER_SIZE> deferred_log;
+static bool deferred_message_was_newline = true;
+#endif
+
+uint32_t web_log_oldest() {
+  return web_log.oldest();
+}
+
+size_t read_web_log(uint32_t& cursor, char* out, size_t max_len) {
+  return web_log.read(cursor, out, max_len);
+}
 
+void Logging::output(const char* buffer, size_t size) {
   // LOG_TO_SD remains as compile-time option for now
 #ifdef LOG_TO_SD
-  add_log_to_buffer((uint8_t*)timestr, MAX_LENGTH_TIME_STR);
+  add_log_to_buffer((const uint8_t*)buffer, size);
 #endif  // LOG_TO_SD
 
   if (datalayer.system.info.usb_logging_active) {
-    Serial.write(timestr);
-  }
-}
-
-size_t Logging::write(const uint8_t* buffer, size_t size) {
-  // Check if any logging is enabled at runtime
-  if (!datalayer.system.info.web_logging_active && !datalayer.system.info.usb_logging_active) {
-    return 0;
+    Serial.write((const uint8_t*)buffer, size);
   }
 
-  if (previous_message_was_newline) {
-    add_timestamp(size);
+  if (datalayer.system.info.web_logging_active) {
+    // Longer writes are split into records the ring accepts
+    for (size_t done = 0; done < size; done += web_log.MAX_RECORD) {
+      web_log.write(buffer + done, min(size - done, web_log.MAX_RECORD));
+    }
   }
+}
 
-#ifdef LOG_TO_SD
-  add_log_to_buffer(buffer, size);
-#endif
+size_t Logging::format_timestamp(unsigned long time_ms, char* out) {
+  int len = snprintf(out, MAX_LENGTH_TIME_STR, "%8lu.%03lu ", time_ms / 1000, time_ms % 1000);
+  return min(len, MAX_LENGTH_TIME_STR - 1);
+}
 
-  if (datalayer.system.info.usb_logging_active) {
-    Serial.write(buffer, size);
+void Logging::output_with_timestamp(unsigned long time_ms, bool& was_newline, const char* text, size_t size) {
+  // Timestamp and text go out in one piece, so lines other tasks log at the same time can't come in between
+  char line[MAX_LENGTH_TIME_STR + MAX_LINE_LENGTH_PRINTF];
+  const size_t used = was_newline ? format_timestamp(time_ms, line) : 0;
+  const size_t chunk = min(size, sizeof(line) - used);
+  memcpy(line + used, text, chunk);
+  output(line, used + chunk);
+  if (chunk < size) {
+    output(text + chunk, size - chunk);
   }
 
-  if (datalayer.system.info.web_logging_active && !datalayer.system.info.can_logging_active) {
-    char* message_string = datalayer.system.info.logged_can_messages;
-    int offset = datalayer.system.info.logged_can_messages_offset;  // Keeps track of the current position in the buffer
-    size_t message_string_size = sizeof(datalayer.system.info.logged_can_messages);
+  was_newline = text[size - 1] == '\n';
+}
 
-    if (offset + size > message_string_size) {
-      offset = 0;
-    }
-    memcpy(message_string + offset, buffer, size);
-    datalayer.system.info.logged_can_messages_offset = offset + size;  // Update offset in buffer
+size_t Logging::write(const uint8_t* buffer, size_t size) {
+  // Check if any logging is enabled at runtime
+  if (!datalayer.system.info.web_logging_active && !datalayer.system.info.usb_logging_active) {
+    return 0;
+  }
+  if (size == 0) {
+    return 0;
   }
 
-  previous_message_was_newline = buffer[size - 1] == '\n';
+  output_with_timestamp(millis(), previous_message_was_newline, (const char*)buffer, size);
   return size;
 }
 
@@ -92,50 +144,68 @@ void Logging::printf(const char* fmt, ...) {
     return;
   }
 
-  if (previous_message_was_newline) {
-    add_timestamp(MAX_LINE_LENGTH_PRINTF);
-  }
-
-  char* message_string = datalayer.system.info.logged_can_messages;
-  size_t message_string_size = sizeof(datalayer.system.info.logged_can_messages);
-  int offset = datalayer.system.info.logged_can_messages_offset;  // Keeps track of the current position in the buffer
-  static char buffer[MAX_LINE_LENGTH_PRINTF];
-  char* message_buffer;
-
-  if (datalayer.system.info.web_logging_active) {
-    if (!datalayer.system.info.can_logging_active) {
-      /* If web debug is active and can logging is inactive, 
-       * we use the debug logging memory directly for writing the output */
-      if (offset + MAX_LINE_LENGTH_PRINTF > message_string_size) {
-        // Not enough space, reset and start from the beginning
-        offset = 0;
-      }
-      message_buffer = message_string + offset;
-    } else {
-      message_buffer = buffer;
-    }
-  } else {
-    message_buffer = buffer;
-  }
+  // Formatted right after the timestamp, so both go out in one piece
+  char line[MAX_LENGTH_TIME_STR + MAX_LINE_LENGTH_PRINTF];
+  const size_t used = previous_message_was_newline ? format_timestamp(millis(), line) : 0;
+  char* message_buffer = line + used;
 
   va_list(args);
   va_start(args, fmt);
   int size = min(MAX_LINE_LENGTH_PRINTF - 1, vsnprintf(message_buffer, MAX_LINE_LENGTH_PRINTF, fmt, args));
   va_end(args);
+  if (size <= 0) {
+    return;
+  }
 
-#ifdef LOG_TO_SD
-  add_log_to_buffer((uint8_t*)message_buffer, size);
-#endif  // LOG_TO_SD
+  output(line, used + size);
 
-  if (datalayer.system.info.usb_logging_active) {
-    Serial.write(message_buffer, size);
+  previous_message_was_newline = message_buffer[size - 1] == '\n';
+}
+
+#if DEFERRED_LOGGING
+void Logging::write_deferred(const DeferredLogRecord& record) {
+  deferred_log.write(record.bytes(), record.size());
+}
+
+void Logging::flush_deferred() {
+  static uint32_t cursor = 0;
+  uint8_t record[DEFERRED_LOG_MAX_RECORD];
+  char message_buffer[MAX_LINE_LENGTH_PRINTF];
+  uint32_t time_ms;
+
+  size_t record_size;
+  while ((record_size = deferred_log.read(cursor, record, sizeof(record))) > 0) {
+    // Messages may have been queued before logging was turned off
+    if (!datalayer.system.info.web_logging_active && !datalayer.system.info.usb_logging_active) {
+      continue;
+    }
+    if (!deferred_log_time(record, record_size, time_ms)) {
+      continue;
+    }
+    size_t size = format_deferred_log(record, record_size, message_buffer, sizeof(message_buffer));
+    if (size == 0) {
+      continue;
+    }
+
+    output_with_timestamp(time_ms, deferred_message_was_newline, message_buffer, size);
   }
+}
 
-  if (datalayer.system.info.web_logging_active && !datalayer.system.info.can_logging_active) {
-    // Data was already added to buffer, just move offset
-    datalayer.system.info.logged_can_messages_offset =
-        offset + size;  // Keeps track of the current position in the buffer
+static void log_formatter_task(void*) {
+  while (true) {
+    logging.flush_deferred();
+    vTaskDelay(pdMS_TO_TICKS(DEFERRED_LOG_INTERVAL_MS));
   }
+}
 
-  previous_message_was_newline = message_buffer[size - 1] == '\n';
+void init_deferred_logging() {
+  xTaskCreatePinnedToCore(log_formatter_task, "log_formatter", 4096, NULL, TASK_LOG_FORMATTER_PRIO, NULL,
+                          esp32hal->WIFICORE());
 }
+#else
+void Logging::write_deferred(const DeferredLogRecord& record) {}
+
+void Logging::flush_deferred() {}
+
+void init_deferred_logging() {}
+#endif  // DEFERRED_LOGGING
@@ -4,34 +4,100 @@
 #include <inttypes.h>
 #include "../../datalayer/datalayer.h"
 #include "Print.h"
+#include "deferred_log.h"
 #include "types.h"
 
+enum LogLevel : uint8_t {
+  LOG_LEVEL_NONE = 0,
+  LOG_LEVEL_ERROR = 1,
+  LOG_LEVEL_WARN = 2,
+  LOG_LEVEL_INFO = 3,
+  LOG_LEVEL_DEBUG = 4,
+  LOG_LEVEL_TRACE = 5,
+};
+
+// Parts of the firmware with their own runtime log level. Messages from DEBUG_PRINTF go to SYSTEM.
+enum LogModule : uint8_t {
+  LOG_MODULE_SYSTEM = 0,
+  LOG_MODULE_CAN,
+  LOG_MODULE_CHARGER,
+  LOG_MODULE_WIFI,
+  LOG_MODULE_WEBSERVER,
+  LOG_MODULE_NVM,
+  LOG_MODULE_COUNT
+};
+
+// Most verbose level logged per module, changed at runtime from the settings page
+extern volatile uint8_t log_module_levels[LOG_MODULE_COUNT];
+
+const char* name_for_log_module(LogModule module);
+const char* name_for_log_level(LogLevel level);
+// Key under which the level of a module is stored in the settings
+const char* log_level_setting(LogModule module);
+
 #ifndef UNIT_TEST
 // Real implementation for production
+#include <Arduino.h>
 
 class Logging : public Print {
-  void add_timestamp(size_t size);
+  // Writes the timestamp a line starts with to out, which must hold MAX_LENGTH_TIME_STR bytes. Returns its length.
+  size_t format_timestamp(unsigned long time_ms, char* out);
+  // Outputs text with the timestamp in front if it starts a line, as one piece
+  void output_with_timestamp(unsigned long time_ms, bool& was_newline, const char* text, size_t size);
+  // Sends text to the SD card, USB and web logs that are enabled
+  void output(const char* buffer, size_t size);
+  void write_deferred(const DeferredLogRecord& record);
 
  public:
   virtual size_t write(const uint8_t* buffer, size_t size);
   virtual size_t write(uint8_t) { return 0; }
   void printf(const char* fmt, ...);
+
+  // Like printf, but only stores the arguments, see DEFERRED_LOGGING. fmt must be a string literal.
+  template <typename... Args>
+  void deferred_printf(const char* fmt, Args... args) {
+    DeferredLogRecord record(millis(), fmt);
+    (record.add(args), ...);
+    write_deferred(record);
+  }
+  // Formats the stored messages and outputs them, called by the formatting task
+  void flush_deferred();
+
   Logging() {}
 };
 
 // Production macros
-#define DEBUG_PRINTF(fmt, ...)                                                                  \
-  do {                                                                                          \
-    if (datalayer.system.info.web_logging_active || datalayer.system.info.usb_logging_active) { \
-      logging.printf(fmt, ##__VA_ARGS__);                                                       \
-    }                                                                                           \
+#if DEFERRED_LOGGING
+// Pasting "" in front makes anything but a string literal format a compile error
+#define LOG_OUTPUT(fmt, ...) logging.deferred_printf("" fmt, ##__VA_ARGS__)
+#else
+#define LOG_OUTPUT(fmt, ...) logging.printf(fmt, ##__VA_ARGS__)
+#endif
+
+#define LOG_ENABLED(level, module)                                                         \
+  ((level) <= LOG_LEVEL_COMPILED && log_module_levels[module] >= (level) &&                \
+   (datalayer.system.info.web_logging_active || datalayer.system.info.usb_logging_active))
+
+// Levels above LOG_LEVEL_COMPILED are removed by the compiler, arguments included
+#define LOG_AT(level, tag, module, fmt, ...)               \
+  do {                                                     \
+    if (LOG_ENABLED(level, LOG_MODULE_##module)) {         \
+      LOG_OUTPUT(tag "/" #module ": " fmt, ##__VA_ARGS__); \
+    }                                                      \
+  } while (0)
+
+#define DEBUG_PRINTF(fmt, ...)                            \
+  do {                                                    \
+    if (LOG_ENABLED(LOG_LEVEL_INFO, LOG_MODULE_SYSTEM)) { \
+      LOG_OUTPUT(fmt, ##__VA_ARGS__);                     \
+    }                                                     \
   } while (0)
 
-#define DEBUG_PRINTLN(str)                                                                      \
-  do {                                                                                          \
-    if (datalayer.system.info.web_logging_active || datalayer.system.info.usb_logging_active) { \
-      logging.println(str);                                                                     \
-    }                                                                                           \
+#define DEBUG_PRINTLN(str)                                \
+  do {                                                    \
+    if (LOG_ENABLED(LOG_LEVEL_INFO, LOG_MODULE_SYSTEM)) { \
+      logging.println(str);                               \
+    }                                                     \
   } while (0)
 
 #else
@@ -107,9 +173,30 @@ class Logging {
 #define DEBUG_PRINT(fmt, ...) ((void)0)
 #define DEBUG_PRINTF(fmt, ...) ((void)0)
 #define DEBUG_PRINTLN(str) ((void)0)
+// Keeps the arguments referenced, without evaluating them
+#define LOG_AT(level, tag, module, fmt, ...) \
+  do {                                       \
+    if (0) {                                 \
+      Logging::printf(fmt, ##__VA_ARGS__);   \
+    }                                        \
+  } while (0)
 
 #endif
 
+// Levelled logging, for example LOG_WARN(CHARGER, "No reply from charger\n")
+#define LOG_ERROR(module, fmt, ...) LOG_AT(LOG_LEVEL_ERROR, "E", module, fmt, ##__VA_ARGS__)
+#define LOG_WARN(module, fmt, ...) LOG_AT(LOG_LEVEL_WARN, "W", module, fmt, ##__VA_ARGS__)
+#define LOG_INFO(module, fmt, ...) LOG_AT(LOG_LEVEL_INFO, "I", module, fmt, ##__VA_ARGS__)
+#define LOG_DEBUG(module, fmt, ...) LOG_AT(LOG_LEVEL_DEBUG, "D", module, fmt, ##__VA_ARGS__)
+#define LOG_TRACE(module, fmt, ...) LOG_AT(LOG_LEVEL_TRACE, "T", module, fmt, ##__VA_ARGS__)
+
 extern Logging logging;
 
+// Starts the task formatting deferred log messages
+void init_deferred_logging();
+
+// Reads the web debug log one record at a time, starting at web_log_oldest(). Returns 0 when all has been read.
+uint32_t web_log_oldest();
+size_t read_web_log(uint32_t& cursor, char* out, size_t max_len);
+
 #endif  // __LOGGING_H__
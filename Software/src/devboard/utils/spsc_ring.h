@@ -0,0 +1,53 @@
+#ifndef __SPSC_RING_H__
+#define __SPSC_RING_H__
+
+#include <atomic>
+#include <cstddef>
+
+/**
+ * Lock-free ring buffer for exactly one producer and one consumer, which may run in different
+ * tasks or on different cores. The producer only writes head, the consumer only writes tail, so
+ * no locks or critical sections are needed. Size must be a power of two.
+ */
+template <typename T, size_t Size>
+class SpscRing {
+  static_assert(Size >= 2 && (Size & (Size - 1)) == 0, "SpscRing size must be a power of two");
+
+ public:
+  /** Producer side. Returns false and leaves the ring untouched if it is full */
+  bool push(const T& item) {
+    const size_t head_now = head.load(std::memory_order_relaxed);
+    if (head_now - tail.load(std::memory_order_acquire) >= Size) {
+      return false;
+    }
+    buffer[head_now & (Size - 1)] = item;
+    head.store(head_now + 1, std::memory_order_release);
+    return true;
+  }
+
+  /** Consumer side. Returns false if the ring is empty */
+  bool pop(T& item) {
+    const size_t tail_now = tail.load(std::memory_order_relaxed);
+    if (head.load(std::memory_order_acquire) == tail_now) {
+      return false;
+    }
+    item = buffer[tail_now & (Size - 1)];
+    tail.store(tail_now + 1, std::memory_order_release);
+    return true;
+  }
+
+  /** Number of items waiting. Exact only when called from the producer or the consumer */
+  size_t count() const { return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire); }
+
+  bool empty() const { return count() == 0; }
+
+  static constexpr size_t capacity() { return Size; }
+
+ private:
+  T buffer[Size];
+  // Free running counters, wrapping is harmless as only their difference is used
+  std::atomic<size_t> head{0};
+  std::atomic<size_t> tail{0};
+};
+
+#endif  // __SPSC_RING_H__
@@ -84,6 +84,8 @@ typedef struct {
     uint32_t u32[2];
     uint64_t u64;
   } data;
+  // esp_timer_get_time() when the frame was received, 0 for frames created locally
+  int64_t timestamp_us;
 } CAN_frame;
 
 enum frameDirection { MSG_RX, MSG_TX };  //RX = 0, TX = 1
@@ -1,15 +1,15 @@
 #include "can_logging_html.h"
 #include <Arduino.h>
+#include "../../communication/can/comm_can.h"
 #include "../../datalayer/datalayer.h"
 #include "index_html.h"
 
 String can_logger_processor(void) {
   if (!datalayer.system.info.can_logging_active) {
-    datalayer.system.info.logged_can_messages_offset = 0;
-    datalayer.system.info.logged_can_messages[0] = '\0';
+    clear_web_can_log();
   }
-  datalayer.system.info.can_logging_active =
-      true;  // Signal to main loop that we should log messages. Disabled by default for performance reasons
+  // Signal to main loop that we should log messages. Disabled by default for performance reasons
+  set_web_can_logging(true);
   String content = index_html_header;
   // Page format
   content += "<style>";
@@ -23,7 +23,14 @@ String can_logger_processor(void) {
       "monospace; }";
   content += "</style>";
   content += "<button onclick='refreshPage()'>Refresh data</button> ";
-  content += "<button onclick='exportLog()'>Export to .txt</button> ";
+  if (datalayer.system.info.CAN_SD_logging_active) {
+    // The SD card log is binary, tools/canlog_convert.cpp turns it into text
+    content += "<button onclick='exportLog()'>Export to .bin</button> ";
+    content += "<input type='number' id='exportMinutes' min='1' value='10' style='width: 60px'> ";
+    content += "<button onclick='exportRecent()'>Export last minutes</button> ";
+  } else {
+    content += "<button onclick='exportLog()'>Export to .txt</button> ";
+  }
 #ifdef LOG_CAN_TO_SD
   content += "<button onclick='deleteLogFile()'>Delete log file</button> ";
 #endif
@@ -33,20 +40,16 @@ String can_logger_processor(void) {
   content += "<div style='background-color: #303E47; padding: 20px; border-radius: 15px'>";
 
   // Check for messages
-  if (datalayer.system.info.logged_can_messages[0] == 0) {
+  if (web_can_log_empty()) {
     content += "CAN logger started! Refresh page to display incoming(RX) and outgoing(TX) messages";
   } else {
-    // Split the messages using the newline character
-    String messages = String(datalayer.system.info.logged_can_messages);
-    int startIndex = 0;
-    int endIndex = messages.indexOf('\n');
-    while (endIndex != -1) {
-      // Extract a single message and wrap it in a styled div
-      String singleMessage = messages.substring(startIndex, endIndex);
-      content += "<div class='can-message'>" + singleMessage + "</div>";
-      startIndex = endIndex + 1;  // Move past the newline character
-      endIndex = messages.indexOf('\n', startIndex);
-    }
+    // Each frame wrapped in a styled div, without its newline
+    for_each_web_can_log_line([&content](const char* line, size_t len) {
+      content += "<div class='can-message'>";
+      content.concat(line, len > 0 ? len - 1 : 0);
+      content += "</div>";
+      return true;
+    });
   }
 
   content += "</div>";
@@ -55,6 +58,11 @@ String can_logger_processor(void) {
   content += "<script>";
   content += "function refreshPage(){ location.reload(true); }";
   content += "function exportLog() { window.location.href = '/export_can_log'; }";
+  if (datalayer.system.info.CAN_SD_logging_active) {
+    content +=
+        "function exportRecent() { window.location.href = '/export_can_log?minutes=' + "
+        "document.getElementById('exportMinutes').value; }";
+  }
 #ifdef LOG_CAN_TO_SD
   content += "function deleteLogFile() { window.location.href = '/delete_can_log'; }";
 #endif
@@ -1,15 +1,16 @@
 #include "can_replay_html.h"
 #include <Arduino.h>
+#include "../../communication/can/can_replay.h"
+#include "../../communication/can/comm_can.h"
 #include "../../datalayer/datalayer.h"
 #include "index_html.h"
 
 String can_replay_processor(void) {
   if (!datalayer.system.info.can_logging_active) {
-    datalayer.system.info.logged_can_messages_offset = 0;
-    datalayer.system.info.logged_can_messages[0] = '\0';
+    clear_web_can_log();
   }
-  datalayer.system.info.can_logging_active =
-      true;  // Signal to main loop that we should log messages. Disabled by default for performance reasons
+  // Signal to main loop that we should log messages. Disabled by default for performance reasons
+  set_web_can_logging(true);
   String content = index_html_header;
   // Page format
   content += "<style>";
@@ -51,12 +52,46 @@ String can_replay_processor(void) {
   content += "<button onclick='sendCANSelection()'>Apply</button>";
 
   content += "<h3>Step 2: Upload CAN Log File</h3>";
-  content += "<p>Click Browse to select a .txt CANdump log file to upload</p>";
+  content += "<p>Click Browse to select a .txt CANdump log file to upload";
+  if (datalayer.system.info.CAN_SD_logging_active) {
+    content += ", or replay the CAN log of the SD card without uploading anything";
+  }
+  content += "</p>";
   content += "<input type='file' id='file-input' accept='.txt'>";
   content += "<button id='upload-btn'>Upload</button>";
 
   content += "<h3>Step 3: Playback control</h3>";
 
+  content += "<label for='replaySource'>Log:</label> <select id='replaySource'>";
+  content += "<option value='upload'>Uploaded log</option>";
+  if (datalayer.system.info.CAN_SD_logging_active) {
+    content += "<option value='sd'>SD card CAN log</option>";
+  }
+  content += "</select> ";
+  content += "<label for='replayStart'>Start at (s):</label> ";
+  content += "<input type='number' id='replayStart' value='0' min='0' style='width:80px'> ";
+  content += "<label for='replaySpeed'>Speed:</label> ";
+  content += "<input type='number' id='replaySpeed' value='1' min='0.01' step='0.1' style='width:60px'>x ";
+
+  // Each bus of the log to an interface of its own, RX of an interface replayed on it by default
+  content += "<p><input type='checkbox' id='mapBuses'> Send each bus of the log to its own interface ";
+  content += "instead of the one of step 1:</p><p>";
+  for (uint8_t bus = 0; bus < CAN_REPLAY_BUSES; bus++) {
+    const bool tx = bus % 2;
+    content += String(tx ? "TX" : "RX") + String(bus) + " <select id='bus" + String(bus) + "'>";
+    content += "<option value='off'" + String(tx ? " selected" : "") + ">Off</option>";
+    for (uint8_t interface = CAN_NATIVE; interface <= CANFD_ADDON_MCP2518; interface++) {
+      content += "<option value='" + String(interface) + "'" + (!tx && bus / 2 == interface ? " selected" : "") +
+                 ">" + getCANInterfaceName((CAN_Interface)interface) + "</option>";
+    }
+    content += "</select> ";
+  }
+  content += "</p>";
+
+  content += "<p><input type='checkbox' id='toReceivers'> Feed the frames to the charger as if received, ";
+  content += "instead of sending them ";
+  content += "<input type='checkbox' id='suppressTx'> Hold back the frames the charger sends</p>";
+
   //Checkbox to see if the user wants the log to repeat once it reaches the end
   content += "<input type=\"checkbox\" id=\"loopCheckbox\"> Loop ";
 
@@ -69,6 +104,15 @@ String can_replay_processor(void) {
   // Status indicator
   content += "<span id='statusIndicator' style='margin-left:10px; font-weight:bold;'>Stopped</span> ";
 
+  // How far behind their log timestamps the frames went out, as of loading the page
+  const CAN_replay_timing timing = can_replay_timing();
+  if (timing.frames > 0) {
+    content += "<p>Timing of the " + String(can_replay_running() ? "running" : "last") + " replay: " +
+               String(timing.frames) + " frames, mean error " + String(replay_timing_mean_error_us(timing)) +
+               " us, max " + String(timing.max_error_us) + " us, " + String(timing.late) + " later than " +
+               String(CAN_REPLAY_LATE_TOLERANCE_US) + " us</p>";
+  }
+
   content += "<h3>Uploaded Log Preview:</h3>";
   content += "<pre id='file-content'></pre>";
 
@@ -100,7 +144,18 @@ String can_replay_processor(void) {
   content += "<script>";
   content += "function startReplay() {";
   content += "  let loop = document.getElementById('loopCheckbox').checked ? 1 : 0;";
-  content += "  fetch('/startReplay?loop=' + loop, { method: 'GET' })";
+  content += "  let params = '?loop=' + loop + '&source=' + document.getElementById('replaySource').value +";
+  content += "    '&start=' + document.getElementById('replayStart').value +";
+  content += "    '&speed=' + document.getElementById('replaySpeed').value;";
+  content += "  if (document.getElementById('toReceivers').checked) { params += '&target=receivers'; }";
+  content += "  if (document.getElementById('suppressTx').checked) { params += '&notx=1'; }";
+  content += "  if (document.getElementById('mapBuses').checked) {";
+  content += "    params += '&map=1';";
+  content += "    for (let bus = 0; bus < " + String(CAN_REPLAY_BUSES) + "; bus++) {";
+  content += "      params += '&bus' + bus + '=' + document.getElementById('bus' + bus).value;";
+  content += "    }";
+  content += "  }";
+  content += "  fetch('/startReplay' + params, { method: 'GET' })";
   content += "    .then(response => response.text())";
   content += "    .then(data => {";
   content += "      console.log(data);";
@@ -0,0 +1,78 @@
+#include "can_tx_timing_html.h"
+#include <Arduino.h>
+#include "../../datalayer/datalayer.h"
+#include "index_html.h"
+
+static String format_ms(uint32_t us) {
+  return String(us / 1000.0f, 3);
+}
+
+String can_tx_timing_processor(void) {
+  String content = index_html_header;
+  // Page format
+  content += "<style>";
+  content += "body { background-color: black; color: white; font-family: Arial, sans-serif; }";
+  content +=
+      "button { background-color: #505E67; color: white; border: none; padding: 10px 20px; margin-bottom: 20px; "
+      "cursor: pointer; border-radius: 10px; }";
+  content += "button:hover { background-color: #3A4A52; }";
+  content += "table { border-collapse: collapse; margin: auto; }";
+  content += "th, td { border: 1px solid #505E67; padding: 4px 8px; text-align: right; font-family: monospace; }";
+  content += "</style>";
+  content += "<button onclick='refreshPage()'>Refresh data</button> ";
+  content += "<button onclick='resetStats()'>Reset statistics</button> ";
+  content += "<button onclick='home()'>Back to main page</button>";
+
+  content += "<div style='background-color: #303E47; padding: 20px; border-radius: 15px'>";
+  content += "<h3>Cyclic CAN message transmit intervals</h3>";
+
+  const auto& status = datalayer.system.status;
+  if (status.can_tx_timing_count == 0) {
+    content += "<p>No cyclic messages are monitored with the current setup.</p>";
+  } else {
+    content += "<table><tr><th>ID</th><th>Interface</th><th>Period ms</th><th>Intervals</th>";
+    content += "<th>Min ms</th><th>Mean ms</th><th>Max ms</th><th>Late</th><th>Missed</th>";
+    uint32_t lower_us = 0;
+    for (uint8_t b = 0; b < CAN_TX_JITTER_BUCKETS - 1; b++) {
+      content += "<th>&plusmn;" + String(lower_us) + "-" + String(CAN_TX_JITTER_BUCKET_LIMITS_US[b]) + " us</th>";
+      lower_us = CAN_TX_JITTER_BUCKET_LIMITS_US[b];
+    }
+    content += "<th>&gt;" + String(lower_us) + " us</th></tr>";
+
+    for (uint8_t i = 0; i < status.can_tx_timing_count; i++) {
+      // Copied first, as the core task keeps updating the statistics while the page is rendered
+      const CAN_tx_timing timing = status.can_tx_timing[i];
+      content += "<tr><td>0x" + String(timing.ID, HEX) + "</td>";
+      content += "<td>" + String(getCANInterfaceName(timing.interface)) + "</td>";
+      content += "<td>" + format_ms(timing.period_us) + "</td>";
+      content += "<td>" + String(timing.intervals) + "</td>";
+      if (timing.intervals > 0) {
+        content += "<td>" + format_ms(timing.min_us) + "</td>";
+        content += "<td>" + format_ms(tx_timing_mean_us(timing)) + "</td>";
+        content += "<td>" + format_ms(timing.max_us) + "</td>";
+      } else {
+        content += "<td>-</td><td>-</td><td>-</td>";
+      }
+      content += "<td>" + String(timing.late) + "</td>";
+      content += "<td>" + String(timing.missed) + "</td>";
+      for (uint8_t b = 0; b < CAN_TX_JITTER_BUCKETS; b++) {
+        content += "<td>" + String(timing.histogram[b]) + "</td>";
+      }
+      content += "</tr>";
+    }
+    content += "</table>";
+    content += "<p>Late: more than " + String(CAN_TX_LATE_TOLERANCE_US) +
+               " us over the period. Missed: a whole period without the message being sent.</p>";
+  }
+  content += "</div>";
+
+  content += "<script>";
+  content += "function refreshPage(){ location.reload(true); }";
+  content +=
+      "function resetStats() { var xhr = new XMLHttpRequest(); xhr.onload = function() { "
+      "setTimeout(refreshPage, 200); }; xhr.open('GET', '/reset_can_tx_timing', true); xhr.send(); }";
+  content += "function home() { window.location.href = '/'; }";
+  content += "</script>";
+  content += index_html_footer;
+  return content;
+}
@@ -0,0 +1,16 @@
+#ifndef CANTXTIMING_HTML_H
+#define CANTXTIMING_HTML_H
+
+#include <Arduino.h>
+#include <string>
+
+/**
+ * @brief Renders the transmit interval statistics of the monitored cyclic CAN messages
+ *
+ * @param[in] void
+ *
+ * @return String
+ */
+String can_tx_timing_processor(void);
+
+#endif
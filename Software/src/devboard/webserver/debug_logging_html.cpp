@@ -1,41 +1,14 @@
 #include "debug_logging_html.h"
 #include <Arduino.h>
+#include <vector>
 #include "../../datalayer/datalayer.h"
+#include "../utils/logging.h"
 #include "index_html.h"
 
-char* strnchr(const char* s, int c, size_t n) {
-  // Like strchr, but only searches the first 'n' bytes of the string.
-
-  if (s == NULL) {
-    return NULL;
-  }
-
-  // Iterate through the string up to 'n' characters or until a null terminator is found.
-  for (size_t i = 0; i < n && s[i] != '\0'; ++i) {
-    if (s[i] == c) {
-      // Character found, return a pointer to it.
-      return (char*)&s[i];
-    }
-  }
-
-  // If the character to be found is the null terminator, and we haven't exceeded
-  // 'n' bytes, check if the null terminator is at the current position.
-  if (c == '\0') {
-    for (size_t i = 0; i < n; ++i) {
-      if (s[i] == '\0') {
-        return (char*)&s[i];
-      }
-    }
-  }
-
-  // Character not found within the first 'n' bytes.
-  return NULL;
-}
-
 String debug_logger_processor(void) {
   String content = String();
   // Reserve enough space for the content to avoid reallocations.
-  if (!content.reserve(1000 + sizeof(datalayer.system.info.logged_can_messages))) {
+  if (!content.reserve(1000 + WEB_LOG_BUFFER_SIZE)) {
     if (content.reserve(15)) {
       content += "Out of memory.";
     }
@@ -64,34 +37,13 @@ String debug_logger_processor(void) {
 
   // Start a new block for the debug log messages
   content += "<PRE style='text-align: left'>";
-  size_t offset = datalayer.system.info.logged_can_messages_offset;
-  // If we're mid-buffer, print the older part first.
-  if (offset > 0 && offset < (sizeof(datalayer.system.info.logged_can_messages) - 1)) {
-    // Find the next newline after the current offset. The offset will always be
-    // before the penultimate character, so (offset + 1) will be the final '\0'
-    // or earlier.
-
-    char* next_newline = strnchr(&datalayer.system.info.logged_can_messages[offset + 1], '\n',
-                                 sizeof(datalayer.system.info.logged_can_messages) - offset - 1);
-
-    if (next_newline != NULL) {
-      // We found a newline, so append from the character after that. We check
-      // the string length to ensure we don't add any intermediate '\0'
-      // characters.
-      content.concat(next_newline + 1,
-                     strnlen(next_newline + 1, sizeof(datalayer.system.info.logged_can_messages) - offset - 2));
-    } else {
-      // No newline found, so append from the next character after the offset to
-      // the end of the buffer. We check the string length to ensure we don't
-      // add any intermediate '\0' characters.
-      content.concat(&datalayer.system.info.logged_can_messages[offset + 1],
-                     strnlen(&datalayer.system.info.logged_can_messages[offset + 1],
-                             sizeof(datalayer.system.info.logged_can_messages) - offset - 1));
-    }
+  // Oldest messages first, as far back as the log ring reaches
+  std::vector<char> text(WEB_LOG_BUFFER_SIZE / 4);
+  uint32_t cursor = web_log_oldest();
+  size_t len;
+  while ((len = read_web_log(cursor, text.data(), text.size())) > 0) {
+    content.concat(text.data(), len);
   }
-  // Append the first part of the buffer up to the current write offset (which
-  // points to the first \0).
-  content.concat(datalayer.system.info.logged_can_messages, offset);
   content += "</PRE>";
 
   // Add JavaScript for navigation
@@ -215,10 +215,30 @@ String settings_processor(const String& var, BatteryEmulatorSettingsStore& setti
     return String(settings.getUInt("SUBNET4", 0));
   }
 
+  if (var == "CANLOGGVRET") {
+    return settings.getBool("CANLOGGVRET") ? "checked" : "";
+  }
+
   if (var == "WEBENABLED") {
     return settings.getBool("WEBENABLED") ? "checked" : "";
   }
 
+  if (var == "LOGLEVELS") {
+    std::vector<std::pair<int, const char*>> levels;
+    for (int level = LOG_LEVEL_NONE; level <= LOG_LEVEL_COMPILED; level++) {
+      levels.push_back({level, name_for_log_level((LogLevel)level)});
+    }
+    String rows;
+    for (int module = 0; module < LOG_MODULE_COUNT; module++) {
+      const char* setting = log_level_setting((LogModule)module);
+      rows += "<label>Log level " + String(name_for_log_module((LogModule)module)) + ": </label>";
+      rows += "<select name='" + String(setting) + "'>";
+      rows += options_from_map(settings.getUInt(setting, LOG_LEVEL_DEFAULT), levels);
+      rows += "</select>";
+    }
+    return rows;
+  }
+
   if (var == "CHARGER_CLASS") {
     if (!charger) {
       return "hidden";
@@ -807,6 +827,9 @@ const char* getCANInterfaceName(CAN_Interface interface) {
         <label>Enable CAN message logging via USB serial: </label>
         <input type='checkbox' name='CANLOGUSB' value='on' %CANLOGUSB% />
 
+        <label>Send USB CAN log as GVRET binary (SavvyCAN), disables USB general logging: </label>
+        <input type='checkbox' name='CANLOGGVRET' value='on' %CANLOGGVRET% />
+
         <label>Enable general logging via USB serial: </label>
         <input type='checkbox' name='USBENABLED' value='on' %USBENABLED% />
 
@@ -819,6 +842,8 @@ const char* getCANInterfaceName(CAN_Interface interface) {
         <label>Enable general logging via SD card: </label>
         <input type='checkbox' name='SDLOGENABLED' value='on' %SDLOGENABLED% />
 
+        %LOGLEVELS%
+
         </div>
          </div>
 
@@ -3,6 +3,7 @@
 #include <ctime>
 #include <vector>
 #include "../../charger/CHARGERS.h"
+#include "../../communication/can/can_replay.h"
 #include "../../communication/can/comm_can.h"
 #include "../../communication/nvm/comm_nvm.h"
 #include "../../datalayer/datalayer.h"
@@ -24,6 +25,7 @@ unsigned long ota_progress_millis = 0;
 
 #include "can_logging_html.h"
 #include "can_replay_html.h"
+#include "can_tx_timing_html.h"
 #include "debug_logging_html.h"
 #include "events_html.h"
 #include "index_html.h"
@@ -34,125 +36,48 @@ bool ota_active = false;
 
 const char get_firmware_info_html[] = R"rawliteral(%X%)rawliteral";
 
-String importedLogs = "";      // Store the uploaded logfile contents in RAM
-bool isReplayRunning = false;  // Global flag to track replay state
-
 // True when user has updated settings that need a reboot to be effective.
 bool settingsUpdated = false;
 
-CAN_frame currentFrame = {.FD = true, .ext_ID = false, .DLC = 64, .ID = 0x12F, .data = {0}};
+// The request whose log is being received, if any
+static AsyncWebServerRequest* replay_upload_request = nullptr;
 
+// The log is parsed into replay records chunk by chunk as it arrives, the text itself is never stored
 void handleFileUpload(AsyncWebServerRequest* request, String filename, size_t index, uint8_t* data, size_t len,
                       bool final) {
   if (!index) {
-    importedLogs = "";  // Clear previous logs
-    logging.printf("Receiving file: %s\n", filename.c_str());
+    LOG_INFO(WEBSERVER, "Receiving file: %s\n", filename.c_str());
+    if (!begin_can_replay_upload()) {
+      request->send(409, "text/plain", "Replay or another upload running, or out of memory, upload ignored");
+      return;
+    }
+    replay_upload_request = request;
+    // A client going away in the middle of the upload would otherwise keep replays from starting
+    request->onDisconnect([request]() {
+      if (replay_upload_request == request) {
+        replay_upload_request = nullptr;
+        abort_can_replay_upload();
+      }
+    });
   }
 
-  // Append received data to the string (RAM storage)
-  importedLogs += String((char*)data).substring(0, len);
-
-  if (final) {
-    logging.println("Upload Complete!");
-    request->send(200, "text/plain", "File uploaded successfully");
+  // Chunks of a request that was turned away must not end up in the upload in progress
+  if (request != replay_upload_request) {
+    return;
   }
-}
-
-void canReplayTask(void* param) {
-  std::vector<String> messages;
-  messages.reserve(1000);  // Pre-allocate memory to reduce fragmentation
 
-  if (!importedLogs.isEmpty()) {
-    int lastIndex = 0;
+  add_can_replay_upload_data(data, len);
 
-    while (true) {
-      int nextIndex = importedLogs.indexOf("\n", lastIndex);
-      if (nextIndex == -1) {
-        messages.push_back(importedLogs.substring(lastIndex));
-        break;
-      }
-      messages.push_back(importedLogs.substring(lastIndex, nextIndex));
-      lastIndex = nextIndex + 1;
+  if (final && end_can_replay_upload()) {
+    replay_upload_request = nullptr;
+    LOG_INFO(WEBSERVER, "Upload Complete!\n");
+    if (can_replay_frames_dropped() > 0) {
+      request->send(200, "text/plain",
+                    "File uploaded, " + String(can_replay_frames_dropped()) + " frames did not fit and were dropped");
+    } else {
+      request->send(200, "text/plain", "File uploaded successfully");
     }
-
-    do {
-      float firstTimestamp = -1.0;
-      float lastTimestamp = 0.0;
-      bool firstMessageSent = false;  // Track first message
-
-      for (size_t i = 0; i < messages.size(); i++) {
-        String line = messages[i];
-        line.trim();
-        if (line.length() == 0)
-          continue;
-
-        int timeStart = line.indexOf("(") + 1;
-        int timeEnd = line.indexOf(")");
-        if (timeStart == 0 || timeEnd == -1)
-          continue;
-
-        float currentTimestamp = line.substring(timeStart, timeEnd).toFloat();
-
-        if (firstTimestamp < 0) {
-          firstTimestamp = currentTimestamp;
-        }
-
-        // Send first message immediately
-        if (!firstMessageSent) {
-          firstMessageSent = true;
-          firstTimestamp = currentTimestamp;  // Adjust reference time
-        } else {
-          // Delay only if this isn't the first message
-          float deltaT = (currentTimestamp - lastTimestamp) * 1000;
-          vTaskDelay((int)deltaT / portTICK_PERIOD_MS);
-        }
-
-        lastTimestamp = currentTimestamp;
-
-        int interfaceStart = timeEnd + 2;
-        int interfaceEnd = line.indexOf(" ", interfaceStart);
-        if (interfaceEnd == -1)
-          continue;
-
-        int idStart = interfaceEnd + 1;
-        int idEnd = line.indexOf(" [", idStart);
-        if (idStart == -1 || idEnd == -1)
-          continue;
-
-        String messageID = line.substring(idStart, idEnd);
-        int dlcStart = idEnd + 2;
-        int dlcEnd = line.indexOf("]", dlcStart);
-        if (dlcEnd == -1)
-          continue;
-
-        String dlc = line.substring(dlcStart, dlcEnd);
-        int dataStart = dlcEnd + 2;
-        String dataBytes = line.substring(dataStart);
-
-        currentFrame.ID = strtol(messageID.c_str(), NULL, 16);
-        currentFrame.DLC = dlc.toInt();
-
-        int byteIndex = 0;
-        char* token = strtok((char*)dataBytes.c_str(), " ");
-        while (token != NULL && byteIndex < currentFrame.DLC) {
-          currentFrame.data.u8[byteIndex++] = strtol(token, NULL, 16);
-          token = strtok(NULL, " ");
-        }
-
-        currentFrame.FD = (datalayer.system.info.can_replay_interface == CANFD_NATIVE) ||
-                          (datalayer.system.info.can_replay_interface == CANFD_ADDON_MCP2518);
-        currentFrame.ext_ID = (currentFrame.ID > 0x7F0);
-
-        transmit_can_frame_to_interface(&currentFrame, (CAN_Interface)datalayer.system.info.can_replay_interface);
-      }
-    } while (datalayer.system.info.loop_playback);
-
-    messages.clear();          // Free vector memory
-    messages.shrink_to_fit();  // Release excess memory
   }
-
-  isReplayRunning = false;  // Mark replay as stopped
-  vTaskDelete(NULL);
 }
 
 void def_route_with_auth(const char* uri, AsyncWebServer& serv, WebRequestMethodComposite method,
@@ -160,6 +85,15 @@ void def_route_with_auth(const char* uri, AsyncWebServer& serv, WebRequestMethod
   serv.on(uri, method, [handler](AsyncWebServerRequest* request) { handler(request); });
 }
 
+// Sends log segments from the SD card as one download, read from the card as the response goes out
+static void send_log_segments(AsyncWebServerRequest* request, std::shared_ptr<LogSegmentReader> reader,
+                              const char* filename) {
+  auto filler = [reader](uint8_t* buffer, size_t max_len, size_t) { return reader->read(buffer, max_len); };
+  AsyncWebServerResponse* response = request->beginResponse("application/octet-stream", reader->size(), filler);
+  response->addHeader("Content-Disposition", String("attachment; filename=\"") + filename + "\"");
+  request->send(response);
+}
+
 void init_webserver() {
 
   server.on("/logout", HTTP_GET, [](AsyncWebServerRequest* request) { request->send(401); });
@@ -192,24 +126,60 @@ void init_webserver() {
     request->send(request->beginResponse(200, "text/html", can_replay_processor()));
   });
 
+  // Route for going to CAN TX timing web page
+  def_route_with_auth("/cantxtiming", server, HTTP_GET, [](AsyncWebServerRequest* request) {
+    request->send(request->beginResponse(200, "text/html", can_tx_timing_processor()));
+  });
+
+  def_route_with_auth("/reset_can_tx_timing", server, HTTP_GET, [](AsyncWebServerRequest* request) {
+    reset_can_tx_timing();
+    request->send(200, "text/plain", "CAN TX timing statistics reset");
+  });
+
   def_route_with_auth("/startReplay", server, HTTP_GET, [](AsyncWebServerRequest* request) {
+    // ?loop=1, ?source=sd for the SD card CAN log, ?start= seconds into the log, ?speed= multiplier, and ?map=1
+    // with ?bus0= to ?bus7= set to an interface or "off" to send each bus of the log to an interface of its own.
+    // ?target=receivers hands the frames to the receivers instead, ?notx=1 holds back the firmware's own frames.
+    CAN_replay_options options = {.source = REPLAY_FROM_UPLOAD, .loop = false, .start_s = 0, .speed_percent = 100};
+    options.loop = request->hasParam("loop") && request->getParam("loop")->value().toInt() == 1;
+    if (request->hasParam("source") && request->getParam("source")->value() == "sd") {
+      options.source = REPLAY_FROM_SD;
+    }
+    if (request->hasParam("start")) {
+      options.start_s = max(0L, request->getParam("start")->value().toInt());
+    }
+    if (request->hasParam("speed")) {
+      options.speed_percent = max(1L, lroundf(request->getParam("speed")->value().toFloat() * 100));
+    }
+    options.map_buses = request->hasParam("map") && request->getParam("map")->value().toInt() == 1;
+    options.target = REPLAY_TO_BUS;
+    if (request->hasParam("target") && request->getParam("target")->value() == "receivers") {
+      options.target = REPLAY_TO_RECEIVERS;
+    }
+    options.suppress_tx = request->hasParam("notx") && request->getParam("notx")->value().toInt() == 1;
+    for (uint8_t bus = 0; bus < CAN_REPLAY_BUSES; bus++) {
+      const String param = "bus" + String(bus);
+      options.bus_map[bus] = CAN_REPLAY_BUS_OFF;
+      if (request->hasParam(param) && request->getParam(param)->value() != "off") {
+        const long interface = request->getParam(param)->value().toInt();
+        if (interface >= CAN_NATIVE && interface <= CANFD_ADDON_MCP2518) {
+          options.bus_map[bus] = interface;
+        }
+      }
+    }
+
     // Prevent multiple replay tasks from being created
-    if (isReplayRunning) {
-      request->send(400, "text/plain", "Replay already running!");
+    if (!start_can_replay(options)) {
+      request->send(400, "text/plain", "Replay already running, or no CAN log on the SD card!");
       return;
     }
 
-    datalayer.system.info.loop_playback = request->hasParam("loop") && request->getParam("loop")->value().toInt() == 1;
-    isReplayRunning = true;  // Set flag before starting task
-
-    xTaskCreatePinnedToCore(canReplayTask, "CAN_Replay", 8192, NULL, 1, NULL, 1);
-
     request->send(200, "text/plain", "CAN replay started!");
   });
 
   // Route for stopping the CAN replay
   def_route_with_auth("/stopReplay", server, HTTP_GET, [](AsyncWebServerRequest* request) {
-    datalayer.system.info.loop_playback = false;
+    stop_can_replay();
 
     request->send(200, "text/plain", "CAN replay stopped!");
   });
@@ -242,7 +212,7 @@ void init_webserver() {
 
   // Define the handler to stop can logging
   server.on("/stop_can_logging", HTTP_GET, [](AsyncWebServerRequest* request) {
-    datalayer.system.info.can_logging_active = false;
+    set_web_can_logging(false);
     request->send(200, "text/plain", "Logging stopped");
   });
 
@@ -255,11 +225,20 @@ void init_webserver() {
       handleFileUpload);
 
   if (datalayer.system.info.CAN_SD_logging_active) {
-    // Define the handler to export can log
+    // Define the handler to export can log, optionally limited to ?minutes=N back or ?from=&to= log clock seconds
     server.on("/export_can_log", HTTP_GET, [](AsyncWebServerRequest* request) {
-      pause_can_writing();
-      request->send(SD_MMC, CAN_LOG_FILE, String(), true);
-      resume_can_writing();
+      uint32_t from_s = 0;
+      uint32_t to_s = UINT32_MAX;
+      if (request->hasParam("minutes")) {
+        from_s = sd_log_clock_s() - min(sd_log_clock_s(), (uint32_t)request->getParam("minutes")->value().toInt() * 60);
+      }
+      if (request->hasParam("from")) {
+        from_s = request->getParam("from")->value().toInt();
+      }
+      if (request->hasParam("to")) {
+        to_s = request->getParam("to")->value().toInt();
+      }
+      send_log_segments(request, export_can_log(from_s, to_s), "canlog.bin");
     });
 
     // Define the handler to delete can log
@@ -270,7 +249,8 @@ void init_webserver() {
   } else {
     // Define the handler to export can log
     server.on("/export_can_log", HTTP_GET, [](AsyncWebServerRequest* request) {
-      String logs = String(datalayer.system.info.logged_can_messages);
+      String logs;
+      for_each_web_can_log_line([&logs](const char* line, size_t len) { return logs.concat(line, len); });
       if (logs.length() == 0) {
         logs = "No logs available.";
       }
@@ -304,15 +284,16 @@ void init_webserver() {
     });
 
     // Define the handler to export debug log
-    server.on("/export_log", HTTP_GET, [](AsyncWebServerRequest* request) {
-      pause_log_writing();
-      request->send(SD_MMC, LOG_FILE, String(), true);
-      resume_log_writing();
-    });
+    server.on("/export_log", HTTP_GET,
+              [](AsyncWebServerRequest* request) { send_log_segments(request, export_log(), "log.txt"); });
   } else {
     // Define the handler to export debug log
     server.on("/export_log", HTTP_GET, [](AsyncWebServerRequest* request) {
-      String logs = String(datalayer.system.info.logged_can_messages);
+      String logs;
+      std::vector<char> text(WEB_LOG_BUFFER_SIZE / 4);
+      uint32_t cursor = web_log_oldest();
+      size_t len;
+      while ((len = read_web_log(cursor, text.data(), text.size())) > 0 && logs.concat(text.data(), len)) {}
       if (logs.length() == 0) {
         logs = "No logs available.";
       }
@@ -371,7 +352,7 @@ void init_webserver() {
       "DBLBTR",        "CNTCTRL",      "CNTCTRLDBL",  "PWMCNTCTRL",   "PERBMSRESET",  "SDLOGENABLED", "STATICIP",
       "REMBMSRESET",   "EXTPRECHARGE", "USBENABLED",  "CANLOGUSB",    "WEBENABLED",   "CANFDASCAN",   "CANLOGSD",
       "WIFIAPENABLED", "MQTTENABLED",  "NOINVDISC",   "HADISC",       "MQTTTOPICS",   "MQTTCELLV",    "INVICNT",
-      "GTWRHD",        "DIGITALHVIL",  "PERFPROFILE", "INTERLOCKREQ", "SOCESTIMATED",
+      "GTWRHD",        "DIGITALHVIL",  "PERFPROFILE", "INTERLOCKREQ", "SOCESTIMATED", "CANLOGGVRET",
   };
 
   // Handles the form POST from UI to save settings of the common image
@@ -450,6 +431,15 @@ void init_webserver() {
       } else if (p->name() == "LEDMODE") {
         auto type = atoi(p->value().c_str());
         settings.saveUInt("LEDMODE", type);
+      } else if (p->name().startsWith("LOGLVL")) {
+        // Log levels apply right away, no reboot needed
+        for (int module = 0; module < LOG_MODULE_COUNT; module++) {
+          if (p->name() == log_level_setting((LogModule)module)) {
+            auto level = min(atoi(p->value().c_str()), (int)LOG_LEVEL_COMPILED);
+            settings.saveUInt(p->name().c_str(), level);
+            log_module_levels[module] = level;
+          }
+        }
       }
 
       for (auto& boolSetting : boolSettings) {
@@ -785,11 +775,52 @@ String processor(const String& var) {
       content += "</div>";
     }
 
+    if (datalayer.system.info.performance_measurement_active) {
+      // Start a new block for CAN performance counters
+      content += "<div style='background-color: #303E47; padding: 10px; margin-bottom: 10px; border-radius: 50px'>";
+      content += "<h4>CAN RX overruns: Native " + String(datalayer.system.status.can_native_rx_overruns) +
+                 " MCP2515 " + String(datalayer.system.status.can_2515_rx_overruns) + " MCP2518 " +
+                 String(datalayer.system.status.can_2518_rx_overruns) + "</h4>";
+      content += "<h4>CAN RX max frames per batch: " + String(datalayer.system.status.can_rx_batch_max) +
+                 " Budget exhausted: " + String(datalayer.system.status.can_rx_budget_exhausted) + "</h4>";
+      content += "<h4>CAN RX queue overruns: " + String(datalayer.system.status.can_rx_queue_overruns) +
+                 " Max latency: " + String(datalayer.system.status.can_rx_latency_max_us) + " us</h4>";
+      const auto& native_tx = datalayer.system.status.can_native_tx_queue;
+      const auto& mcp2515_tx = datalayer.system.status.can_2515_tx_queue;
+      const auto& mcp2518_tx = datalayer.system.status.can_2518_tx_queue;
+      content += "<h4>CAN TX queue depth/max/dropped/coalesced: Native " + String(native_tx.depth) + "/" +
+                 String(native_tx.depth_max) + "/" + String(native_tx.dropped) + "/" + String(native_tx.coalesced) +
+                 " MCP2515 " + String(mcp2515_tx.depth) + "/" + String(mcp2515_tx.depth_max) + "/" +
+                 String(mcp2515_tx.dropped) + "/" + String(mcp2515_tx.coalesced) + " MCP2518 " +
+                 String(mcp2518_tx.depth) + "/" + String(mcp2518_tx.depth_max) + "/" + String(mcp2518_tx.dropped) +
+                 "/" + String(mcp2518_tx.coalesced) + "</h4>";
+      if (datalayer.system.info.CAN_SD_logging_active) {
+        content += "<h4>CAN frames dropped from SD log: " + String(datalayer.system.status.can_sd_log_drops) + "</h4>";
+      }
+      if (datalayer.system.info.CAN_usb_logging_active) {
+        content +=
+            "<h4>CAN frames dropped from USB stream: " + String(datalayer.system.status.can_usb_log_drops) + "</h4>";
+      }
+      if (datalayer.system.info.SD_logging_active) {
+        content +=
+            "<h4>Debug log writes dropped from SD log: " + String(datalayer.system.status.sd_log_drops) + "</h4>";
+      }
+      if (datalayer.system.info.CAN_SD_logging_active || datalayer.system.info.SD_logging_active) {
+        content += "<h4>SD write: " + String(datalayer.system.status.sd_write_bytes_per_s) + " B/s, max " +
+                   String(datalayer.system.status.sd_write_max_us) + " us per block. Buffer high water: CAN " +
+                   String(datalayer.system.status.sd_can_buffer_high_water) + "/" + String(SD_CAN_RING_BUFFER_SIZE) +
+                   " log " + String(datalayer.system.status.sd_log_buffer_high_water) + "/" +
+                   String(SD_LOG_RING_BUFFER_SIZE) + " bytes</h4>";
+      }
+      content += "</div>";
+    }
+
     content += "<button onclick='OTA()'>Perform OTA update</button> ";
     content += "<button onclick='Settings()'>Change Settings</button> ";
     content += "<button onclick='Advanced()'>More Battery Info</button> ";
     content += "<button onclick='CANlog()'>CAN logger</button> ";
     content += "<button onclick='CANreplay()'>CAN replay</button> ";
+    content += "<button onclick='CANtxTiming()'>CAN TX timing</button> ";
     if (datalayer.system.info.web_logging_active || datalayer.system.info.SD_logging_active) {
       content += "<button onclick='Log()'>Log</button> ";
     }
@@ -818,6 +849,7 @@ String processor(const String& var) {
     content += "function Advanced() { window.location.href = '/advanced'; }";
     content += "function CANlog() { window.location.href = '/canlog'; }";
     content += "function CANreplay() { window.location.href = '/canreplay'; }";
+    content += "function CANtxTiming() { window.location.href = '/cantxtiming'; }";
     content += "function Log() { window.location.href = '/log'; }";
     content += "function Events() { window.location.href = '/events'; }";
     if (webserver_auth) {
@@ -867,7 +899,7 @@ void onOTAProgress(size_t current, size_t final) {
   // Log every 1 second
   if (millis() - ota_progress_millis > 1000) {
     ota_progress_millis = millis();
-    logging.printf("OTA Progress Current: %u bytes, Final: %u bytes\n", current, final);
+    LOG_INFO(WEBSERVER, "OTA Progress Current: %u bytes, Final: %u bytes\n", current, final);
     // Reset the "watchdog"
     ota_timeout_timer.reset();
   }
@@ -881,9 +913,9 @@ void onOTAEnd(bool success) {
   // Log when OTA has finished
   if (success) {
     // a reboot will be done by the OTA library. no need to do anything here
-    logging.println("OTA update finished successfully!");
+    LOG_INFO(WEBSERVER, "OTA update finished successfully!\n");
   } else {
-    logging.println("There was an error during OTA update!");
+    LOG_ERROR(WEBSERVER, "There was an error during OTA update!\n");
   }
 }
 
@@ -54,8 +54,8 @@ static uint16_t current_check_interval = WIFI_CHECK_INTERVAL;
 static bool connected_once = false;
 
 void init_WiFi() {
-  DEBUG_PRINTF("init_Wifi enabled=%d, ap=%d, ssid=%s, password=%s\n", wifi_enabled, wifiap_enabled, ssid.c_str(),
-               password.c_str());
+  LOG_DEBUG(WIFI, "init_Wifi enabled=%d, ap=%d, ssid=%s, password=%s\n", wifi_enabled, wifiap_enabled, ssid.c_str(),
+            password.c_str());
 
   if (!custom_hostname.empty()) {
     WiFi.setHostname(custom_hostname.c_str());
@@ -81,7 +81,7 @@ void init_WiFi() {
                      (uint8_t)static_subnet4);
     WiFi.config(local_IP, gateway, subnet);
   }
-  DEBUG_PRINTF("init_Wifi set event handlers\n");
+  LOG_DEBUG(WIFI, "init_Wifi set event handlers\n");
 
   // Initialize Wi-Fi event handlers
   WiFi.onEvent(onWifiConnect, WiFiEvent_t::ARDUINO_EVENT_WIFI_STA_CONNECTED);
@@ -89,10 +89,10 @@ void init_WiFi() {
   WiFi.onEvent(onWifiGotIP, WiFiEvent_t::ARDUINO_EVENT_WIFI_STA_GOT_IP);
 
   // Start Wi-Fi connection
-  DEBUG_PRINTF("start Wifi\n");
+  LOG_DEBUG(WIFI, "start Wifi\n");
   connectToWiFi();
 
-  DEBUG_PRINTF("init_Wifi complete\n");
+  LOG_DEBUG(WIFI, "init_Wifi complete\n");
 }
 
 // Task to monitor Wi-Fi status and handle reconnections
@@ -108,8 +108,8 @@ void wifi_monitor() {
   if ((hasConnectedBefore && (currentMillis - lastWiFiCheck > current_check_interval)) ||
       (!hasConnectedBefore && (currentMillis - lastWiFiCheck > INIT_WIFI_FULL_RECONNECT_INTERVAL))) {
 
-    DEBUG_PRINTF("Time to monitor Wi-Fi status: %d, %d, %d, %d, %d\n", hasConnectedBefore, currentMillis, lastWiFiCheck,
-                 current_check_interval, INIT_WIFI_FULL_RECONNECT_INTERVAL);
+    LOG_TRACE(WIFI, "Time to monitor Wi-Fi status: %d, %d, %d, %d, %d\n", hasConnectedBefore, currentMillis,
+              lastWiFiCheck, current_check_interval, INIT_WIFI_FULL_RECONNECT_INTERVAL);
 
     lastWiFiCheck = currentMillis;
 
@@ -120,27 +120,27 @@ void wifi_monitor() {
       if (current_check_interval + STEP_WIFI_CHECK_INTERVAL <= MAX_STEP_WIFI_CHECK_INTERVAL) {
         current_check_interval += STEP_WIFI_CHECK_INTERVAL;
       }
-      DEBUG_PRINTF("Wi-Fi not connected (status=%d), attempting to reconnect\n", status);
+      LOG_WARN(WIFI, "Wi-Fi not connected (status=%d), attempting to reconnect\n", status);
 
       // Try WiFi.reconnect() if it was successfully connected at least once
       if (hasConnectedBefore) {
         lastReconnectAttempt = currentMillis;  // Reset reconnection attempt timer
-        logging.println("Wi-Fi reconnect attempt...");
+        LOG_INFO(WIFI, "Wi-Fi reconnect attempt...\n");
         if (WiFi.reconnect()) {
-          logging.println("Wi-Fi reconnect attempt sucess...");
+          LOG_INFO(WIFI, "Wi-Fi reconnect attempt sucess...\n");
           reconnectAttempts = 0;  // Reset the attempt counter on successful reconnect
         } else {
-          logging.println("Wi-Fi reconnect attempt error...");
+          LOG_WARN(WIFI, "Wi-Fi reconnect attempt error...\n");
           reconnectAttempts++;
           if (reconnectAttempts >= MAX_RECONNECT_ATTEMPTS) {
-            logging.println("Failed to reconnect multiple times, forcing a full connection attempt...");
+            LOG_WARN(WIFI, "Failed to reconnect multiple times, forcing a full connection attempt...\n");
             FullReconnectToWiFi();
           }
         }
       } else {
         // If no previous connection, force a full connection attempt
         if (currentMillis - lastReconnectAttempt > current_full_reconnect_interval) {
-          logging.println("No previous OK connection, force a full connection attempt...");
+          LOG_INFO(WIFI, "No previous OK connection, force a full connection attempt...\n");
           wifiap_enabled = true;
           WiFi.mode(WIFI_AP_STA);
           init_WiFi_AP();
@@ -172,15 +172,15 @@ void connectToWiFi() {
 
   if (WiFi.status() != WL_CONNECTED) {
     lastReconnectAttempt = millis();  // Reset the reconnect attempt timer
-    logging.println("Connecting to Wi-Fi...");
+    LOG_INFO(WIFI, "Connecting to Wi-Fi...\n");
     if (wifi_channel > 14) {
       wifi_channel = 0;
     }  //prevent users going out of bounds
-    DEBUG_PRINTF("Connecting to Wi-Fi SSID: %s, password: %s, Channel: %d\n", ssid.c_str(), password.c_str(),
-                 wifi_channel);
+    LOG_DEBUG(WIFI, "Connecting to Wi-Fi SSID: %s, password: %s, Channel: %d\n", ssid.c_str(), password.c_str(),
+              wifi_channel);
     WiFi.begin(ssid.c_str(), password.c_str(), wifi_channel);
   } else {
-    logging.println("Wi-Fi already connected.");
+    LOG_DEBUG(WIFI, "Wi-Fi already connected.\n");
   }
 }
 
@@ -189,8 +189,8 @@ void onWifiConnect(WiFiEvent_t event, WiFiEventInfo_t info) {
   clear_event(EVENT_WIFI_DISCONNECT);
   set_event(EVENT_WIFI_CONNECT, 0);
   connected_once = true;
-  DEBUG_PRINTF("Wi-Fi connected. status: %d, RSSI: %d dBm, IP address: %s, SSID: %s\n", WiFi.status(), -WiFi.RSSI(),
-               WiFi.localIP().toString().c_str(), WiFi.SSID().c_str());
+  LOG_INFO(WIFI, "Wi-Fi connected. status: %d, RSSI: %d dBm, IP address: %s, SSID: %s\n", WiFi.status(), -WiFi.RSSI(),
+           WiFi.localIP().toString().c_str(), WiFi.SSID().c_str());
   hasConnectedBefore = true;                                            // Mark as successfully connected at least once
   reconnectAttempts = 0;                                                // Reset the attempt counter
   current_full_reconnect_interval = INIT_WIFI_FULL_RECONNECT_INTERVAL;  // Reset the full reconnect interval
@@ -202,9 +202,7 @@ void onWifiConnect(WiFiEvent_t event, WiFiEventInfo_t info) {
 void onWifiGotIP(WiFiEvent_t event, WiFiEventInfo_t info) {
   //clear disconnects events if we got a IP
   clear_event(EVENT_WIFI_DISCONNECT);
-  logging.print("Wi-Fi Got IP. ");
-  logging.print("IP address: ");
-  logging.println(WiFi.localIP().toString());
+  LOG_INFO(WIFI, "Wi-Fi Got IP. IP address: %s\n", WiFi.localIP().toString().c_str());
 }
 
 // Event handler for Wi-Fi disconnection
@@ -213,7 +211,7 @@ void onWifiDisconnect(WiFiEvent_t event, WiFiEventInfo_t info) {
   if (connected_once) {
     set_event(EVENT_WIFI_DISCONNECT, 0);
   }
-  logging.println("Wi-Fi disconnected.");
+  LOG_INFO(WIFI, "Wi-Fi disconnected.\n");
   //we dont do anything here, the reconnect will be handled by the monitor
   //too many events received when the connection is lost
   //normal reconnect retry start at first 2 seconds
@@ -232,7 +230,7 @@ void init_mDNS() {
 
   // Initialize mDNS .local resolution
   if (!MDNS.begin(mdnsHost)) {
-    logging.println("Error setting up MDNS responder!");
+    LOG_ERROR(WIFI, "Error setting up MDNS responder!\n");
   } else {
     // Advertise via bonjour the service so we can auto discover these battery emulators on the local network.
     MDNS.addService(mdnsHost, "tcp", 80);
@@ -242,11 +240,11 @@ void init_mDNS() {
 void init_WiFi_AP() {
   ssidAP = std::string("BatteryEmulator") + WiFi.macAddress().c_str();
 
-  DEBUG_PRINTF("Creating Access Point: %s\n", ssidAP.c_str());
-  DEBUG_PRINTF("With password: %s\n", passwordAP.c_str());
+  LOG_INFO(WIFI, "Creating Access Point: %s\n", ssidAP.c_str());
+  LOG_DEBUG(WIFI, "With password: %s\n", passwordAP.c_str());
 
   WiFi.softAP(ssidAP.c_str(), passwordAP.c_str());
   IPAddress IP = WiFi.softAPIP();
 
-  DEBUG_PRINTF("Access Point created.\nIP address: %s\n", IP.toString().c_str());
+  LOG_INFO(WIFI, "Access Point created. IP address: %s\n", IP.toString().c_str());
 }
@@ -51,6 +51,9 @@ static const uint8_t TXBWS = 0 ;
     while (1) {
       xSemaphoreTake (canDriver->mISRSemaphore, portMAX_DELAY) ;
       canDriver->isr_poll_core () ;
+      if (canDriver->mReceiveNotifyTask != nullptr) {
+        xTaskNotifyGive (canDriver->mReceiveNotifyTask) ;
+      }
     }
   }
 #endif
@@ -625,6 +628,36 @@ bool ACAN2517FD::tryToSend (const CANFDMessage & inMessage) {
 
 //----------------------------------------------------------------------------------------------------------------------
 
+uint8_t ACAN2517FD::tryToSendBatch (const CANFDMessage inMessages [], const uint8_t inCount) {
+  uint8_t sent = 0 ;
+  mSPI.beginTransaction (mSPISettings) ;
+    turnOffInterrupts () ;
+      bool ok = true ;
+      while (ok && (sent < inCount)) {
+        const CANFDMessage & message = inMessages [sent] ;
+        ok = message.isValid () ;
+        if (ok && (message.idx == 0)) {
+          ok = message.len <= mTransmitFIFOPayload ;
+          if (ok) {
+            ok = enterInTransmitBuffer (message) ;
+          }
+        }else if (ok && (message.idx == 255)) {
+          ok = message.len <= mTXQBufferPayload ;
+          if (ok) {
+            ok = sendViaTXQ (message) ;
+          }
+        }
+        if (ok) {
+          sent += 1 ;
+        }
+      }
+    turnOnInterrupts () ;
+  mSPI.endTransaction () ;
+  return sent ;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
 bool ACAN2517FD::enterInTransmitBuffer (const CANFDMessage & inMessage) {
   bool result ;
   if (mHardwareTxFIFOFull) {
@@ -86,6 +86,10 @@ class ACAN2517FD {
 
   public: bool tryToSend (const CANFDMessage & inMessage) ;
 
+//--- Sends messages in order within one SPI transaction, stops at the first one that does not fit.
+//    Returns the number of messages accepted.
+  public: uint8_t tryToSendBatch (const CANFDMessage inMessages [], const uint8_t inCount) ;
+
 //······················································································································
 //    Receive a message
 //······················································································································
@@ -160,8 +164,12 @@ class ACAN2517FD {
 
   private: ACANFDBuffer mDriverReceiveBuffer ;
 
+  public: uint32_t driverReceiveBufferSize (void) const { return mDriverReceiveBuffer.size () ; }
+
   public: uint32_t driverReceiveBufferPeakCount (void) const { return mDriverReceiveBuffer.peakCount () ; }
 
+  public: void resetDriverReceiveBufferPeakCount (void) { mDriverReceiveBuffer.resetPeakCount () ; }
+
   public: uint8_t hardwareReceiveBufferOverflowCount (void) const { return mHardwareReceiveBufferOverflowCount ; }
 
   public: void resetHardwareReceiveBufferOverflowCount (void) { mHardwareReceiveBufferOverflowCount = 0 ; }
@@ -218,6 +226,8 @@ class ACAN2517FD {
   private: void transmitInterrupt (void) ;
   #ifdef ARDUINO_ARCH_ESP32
     public: SemaphoreHandle_t mISRSemaphore ;
+    // Task notified each time the handler task has serviced the MCP2517FD
+    public: TaskHandle_t mReceiveNotifyTask = nullptr ;
   #endif
 
 //----------------------------------------------------------------------------------------------------------------------
@@ -352,6 +352,10 @@ void IRAM_ATTR ACAN_ESP32::isr (void * inUserArgument) {
   }
   portEXIT_CRITICAL (&portMux) ;
 
+  if (((interrupt & TWAI_RX_INT_ST) != 0) && (myDriver->mReceiveNotifyTask != NULL)) {
+    vTaskNotifyGiveFromISR (myDriver->mReceiveNotifyTask, NULL) ;
+  }
+
   portYIELD_FROM_ISR () ;
 }
 
@@ -460,6 +464,27 @@ bool ACAN_ESP32::tryToSend (const CANMessage & inMessage) {
 
 //------------------------------------------------------------------------------
 
+uint8_t ACAN_ESP32::tryToSendBatch (const CANMessage inMessages [], const uint8_t inCount) {
+  uint8_t sent = 0 ;
+  portENTER_CRITICAL (&portMux) ;
+    bool ok = true ;
+    while (ok && (sent < inCount)) {
+      if (mDriverIsSending) {
+        ok = mDriverTransmitBuffer.append (inMessages [sent]) ;
+      }else{
+        internalSendMessage (inMessages [sent]) ;
+        mDriverIsSending = true ;
+      }
+      if (ok) {
+        sent += 1 ;
+      }
+    }
+  portEXIT_CRITICAL (&portMux) ;
+  return sent ;
+}
+
+//------------------------------------------------------------------------------
+
 void ACAN_ESP32::internalSendMessage (const CANMessage & inFrame) {
 //--- DLC
   const uint8_t dlc = (inFrame.len <= 8) ? inFrame.len : 8 ;
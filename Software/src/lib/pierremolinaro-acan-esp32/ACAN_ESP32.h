@@ -10,6 +10,8 @@
 #include "ACAN_ESP32_CANMessage.h"
 #include "ACAN_ESP32_Buffer16.h"
 #include "ACAN_ESP32_AcceptanceFilters.h"
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
 
 //------------------------------------------------------------------------------
 //   ESP32 CAN class
@@ -88,11 +90,17 @@ class ACAN_ESP32 {
 
   public: inline void resetDriverReceiveBufferPeakCount (void) { mDriverReceiveBuffer.resetPeakCount () ; }
 
+  // Task notified from the interrupt handler each time a frame has been received
+  public: TaskHandle_t mReceiveNotifyTask = NULL ;
+
   // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
   //    Transmitting messages
   // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 
   public: bool tryToSend (const CANMessage & inMessage) ;
+//--- Sends messages in order within one critical section, stops at the first one that does not fit.
+//    Returns the number of messages accepted.
+  public: uint8_t tryToSendBatch (const CANMessage inMessages [], const uint8_t inCount) ;
   private: void internalSendMessage (const CANMessage & inFrame) ;
 
   // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
@@ -77,6 +77,9 @@ static const uint8_t RXFSIDH_REGISTER [6] = {0x00, 0x04, 0x08, 0x10, 0x14, 0x18}
       while (loop) {
         loop = canDriver->isr_core () ;
       }
+      if (canDriver->mReceiveNotifyTask != nullptr) {
+        xTaskNotifyGive (canDriver->mReceiveNotifyTask) ;
+      }
     }
   }
 #endif
@@ -956,3 +959,34 @@ bool ACAN2515::tryToSend (const CANMessage & inMessage) {
 }
 
 //··································································································
+
+uint8_t ACAN2515::tryToSendBatch (const CANMessage inMessages [], const uint8_t inCount) {
+  uint8_t sent = 0 ;
+  #ifndef ARDUINO_ARCH_ESP32
+    noInterrupts () ;
+  #endif
+    mSPI.beginTransaction (mSPISettings) ;
+      bool ok = true ;
+      while (ok && (sent < inCount)) {
+        uint8_t idx = inMessages [sent].idx ;
+        if (idx > 2) {
+          idx = 0 ;
+        }
+        if (mTXBIsFree [idx]) {
+          mTXBIsFree [idx] = false ;
+          internalSendMessage (inMessages [sent], idx) ;
+        }else{
+          ok = mTransmitBuffer [idx].append (inMessages [sent]) ;
+        }
+        if (ok) {
+          sent += 1 ;
+        }
+      }
+    mSPI.endTransaction () ;
+  #ifndef ARDUINO_ARCH_ESP32
+    interrupts () ;
+  #endif
+  return sent ;
+}
+
+//··································································································
@@ -131,6 +131,8 @@ class ACAN2515 {
   #ifdef ARDUINO_ARCH_ESP32
     public: SemaphoreHandle_t mISRSemaphore ;
     private: void (* mInterruptServiceRoutine) (void) = nullptr ;
+    // Task notified each time the handler task has serviced the MCP2515
+    public: TaskHandle_t mReceiveNotifyTask = nullptr ;
   #endif
 
 
@@ -167,6 +169,10 @@ class ACAN2515 {
     return mReceiveBuffer.peakCount () ;
   }
 
+  public: inline void resetReceiveBufferPeakCount (void) {
+    mReceiveBuffer.resetPeakCount () ;
+  }
+
 
 //··································································································
 //    Call back function array
@@ -183,6 +189,10 @@ class ACAN2515 {
 
   public: bool tryToSend (const CANMessage & inMessage) ;
 
+//--- Sends messages in order within one SPI transaction, stops at the first one that does not fit.
+//    Returns the number of messages accepted.
+  public: uint8_t tryToSendBatch (const CANMessage inMessages [], const uint8_t inCount) ;
+
 
 //··································································································
 //    Driver transmit buffer
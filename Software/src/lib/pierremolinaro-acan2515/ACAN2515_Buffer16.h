@@ -80,6 +80,8 @@ class ACAN2515_Buffer16 {
       if (mPeakCount < mCount) {
         mPeakCount = mCount ;
       }
+    }else{
+      mPeakCount = mSize + 1 ; // Overflow
     }
     return ok ;
   }
@@ -22,6 +22,28 @@
  * Parameter: TASK_ACAN2515_PRIORITY
  * Description:
  * Defines the priority of ACAN2517FD CAN-FD handling
+ *
+ * Parameter: TASK_CAN_RX_PRIO
+ * Description:
+ * Defines the priority of the task moving received CAN frames from the drivers to the core task
+ *
+ * Parameter: TASK_SD_WRITER_PRIO
+ * Description:
+ * Defines the priority of the task writing the CAN and debug logs to the SD card. Kept below everything else,
+ * the ring buffers in front of it absorb the slow periods of the card.
+ *
+ * Parameter: TASK_LOG_FORMATTER_PRIO
+ * Description:
+ * Defines the priority of the task formatting deferred log messages, see DEFERRED_LOGGING
+ *
+ * Parameter: TASK_USB_CAN_PRIO
+ * Description:
+ * Defines the priority of the task streaming CAN frames over USB serial
+ *
+ * Parameter: TASK_CAN_REPLAY_PRIO
+ * Description:
+ * Defines the priority of the CAN replay task. It runs on the core of the core task, below it, and only spins
+ * for the last CAN_REPLAY_SPIN_US before each frame.
 */
 #define TASK_CORE_PRIO 4
 #define TASK_CONNECTIVITY_PRIO 3
@@ -29,6 +51,100 @@
 #define TASK_MODBUS_PRIO 8
 #define TASK_ACAN2515_PRIORITY 10
 #define TASK_ACAN2517FD_PRIORITY 10
+#define TASK_CAN_RX_PRIO 9
+#define TASK_SD_WRITER_PRIO 1
+#define TASK_LOG_FORMATTER_PRIO 1
+#define TASK_USB_CAN_PRIO 2
+#define TASK_CAN_REPLAY_PRIO 2
+
+/** WEB LOG BUFFERS
+ *
+ * Parameter: WEB_LOG_BUFFER_SIZE / WEB_CAN_LOG_BUFFER_SIZE
+ * Description:
+ * Size in bytes of the rings holding the debug log and the CAN log shown in the webserver. Powers of two,
+ * the oldest messages are overwritten once full.
+*/
+#define WEB_LOG_BUFFER_SIZE (16 * 1024)
+#define WEB_CAN_LOG_BUFFER_SIZE (16 * 1024)
+
+/** DEFERRED LOGGING
+ *
+ * Parameter: DEFERRED_LOGGING
+ * Description:
+ * When true, DEBUG_PRINTF and LOG_* only record the format string, a timestamp and the arguments, and a low
+ * priority task on the connectivity core formats them later. Keeps printf formatting out of the control loop.
+ * Deferred messages can appear after plain prints made later.
+ *
+ * Parameter: DEFERRED_LOG_BUFFER_SIZE
+ * Description:
+ * Size in bytes of the ring holding messages waiting to be formatted. Power of two.
+ *
+ * Parameter: DEFERRED_LOG_INTERVAL_MS
+ * Description:
+ * How often the formatting task empties the ring
+*/
+#define DEFERRED_LOGGING true
+#define DEFERRED_LOG_BUFFER_SIZE (8 * 1024)
+#define DEFERRED_LOG_INTERVAL_MS 20
+
+/** USB CAN STREAM
+ *
+ * Parameter: USB_CAN_RING_BUFFER_SIZE
+ * Description:
+ * Bytes of CAN frames waiting for the USB serial port. Covers bursts while the host is slow to read,
+ * frames that don't fit are dropped and counted.
+ *
+ * Parameter: USB_CAN_WRITE_BLOCK_SIZE
+ * Description:
+ * Formatted frames are gathered into blocks of up to this size before handing them to the USB serial port
+ *
+ * Parameter: USB_CAN_IDLE_WAIT_MS
+ * Description:
+ * How long the streaming task waits for frames before checking for GVRET commands from the host
+*/
+#define USB_CAN_RING_BUFFER_SIZE (16 * 1024)
+#define USB_CAN_WRITE_BLOCK_SIZE 2048
+#define USB_CAN_IDLE_WAIT_MS 10
+
+/** CAN REPLAY
+ *
+ * Parameter: CAN_REPLAY_MAX_SIZE
+ * Description:
+ * Most bytes of binary frame records kept for CAN replay, allocated when a log is uploaded and placed in
+ * PSRAM when available. A classic frame takes 24 bytes, a CAN-FD frame 80. Frames beyond it are dropped.
+ *
+ * Parameter: CAN_REPLAY_SD_BLOCK_SIZE
+ * Description:
+ * Size of each of the two blocks a CAN log on the SD card is read into while it is replayed. One block has to
+ * last for as long as reading the next one takes.
+ *
+ * Parameter: CAN_REPLAY_SPIN_US
+ * Description:
+ * The replay task sleeps on an esp_timer until this long before a frame is due and busy-waits for the rest.
+ * Covers the wake-up latency of the timer task, larger values cost CPU time on dense logs.
+ *
+ * Parameter: CAN_REPLAY_LATE_TOLERANCE_US
+ * Description:
+ * How long after its deadline a replayed frame may go out before it is counted as late
+*/
+#define CAN_REPLAY_MAX_SIZE (128 * 1024)
+#define CAN_REPLAY_SD_BLOCK_SIZE (16 * 1024)
+#define CAN_REPLAY_SPIN_US 200
+#define CAN_REPLAY_LATE_TOLERANCE_US 500
+
+/** LOG LEVELS
+ *
+ * Parameter: LOG_LEVEL_COMPILED
+ * Description:
+ * Most verbose level built into the firmware. LOG_DEBUG, LOG_TRACE etc. calls above it are removed entirely,
+ * arguments included. Lower it to LOG_LEVEL_INFO for builds where every byte and cycle counts.
+ *
+ * Parameter: LOG_LEVEL_DEFAULT
+ * Description:
+ * Runtime level of each module until changed on the settings page
+*/
+#define LOG_LEVEL_COMPILED LOG_LEVEL_TRACE
+#define LOG_LEVEL_DEFAULT LOG_LEVEL_INFO
 
 /** MAX AMOUNT OF CELLS
  * 
@@ -38,4 +154,117 @@
 */
 #define MAX_AMOUNT_CELLS 192
 
+/** CAN RECEIVE BATCHING
+ * 
+ * Parameter: CAN_RX_BATCH_MAX_FRAMES
+ * Description:
+ * Maximum amount of frames one receive_can() call hands to the receivers. Counts the frames the CAN RX task
+ * queued for the core task and the frames CAN replay injects together.
+ * 
+ * Parameter: CAN_RX_BATCH_MAX_US
+ * Description:
+ * Maximum time in microseconds one receive_can() call spends on those two queues.
+ * Frames left queued are handled by the next call, core_loop comes straight back for them.
+ *
+ * Parameter: CAN_RX_QUEUE_SIZE
+ * Description:
+ * Amount of received frames the CAN RX task can queue for the core task. Must be a power of two.
+*/
+#define CAN_RX_BATCH_MAX_FRAMES 64
+#define CAN_RX_BATCH_MAX_US 500
+#define CAN_RX_QUEUE_SIZE 128
+
+/** CAN TRANSMIT BATCHING AND QUEUEING
+ *
+ * Parameter: CAN_TX_BATCH_MAX_FRAMES
+ * Description:
+ * Maximum amount of frames transmit_can_frames() converts and hands to a CAN driver at once.
+ * The converted frames live on the stack of the sending task, up to 72 bytes each for CAN-FD.
+ *
+ * Parameter: CAN_TX_QUEUE_SIZE
+ * Description:
+ * Amount of frames per CAN controller that are kept for a retry on the next core_loop tick when the
+ * driver cannot take them, for instance during bus-off recovery or on a heavily loaded bus
+*/
+#define CAN_TX_BATCH_MAX_FRAMES 4
+#define CAN_TX_QUEUE_SIZE 16
+
+/** CAN HARDWARE FILTERS
+ *
+ * Parameter: CAN_HARDWARE_FILTERS
+ * Description:
+ * When true, the CAN controllers are set up to only accept the IDs the registered receivers declare,
+ * so frames nobody handles never reach the CPU. Ignored while CAN logging via USB, SD card or the webserver
+ * is enabled, as the log should show the whole bus. Set to false to always receive every frame.
+*/
+#define CAN_HARDWARE_FILTERS true
+
+/** CAN TX TIMING
+ *
+ * Parameter: CAN_TX_TIMING_MAX_MESSAGES
+ * Description:
+ * Amount of cyclic CAN messages whose transmit intervals can be monitored at the same time
+ *
+ * Parameter: CAN_TX_LATE_TOLERANCE_US
+ * Description:
+ * How much longer than its period an interval may be before the message is counted as late.
+ * Cyclic messages are sent from the 1 ms core_loop tick, so a millisecond of jitter is expected.
+*/
+#define CAN_TX_TIMING_MAX_MESSAGES 8
+#define CAN_TX_LATE_TOLERANCE_US 1000
+
+/** SD CARD WRITING
+ *
+ * Parameter: SD_CAN_RING_BUFFER_SIZE / SD_LOG_RING_BUFFER_SIZE
+ * Description:
+ * Size in bytes of the buffers between the tasks producing CAN and debug log data and the SD card writer
+ * The CAN buffer holds one record per item, each taking 8 bytes more than the record itself.
+ *
+ * Parameter: SD_CAN_WRITE_BLOCK_SIZE / SD_LOG_WRITE_BLOCK_SIZE
+ * Description:
+ * Size in bytes of the blocks gathered before writing to the card, placed in PSRAM when available.
+ * Blocks end on 512 byte sector boundaries of the file. Keep between 4 and 32 kB.
+ *
+ * Parameter: SD_WRITE_FLUSH_INTERVAL_MS
+ * Description:
+ * Longest time data waits in a partially filled block before it is written to the card
+ *
+ * Parameter: SD_WRITE_FLUSH_WAIT_MS
+ * Description:
+ * How long pausing a log (before export) waits for the SD writer to write out its block and close the file
+ *
+ * Parameter: SD_WRITER_IDLE_WAIT_MS
+ * Description:
+ * Longest time the SD writer blocks on a ring buffer before checking for flushes, rotation and pause requests.
+ * With both the CAN and the debug log active it waits on each in turn, for a quarter of this time.
+*/
+#define SD_CAN_RING_BUFFER_SIZE (32 * 1024)
+#define SD_LOG_RING_BUFFER_SIZE 1024
+#define SD_CAN_WRITE_BLOCK_SIZE (16 * 1024)
+#define SD_LOG_WRITE_BLOCK_SIZE (4 * 1024)
+#define SD_WRITE_FLUSH_INTERVAL_MS 1000
+#define SD_WRITE_FLUSH_WAIT_MS 200
+#define SD_WRITER_IDLE_WAIT_MS 100
+
+/** SD CARD LOG ROTATION
+ *
+ * Parameter: SD_LOG_SEGMENT_MAX_BYTES
+ * Description:
+ * The CAN and debug logs are split into numbered segment files, a new one is started once the current
+ * segment reaches this size
+ *
+ * Parameter: SD_LOG_SEGMENT_MAX_AGE_S
+ * Description:
+ * A new segment is also started when the current one is this many seconds old
+ *
+ * Parameter: SD_CAN_LOG_MAX_TOTAL_BYTES / SD_LOG_MAX_TOTAL_BYTES
+ * Description:
+ * Most space the CAN and debug log segments may take on the card together, the oldest segments are
+ * deleted to stay below it
+*/
+#define SD_LOG_SEGMENT_MAX_BYTES (16 * 1024 * 1024)
+#define SD_LOG_SEGMENT_MAX_AGE_S 3600
+#define SD_CAN_LOG_MAX_TOTAL_BYTES (1024ULL * 1024 * 1024)
+#define SD_LOG_MAX_TOTAL_BYTES (128ULL * 1024 * 1024)
+
 #endif
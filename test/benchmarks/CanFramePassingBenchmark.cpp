@@ -0,0 +1,58 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+
+#include "../../Software/src/communication/can/CanReceiver.h"
+
+// Compares delivering CAN frames to a receiver by value (the old CanCharger interface)
+// against delivering them by const reference. Timings are reported, not asserted,
+// since they depend on the host running the tests.
+
+class ByValueReceiver {
+ public:
+  virtual void map_can_frame_to_variable(CAN_frame rx_frame) = 0;
+};
+
+class ByValueCharger : public ByValueReceiver {
+ public:
+  void map_can_frame_to_variable(CAN_frame rx_frame) { sum += rx_frame.ID + rx_frame.data.u8[0]; }
+  uint64_t sum = 0;
+};
+
+class ByReferenceCharger : public CanReceiver {
+ public:
+  void receive_can_frame(const CAN_frame& rx_frame) { sum += rx_frame.ID + rx_frame.data.u8[0]; }
+  uint64_t sum = 0;
+};
+
+static constexpr int BENCHMARK_FRAMES = 2000000;
+
+template <typename F>
+static double ns_per_frame(F deliver) {
+  CAN_frame frame = {.DLC = 8, .ID = 0x390, .data = {.u8 = {1, 2, 3, 4, 5, 6, 7, 8}}};
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < BENCHMARK_FRAMES; i++) {
+    frame.data.u8[0] = (uint8_t)i;
+    deliver(frame);
+  }
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  return std::chrono::duration<double, std::nano>(elapsed).count() / BENCHMARK_FRAMES;
+}
+
+TEST(CanFramePassingBenchmark, ConstReferenceVersusByValue) {
+  ByValueCharger by_value;
+  ByReferenceCharger by_reference;
+  // Volatile pointers keep the compiler from devirtualizing and eliding the copies
+  ByValueReceiver* volatile value_receiver = &by_value;
+  CanReceiver* volatile reference_receiver = &by_reference;
+
+  double value_ns = ns_per_frame([&](CAN_frame& frame) { value_receiver->map_can_frame_to_variable(frame); });
+  double reference_ns = ns_per_frame([&](CAN_frame& frame) { reference_receiver->receive_can_frame(frame); });
+
+  EXPECT_EQ(by_value.sum, by_reference.sum);
+
+  std::cout << "CAN frame delivery by value: " << value_ns << " ns/frame, by const reference: " << reference_ns
+            << " ns/frame\n";
+  RecordProperty("by_value_ns_per_frame", std::to_string(value_ns));
+  RecordProperty("by_reference_ns_per_frame", std::to_string(reference_ns));
+}
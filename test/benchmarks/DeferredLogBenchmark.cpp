@@ -0,0 +1,66 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdarg>
+#include <cstdio>
+
+#include "../../Software/src/devboard/utils/deferred_log.h"
+#include "../../Software/src/devboard/utils/log_ring.h"
+
+// Compares the cost of a log call on the calling task: formatting with vsnprintf and storing the text,
+// as Logging::printf does, against storing the raw arguments for deferred formatting. Timings are
+// reported, not asserted, since they depend on the host running the tests.
+
+static LogRing<8 * 1024> text_ring;
+static LogRing<8 * 1024> deferred_ring;
+
+static void log_formatted(const char* fmt, ...) {
+  char message_buffer[128];
+  va_list args;
+  va_start(args, fmt);
+  int size = vsnprintf(message_buffer, sizeof(message_buffer), fmt, args);
+  va_end(args);
+  text_ring.write(message_buffer, std::min(size, (int)sizeof(message_buffer) - 1));
+}
+
+template <typename... Args>
+static void log_deferred(const char* fmt, Args... args) {
+  DeferredLogRecord record(0, fmt);
+  (record.add(args), ...);
+  deferred_ring.write(record.bytes(), record.size());
+}
+
+static constexpr int BENCHMARK_CALLS = 500000;
+
+template <typename F>
+static double ns_per_call(F log) {
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < BENCHMARK_CALLS; i++) {
+    log(i);
+  }
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  return std::chrono::duration<double, std::nano>(elapsed).count() / BENCHMARK_CALLS;
+}
+
+TEST(DeferredLogBenchmark, DeferredVersusFormatted) {
+  // The Chevy Volt charger status dump, the heaviest regular log call made from the core loop
+  const char* fmt = "Charger HV out IDC=%fA VDC=%fV mode=%s set=%uV\n";
+  double formatted_ns =
+      ns_per_call([&](int i) { log_formatted(fmt, i * 0.01f, 380.5f + i % 10, "Enabled", (unsigned)(i & 0x1ff)); });
+  double deferred_ns =
+      ns_per_call([&](int i) { log_deferred(fmt, i * 0.01f, 380.5f + i % 10, "Enabled", (unsigned)(i & 0x1ff)); });
+
+  // The consumer produces the same text later
+  uint32_t cursor = deferred_ring.oldest();
+  uint8_t record[DEFERRED_LOG_MAX_RECORD];
+  size_t size = deferred_ring.read(cursor, record, sizeof(record));
+  ASSERT_GT(size, 0u);
+  char text[128];
+  format_deferred_log(record, size, text, sizeof(text));
+  EXPECT_NE(strstr(text, "mode=Enabled"), nullptr);
+
+  std::cout << "Log call formatted on the caller: " << formatted_ns << " ns/call, deferred: " << deferred_ns
+            << " ns/call\n";
+  RecordProperty("formatted_ns_per_call", std::to_string(formatted_ns));
+  RecordProperty("deferred_ns_per_call", std::to_string(deferred_ns));
+}
@@ -0,0 +1,73 @@
+#include <gtest/gtest.h>
+
+#include "../../Software/src/communication/can/CanDispatcher.h"
+
+class RecordingReceiver : public CanReceiver {
+ public:
+  explicit RecordingReceiver(std::vector<CAN_id_range> ids) : ids(ids) {}
+
+  void receive_can_frame(const CAN_frame& rx_frame) { received.push_back(rx_frame.ID); }
+  std::vector<CAN_id_range> can_ids_of_interest() { return ids; }
+
+  std::vector<CAN_id_range> ids;
+  std::vector<uint32_t> received;
+};
+
+static void send(CanDispatcher& dispatcher, uint32_t id, bool ext_ID = false) {
+  CAN_frame frame = {.ext_ID = ext_ID, .ID = id};
+  dispatcher.dispatch(frame);
+}
+
+TEST(CanDispatcherTests, ShouldOnlyDeliverDeclaredStandardIds) {
+  CanDispatcher dispatcher;
+  RecordingReceiver receiver({{0x390, 0x390, false}, {0x679, 0x679, false}});
+  dispatcher.add_receiver(&receiver, receiver.can_ids_of_interest());
+
+  send(dispatcher, 0x390);
+  send(dispatcher, 0x391);
+  send(dispatcher, 0x679);
+  send(dispatcher, 0x390, true);
+
+  EXPECT_EQ(receiver.received, (std::vector<uint32_t>{0x390, 0x679}));
+}
+
+TEST(CanDispatcherTests, ShouldDeliverRangesAndExtendedIds) {
+  CanDispatcher dispatcher;
+  RecordingReceiver receiver({{0x100, 0x10F, false}, {0x18DAF110, 0x18DAF110, true}, {0x1000, 0x2000, true}});
+  dispatcher.add_receiver(&receiver, receiver.can_ids_of_interest());
+
+  send(dispatcher, 0x0FF);
+  send(dispatcher, 0x105);
+  send(dispatcher, 0x18DAF110, true);
+  send(dispatcher, 0x18DAF111, true);
+  send(dispatcher, 0x1800, true);
+  send(dispatcher, 0x2001, true);
+
+  EXPECT_EQ(receiver.received, (std::vector<uint32_t>{0x105, 0x18DAF110, 0x1800}));
+}
+
+TEST(CanDispatcherTests, ShouldDeliverEverythingToReceiversWithoutDeclaredIds) {
+  CanDispatcher dispatcher;
+  RecordingReceiver sniffer({});
+  RecordingReceiver charger({{0x1DB, 0x1DB, false}});
+  dispatcher.add_receiver(&sniffer, sniffer.can_ids_of_interest());
+  dispatcher.add_receiver(&charger, charger.can_ids_of_interest());
+
+  send(dispatcher, 0x1DB);
+  send(dispatcher, 0x7FF);
+  send(dispatcher, 0x12345, true);
+
+  EXPECT_TRUE(dispatcher.wants_all());
+  EXPECT_EQ(sniffer.received, (std::vector<uint32_t>{0x1DB, 0x7FF, 0x12345}));
+  EXPECT_EQ(charger.received, (std::vector<uint32_t>{0x1DB}));
+}
+
+TEST(CanDispatcherTests, ShouldRejectReceiversBeyondLimit) {
+  CanDispatcher dispatcher;
+  RecordingReceiver receiver({{0x1, 0x1, false}});
+
+  for (size_t i = 0; i < CanDispatcher::MAX_RECEIVERS; i++) {
+    EXPECT_TRUE(dispatcher.add_receiver(&receiver, receiver.can_ids_of_interest()));
+  }
+  EXPECT_FALSE(dispatcher.add_receiver(&receiver, receiver.can_ids_of_interest()));
+}
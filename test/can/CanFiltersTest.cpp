@@ -0,0 +1,120 @@
+#include <gtest/gtest.h>
+
+#include "../../Software/src/communication/can/CanFilters.h"
+
+static bool any_accepts(const std::vector<CAN_acceptance_filter>& filters, uint32_t id, bool ext_ID) {
+  for (auto& filter : filters) {
+    if (filter_accepts(filter, id, ext_ID)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+static bool in_ranges(const std::vector<CAN_id_range>& ranges, uint32_t id, bool ext_ID) {
+  for (auto& range : ranges) {
+    if (range.ext_ID == ext_ID && id >= range.first && id <= range.last) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Every standard ID accepted, and the amount of IDs let through that were not asked for
+static size_t count_extra_standard_ids(const std::vector<CAN_acceptance_filter>& filters,
+                                       const std::vector<CAN_id_range>& ranges) {
+  size_t extra = 0;
+  for (uint32_t id = 0; id <= 0x7FF; id++) {
+    bool wanted = in_ranges(ranges, id, false);
+    bool accepted = any_accepts(filters, id, false);
+    EXPECT_TRUE(accepted || !wanted) << "ID 0x" << std::hex << id << " is rejected";
+    if (accepted && !wanted) {
+      extra++;
+    }
+  }
+  return extra;
+}
+
+static const std::vector<CAN_id_range> leaf_ids = {{0x390, 0x390, false}, {0x393, 0x393, false},
+                                                   {0x679, 0x679, false}};
+
+TEST(CanFiltersTests, ShouldAcceptExactlyTheRequestedIdsWhenFiltersSuffice) {
+  std::vector<CAN_id_range> ranges = {{0x100, 0x17F, false}, {0x305, 0x30A, false}, {0x7FF, 0x7FF, false}};
+
+  auto filters = compute_acceptance_filters(ranges, false, 32);
+
+  EXPECT_EQ(count_extra_standard_ids(filters, ranges), 0);
+  // 0x100-0x17F is one aligned block, 0x305-0x30A splits into 0x305, 0x306-0x307, 0x308-0x309, 0x30A
+  EXPECT_EQ(filters.size(), 6);
+}
+
+TEST(CanFiltersTests, ShouldMergeTheClosestIdsWhenFiltersRunOut) {
+  auto filters = compute_acceptance_filters(leaf_ids, false, 2);
+
+  ASSERT_EQ(filters.size(), 2);
+  // 0x390 and 0x393 only differ in their lowest two bits, so 0x391 and 0x392 are let through as well
+  EXPECT_EQ(count_extra_standard_ids(filters, leaf_ids), 2);
+}
+
+TEST(CanFiltersTests, NativePlanShouldUseDualStandardOrSingleExtendedFilter) {
+  auto standard = plan_native_filters(leaf_ids);
+  EXPECT_FALSE(standard.accept_all);
+  EXPECT_EQ(standard.filters.size(), 2);
+
+  std::vector<CAN_id_range> extended = {{0x18DAF110, 0x18DAF110, true}, {0x18DAF111, 0x18DAF111, true}};
+  auto plan = plan_native_filters(extended);
+  ASSERT_EQ(plan.filters.size(), 1);
+  EXPECT_TRUE(filter_accepts(plan.filters[0], 0x18DAF110, true));
+  EXPECT_TRUE(filter_accepts(plan.filters[0], 0x18DAF111, true));
+  EXPECT_FALSE(filter_accepts(plan.filters[0], 0x18DAF112, true));
+  EXPECT_FALSE(filter_accepts(plan.filters[0], 0x110, false));
+}
+
+TEST(CanFiltersTests, ShouldAcceptAllWhenEverythingOrMixedFormatsAreWanted) {
+  EXPECT_TRUE(plan_native_filters({}).accept_all);
+  EXPECT_TRUE(plan_mcp2515_filters({}).accept_all);
+  EXPECT_TRUE(plan_mcp2518_filters({}).accept_all);
+
+  std::vector<CAN_id_range> mixed = {{0x390, 0x390, false}, {0x18DAF110, 0x18DAF110, true}};
+  EXPECT_TRUE(plan_native_filters(mixed).accept_all);
+  EXPECT_TRUE(plan_mcp2515_filters(mixed).accept_all);
+
+  // The MCP2518 has a format per filter
+  auto plan = plan_mcp2518_filters(mixed);
+  EXPECT_FALSE(plan.accept_all);
+  EXPECT_TRUE(any_accepts(plan.filters, 0x390, false));
+  EXPECT_TRUE(any_accepts(plan.filters, 0x18DAF110, true));
+  EXPECT_FALSE(any_accepts(plan.filters, 0x390, true));
+  EXPECT_FALSE(any_accepts(plan.filters, 0x18DAF111, true));
+}
+
+TEST(CanFiltersTests, Mcp2515PlanShouldShareMasksBetweenFilterGroups) {
+  std::vector<CAN_id_range> chevy_ids = {{0x212, 0x212, false}, {0x266, 0x266, false}, {0x268, 0x268, false},
+                                         {0x308, 0x308, false}, {0x30A, 0x30A, false}};
+
+  auto plan = plan_mcp2515_filters(chevy_ids);
+
+  ASSERT_FALSE(plan.accept_all);
+  ASSERT_GE(plan.filters.size(), 3);
+  ASSERT_LE(plan.filters.size(), 6);
+  for (size_t i = 0; i < plan.filters.size(); i++) {
+    EXPECT_EQ(plan.filters[i].mask, plan.masks[i < 2 ? 0 : 1]);
+  }
+  // Five IDs fit in six filters, but the shared masks cost a few extra IDs
+  EXPECT_LE(count_extra_standard_ids(plan.filters, chevy_ids), 4);
+
+  auto single = plan_mcp2515_filters({{0x679, 0x679, false}});
+  ASSERT_EQ(single.filters.size(), 1);
+  EXPECT_EQ(count_extra_standard_ids(single.filters, {{0x679, 0x679, false}}), 0);
+}
+
+TEST(CanFiltersTests, Mcp2518PlanShouldSplitLargeExtendedRanges) {
+  std::vector<CAN_id_range> ranges = {{0x1000, 0x2000, true}, {0x1FFFFFFF, 0x1FFFFFFF, true}};
+
+  auto plan = plan_mcp2518_filters(ranges);
+
+  ASSERT_LE(plan.filters.size(), MCP2518_MAX_FILTERS);
+  for (uint32_t id : {0x0FFFu, 0x1000u, 0x1800u, 0x2000u, 0x2001u, 0x1FFFFFFEu, 0x1FFFFFFFu}) {
+    EXPECT_EQ(any_accepts(plan.filters, id, true), in_ranges(ranges, id, true)) << std::hex << id;
+  }
+}
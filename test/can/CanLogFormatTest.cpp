@@ -0,0 +1,234 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "../../Software/src/devboard/sdcard/can_log_format.h"
+
+TEST(CanLogFormatTests, ShouldRoundTripClassicFrame) {
+  CAN_frame frame = {.FD = false, .ext_ID = false, .DLC = 8, .ID = 0x1F2, .data = {1, 2, 3, 4, 5, 6, 7, 8}};
+  uint8_t buffer[CAN_LOG_RECORD_MAX_SIZE];
+
+  const size_t size = encode_can_log_record(frame, MSG_TX, CAN_ADDON_MCP2515, 1234567890123, buffer);
+  EXPECT_EQ(size, CAN_LOG_HEADER_SIZE + 8);
+
+  CAN_log_record record;
+  ASSERT_EQ(decode_can_log_record(buffer, size, record), size);
+  EXPECT_EQ(record.timestamp_us, 1234567890123);
+  EXPECT_EQ(record.ID, 0x1F2);
+  EXPECT_EQ(record.DLC, 8);
+  EXPECT_EQ(record.interface, CAN_ADDON_MCP2515);
+  EXPECT_EQ(record.flags, CAN_LOG_FLAG_TX);
+  EXPECT_EQ(record.data[0], 1);
+  EXPECT_EQ(record.data[7], 8);
+}
+
+TEST(CanLogFormatTests, ShouldStoreFdFramesWithTheirWholePayload) {
+  CAN_frame frame = {.FD = true, .ext_ID = true, .DLC = 64, .ID = 0x18DAF1DB};
+  for (int i = 0; i < 64; i++) {
+    frame.data.u8[i] = i;
+  }
+  uint8_t buffer[CAN_LOG_RECORD_MAX_SIZE];
+
+  const size_t size = encode_can_log_record(frame, MSG_RX, CANFD_NATIVE, 1, buffer);
+  EXPECT_EQ(size, CAN_LOG_RECORD_MAX_SIZE);
+
+  CAN_log_record record;
+  ASSERT_EQ(decode_can_log_record(buffer, size, record), size);
+  EXPECT_EQ(record.flags, CAN_LOG_FLAG_EXT | CAN_LOG_FLAG_FD);
+  EXPECT_EQ(record.ID, 0x18DAF1DB);
+  EXPECT_EQ(record.data[63], 63);
+}
+
+TEST(CanLogFormatTests, ShouldNotDecodeTruncatedRecord) {
+  CAN_frame frame = {.FD = false, .ext_ID = false, .DLC = 3, .ID = 0x123, .data = {0xAA, 0xBB, 0xCC}};
+  uint8_t buffer[CAN_LOG_RECORD_MAX_SIZE];
+  const size_t size = encode_can_log_record(frame, MSG_RX, CAN_NATIVE, 1, buffer);
+
+  CAN_log_record record;
+  EXPECT_EQ(decode_can_log_record(buffer, size - 1, record), 0);
+  EXPECT_EQ(decode_can_log_record(buffer, 4, record), 0);
+  ASSERT_EQ(decode_can_log_record(buffer, size, record), size);
+  EXPECT_EQ(record.data[3], 0);  // Unused payload is zeroed
+}
+
+TEST(CanLogFormatTests, ShouldFormatLinesLikeTheWebCanLogger) {
+  CAN_log_record record = {.timestamp_us = 12003456, .ID = 0x1DB, .flags = CAN_LOG_FLAG_TX, .DLC = 3,
+                           .interface = CAN_ADDON_MCP2515, .data = {0x0A, 0xFF, 0}};
+  char line[CAN_LOG_LINE_MAX_SIZE];
+
+  EXPECT_EQ(format_can_log_line(record, line, sizeof(line)), strlen("(12.003456) TX5 1DB [3] 0A FF 00\n"));
+  EXPECT_STREQ(line, "(12.003456) TX5 1DB [3] 0A FF 00\n");
+
+  record.flags = 0;
+  record.DLC = 0;
+  format_can_log_line(record, line, sizeof(line));
+  EXPECT_STREQ(line, "(12.003456) RX4 1DB [0]\n");
+
+  EXPECT_EQ(format_can_log_line(record, line, 8), 7);
+  EXPECT_STREQ(line, "(12.003");
+}
+
+TEST(CanLogFormatTests, ShouldParseTheLinesItFormats) {
+  CAN_log_record written = {.timestamp_us = 84215921003, .ID = 0x18DAF1DB, .flags = CAN_LOG_FLAG_EXT | CAN_LOG_FLAG_TX,
+                            .DLC = 8, .interface = 1, .data = {1, 2, 3, 4, 5, 6, 7, 0xFE}};
+  char line[CAN_LOG_LINE_MAX_SIZE];
+  const size_t len = format_can_log_line(written, line, sizeof(line));
+
+  CAN_log_record record;
+  ASSERT_TRUE(parse_can_log_line(line, len, record));
+  EXPECT_EQ(record.timestamp_us, 84215921003);
+  EXPECT_EQ(record.ID, 0x18DAF1DB);
+  EXPECT_EQ(record.flags, CAN_LOG_FLAG_EXT | CAN_LOG_FLAG_TX);
+  EXPECT_EQ(record.interface, 3);  // The bus column as written, TX of interface 1
+  EXPECT_EQ(record.DLC, 8);
+  EXPECT_EQ(record.data[7], 0xFE);
+}
+
+TEST(CanLogFormatTests, ShouldKeepSmallExtendedIdsExtended) {
+  CAN_log_record written = {.timestamp_us = 1000000, .ID = 0x1AB, .flags = CAN_LOG_FLAG_EXT, .DLC = 1,
+                            .interface = 0, .data = {0x42}};
+  char line[CAN_LOG_LINE_MAX_SIZE];
+  const size_t len = format_can_log_line(written, line, sizeof(line));
+  EXPECT_STREQ(line, "(1.000000) RX0 000001AB [1] 42\n");
+
+  CAN_log_record record;
+  ASSERT_TRUE(parse_can_log_line(line, len, record));
+  EXPECT_EQ(record.ID, 0x1AB);
+  EXPECT_EQ(record.flags, CAN_LOG_FLAG_EXT);
+}
+
+TEST(CanLogFormatTests, ShouldParseLogsWithMillisecondTimestampsAndLowercaseData) {
+  const char* line = "(123.893) RX0 f5 [8] 03 fe fe 00 00 00 00 00\r";
+  CAN_log_record record;
+
+  ASSERT_TRUE(parse_can_log_line(line, strlen(line), record));
+  EXPECT_EQ(record.timestamp_us, 123893000);
+  EXPECT_EQ(record.ID, 0xF5);
+  EXPECT_EQ(record.flags, 0);
+  EXPECT_EQ(record.data[1], 0xFE);
+
+  const char* fd = "(1.5) RX2 00000123 [12] 01 02";
+  ASSERT_TRUE(parse_can_log_line(fd, strlen(fd), record));
+  EXPECT_EQ(record.flags, CAN_LOG_FLAG_EXT | CAN_LOG_FLAG_FD);
+  EXPECT_EQ(record.timestamp_us, 1500000);
+  EXPECT_EQ(record.DLC, 12);
+  EXPECT_EQ(record.data[1], 2);
+  EXPECT_EQ(record.data[2], 0);
+}
+
+TEST(CanLogFormatTests, ShouldRejectLinesThatAreNotFrames) {
+  CAN_log_record record;
+  for (const char* line : {"", "# 450V pack (overvoltage)", "(12.5 RX0 1DB [1] 00", "(1.0) RX0 [1] 00",
+                           "(1.0) RX0 1DB 1 00", "(1.0) RX0 1DB [65] 00"}) {
+    EXPECT_FALSE(parse_can_log_line(line, strlen(line), record)) << line;
+  }
+}
+
+TEST(CanLogFormatTests, ShouldParseLinesSplitAcrossChunks) {
+  const char* text = "# voltage\n(0.001) RX0 7ef [2] 00 08\n\ngarbage\n(0.002) RX0 7ef [1] 81";
+  CanLogLineParser parser;
+  std::vector<CAN_log_record> records;
+  auto collect = [&](const CAN_log_record& record) { records.push_back(record); };
+
+  for (size_t i = 0; i < strlen(text); i += 5) {
+    parser.feed((const uint8_t*)text + i, std::min<size_t>(5, strlen(text) - i), collect);
+  }
+  EXPECT_EQ(records.size(), 1);
+  parser.finish(collect);
+
+  ASSERT_EQ(records.size(), 2);
+  EXPECT_EQ(records[0].data[1], 0x08);
+  EXPECT_EQ(records[1].timestamp_us, 2000);
+  EXPECT_EQ(records[1].data[0], 0x81);
+  EXPECT_EQ(parser.lines_skipped(), 1);
+}
+
+TEST(CanLogFormatTests, ShouldEncodeParsedRecordsCompactly) {
+  const char* line = "(0.5) TX1 123 [2] AA BB";
+  CAN_log_record record;
+  ASSERT_TRUE(parse_can_log_line(line, strlen(line), record));
+
+  uint8_t buffer[CAN_LOG_RECORD_MAX_SIZE];
+  const size_t size = encode_can_log_record(record, buffer);
+  EXPECT_EQ(size, CAN_LOG_HEADER_SIZE + 8);
+
+  CAN_log_record decoded;
+  ASSERT_EQ(decode_can_log_record(buffer, size, decoded), size);
+  EXPECT_EQ(decoded.timestamp_us, 500000);
+  EXPECT_EQ(decoded.flags, CAN_LOG_FLAG_TX);
+  EXPECT_EQ(decoded.interface, 1);
+  EXPECT_EQ(decoded.data[1], 0xBB);
+}
+
+TEST(CanLogFormatTests, ShouldDecodeRecordsSplitAcrossBlocks) {
+  std::vector<uint8_t> log(CAN_LOG_MAGIC, CAN_LOG_MAGIC + sizeof(CAN_LOG_MAGIC));
+  for (int i = 0; i < 20; i++) {
+    CAN_frame frame = {.FD = (i % 3 == 0), .ext_ID = false, .DLC = (uint8_t)((i % 3 == 0) ? 64 : 8),
+                       .ID = (uint32_t)i, .data = {(uint8_t)i}};
+    uint8_t record[CAN_LOG_RECORD_MAX_SIZE];
+    const size_t size = encode_can_log_record(frame, MSG_RX, CAN_NATIVE, 1000 * i, record);
+    log.insert(log.end(), record, record + size);
+  }
+
+  for (size_t block_size : {1, 5, 17, 100, 4096}) {
+    CanLogBlockDecoder decoder;
+    std::vector<CAN_log_record> records;
+    for (size_t pos = 0; pos < log.size(); pos += block_size) {
+      decoder.set_block(log.data() + pos, std::min(block_size, log.size() - pos));
+      CAN_log_record record;
+      while (decoder.next(record)) {
+        records.push_back(record);
+      }
+    }
+    ASSERT_EQ(records.size(), 20) << block_size;
+    for (int i = 0; i < 20; i++) {
+      EXPECT_EQ(records[i].ID, i);
+      EXPECT_EQ(records[i].timestamp_us, 1000 * i);
+      EXPECT_EQ(records[i].data[0], i);
+    }
+    EXPECT_FALSE(decoder.bad_magic());
+  }
+}
+
+TEST(CanLogFormatTests, ShouldRefuseBlocksWithoutTheMagic) {
+  const uint8_t text[] = "(0.001) RX0 7ef [2] 00 08\n";
+  CanLogBlockDecoder decoder;
+  CAN_log_record record;
+
+  decoder.set_block(text, sizeof(text));
+  EXPECT_FALSE(decoder.next(record));
+  EXPECT_TRUE(decoder.bad_magic());
+}
+
+TEST(CanLogFormatTests, ShouldTurnRecordsBackIntoFrames) {
+  const char* line = "(2.0) RX2 18DAF1DB [12] 01 02 03";
+  CAN_log_record record;
+  ASSERT_TRUE(parse_can_log_line(line, strlen(line), record));
+
+  CAN_frame frame = {};
+  can_log_record_to_frame(record, frame);
+  EXPECT_TRUE(frame.FD);
+  EXPECT_TRUE(frame.ext_ID);
+  EXPECT_EQ(frame.ID, 0x18DAF1DB);
+  EXPECT_EQ(frame.DLC, 12);
+  EXPECT_EQ(frame.data.u8[2], 3);
+
+  // Standard IDs stay standard whatever their value, unlike the old replay which guessed from ID > 0x7F0
+  const char* standard = "(2.0) RX0 7FF [8] 00";
+  ASSERT_TRUE(parse_can_log_line(standard, strlen(standard), record));
+  can_log_record_to_frame(record, frame);
+  EXPECT_FALSE(frame.ext_ID);
+  EXPECT_FALSE(frame.FD);
+}
+
+TEST(CanLogFormatTests, ShouldNumberBusesLikeTheTextLogs) {
+  CAN_frame frame = {.FD = false, .ext_ID = false, .DLC = 1, .ID = 0x100, .data = {0}};
+  uint8_t buffer[CAN_LOG_RECORD_MAX_SIZE];
+  CAN_log_record record;
+
+  decode_can_log_record(buffer, encode_can_log_record(frame, MSG_RX, CAN_ADDON_MCP2515, 0, buffer), record);
+  EXPECT_EQ(can_log_bus_number(record), 4);
+  decode_can_log_record(buffer, encode_can_log_record(frame, MSG_TX, CANFD_NATIVE, 0, buffer), record);
+  EXPECT_EQ(can_log_bus_number(record), 3);
+}
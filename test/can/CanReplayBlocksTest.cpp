@@ -0,0 +1,61 @@
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "../../Software/src/communication/can/CanReplayBlocks.h"
+#include "../../Software/src/devboard/sdcard/can_log_format.h"
+
+static std::vector<uint8_t> small_log() {
+  std::vector<uint8_t> log(CAN_LOG_MAGIC, CAN_LOG_MAGIC + sizeof(CAN_LOG_MAGIC));
+  for (uint32_t i = 0; i < 3; i++) {
+    CAN_frame frame = {.FD = false, .ext_ID = false, .DLC = 1, .ID = 0x100 + i, .data = {(uint8_t)i}};
+    uint8_t record[CAN_LOG_RECORD_MAX_SIZE];
+    const size_t size = encode_can_log_record(frame, MSG_RX, CAN_NATIVE, 1000 * i, record);
+    log.insert(log.end(), record, record + size);
+  }
+  return log;
+}
+
+TEST(CanReplayBlocksTests, ShouldNeverHandTheReaderABlockThatIsBeingDecoded) {
+  const std::vector<uint8_t> log = small_log();
+  uint8_t first[256];
+  uint8_t second[256];
+  CanReplayBlocks blocks(first, second, sizeof(first));
+  ASSERT_TRUE(blocks.valid());
+
+  // A looped replay of a log that fits in one block, the reader and the replay taking turns as they would
+  for (int pass = 0; pass < 3; pass++) {
+    size_t pos = 0;
+    auto read = [&](uint8_t* data, size_t size) {
+      const size_t len = std::min(size, log.size() - pos);
+      memcpy(data, log.data() + pos, len);
+      pos += len;
+      return len;
+    };
+    blocks.reset();
+
+    EXPECT_TRUE(blocks.fill(read, 0));
+    CanReplayBlocks::Block* decoding = blocks.take(0);
+    ASSERT_NE(decoding, nullptr) << pass;
+    ASSERT_EQ(decoding->len, log.size());
+
+    // While the replay decodes the log the reader ends the pass, in the other block
+    EXPECT_FALSE(blocks.fill(read, 0));
+    CanReplayBlocks::Block* end = blocks.take(0);
+    ASSERT_NE(end, nullptr) << pass;
+    EXPECT_NE(end, decoding) << pass;
+    EXPECT_EQ(end->len, 0u);
+
+    CanLogBlockDecoder decoder;
+    decoder.set_block(decoding->data, decoding->len);
+    CAN_log_record record;
+    for (uint32_t i = 0; i < 3; i++) {
+      ASSERT_TRUE(decoder.next(record)) << pass;
+      EXPECT_EQ(record.ID, 0x100 + i);
+    }
+    EXPECT_FALSE(decoder.next(record));
+
+    // Like SdReplaySource::next(), the decoded block goes back and the empty one is dropped
+    blocks.give_back(decoding);
+  }
+}
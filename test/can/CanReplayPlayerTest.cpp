@@ -0,0 +1,189 @@
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <vector>
+
+#include "../../Software/src/communication/can/CanDispatcher.h"
+#include "../../Software/src/communication/can/CanReplayPlayer.h"
+
+namespace {
+
+class RecordingReceiver : public CanReceiver {
+ public:
+  void receive_can_frame(const CAN_frame& rx_frame) override { frames.push_back(rx_frame); }
+  std::vector<CAN_frame> frames;
+};
+
+CAN_replay_options receivers_options() {
+  CAN_replay_options options = {};
+  options.source = REPLAY_FROM_UPLOAD;
+  options.speed_percent = 100;
+  options.target = REPLAY_TO_RECEIVERS;
+  return options;
+}
+
+std::vector<CAN_log_record> parse_log(const char* log) {
+  std::vector<CAN_log_record> records;
+  CanLogLineParser parser;
+  auto add = [&records](const CAN_log_record& record) { records.push_back(record); };
+  parser.feed(reinterpret_cast<const uint8_t*>(log), strlen(log), add);
+  parser.finish(add);
+  return records;
+}
+
+// Replays the records into one dispatcher per interface, with a clock that jumps to each deadline
+int64_t replay(CanReplayPlayer& player, const std::vector<CAN_log_record>& records, CanDispatcher* dispatchers) {
+  int64_t now_us = 0;
+  player.start_pass(now_us, records.front().timestamp_us);
+  for (auto& record : records) {
+    CAN_frame frame;
+    CAN_Interface interface;
+    int64_t deadline_us;
+    if (!player.route(record, frame, interface, deadline_us)) {
+      continue;
+    }
+    now_us = std::max(now_us, deadline_us);
+    frame.timestamp_us = now_us;
+    dispatchers[interface].dispatch(frame);
+    player.done(deadline_us, now_us, 500);
+  }
+  return now_us;
+}
+
+}  // namespace
+
+TEST(CanReplayPlayerTests, ShouldFeedTheReceiversInLogOrder) {
+  const auto records = parse_log(
+      "(100.000000) RX0 1DB [3] 01 02 03\n"
+      "(100.010000) RX0 1DC [1] 04\n"
+      "(100.020000) RX0 18FF50E5 [8] 00 11 22 33 44 55 66 77\n");
+  ASSERT_EQ(records.size(), 3u);
+
+  CanDispatcher dispatchers[CANFD_ADDON_MCP2518 + 1];
+  RecordingReceiver receiver;
+  dispatchers[CAN_NATIVE].add_receiver(&receiver, {});
+
+  CAN_replay_options options = receivers_options();
+  CAN_replay_timing timing;
+  replay_timing_reset(timing);
+  CanReplayPlayer player(options, CAN_NATIVE, timing);
+  EXPECT_EQ(replay(player, records, dispatchers), 20000);
+
+  ASSERT_EQ(receiver.frames.size(), 3u);
+  EXPECT_EQ(receiver.frames[0].ID, 0x1DB);
+  EXPECT_EQ(receiver.frames[0].data.u8[2], 0x03);
+  EXPECT_EQ(receiver.frames[0].timestamp_us, 0);
+  EXPECT_EQ(receiver.frames[1].ID, 0x1DC);
+  EXPECT_EQ(receiver.frames[1].timestamp_us, 10000);
+  EXPECT_EQ(receiver.frames[2].ID, 0x18FF50E5u);
+  EXPECT_TRUE(receiver.frames[2].ext_ID);
+  EXPECT_EQ(timing.frames, 3);
+  EXPECT_EQ(timing.late, 0);
+}
+
+TEST(CanReplayPlayerTests, ShouldRouteEachBusToItsMappedInterface) {
+  const auto records = parse_log(
+      "(1.000000) RX0 100 [1] 01\n"
+      "(1.001000) TX1 101 [1] 02\n"
+      "(1.002000) RX2 102 [1] 03\n"
+      "(1.003000) RX6 103 [1] 04\n");
+  ASSERT_EQ(records.size(), 4u);
+
+  CanDispatcher dispatchers[CANFD_ADDON_MCP2518 + 1];
+  RecordingReceiver native, addon;
+  dispatchers[CAN_NATIVE].add_receiver(&native, {});
+  dispatchers[CAN_ADDON_MCP2515].add_receiver(&addon, {});
+
+  CAN_replay_options options = receivers_options();
+  options.map_buses = true;
+  memset(options.bus_map, CAN_REPLAY_BUS_OFF, sizeof(options.bus_map));
+  options.bus_map[0] = CAN_NATIVE;
+  options.bus_map[2] = CAN_ADDON_MCP2515;
+  CAN_replay_timing timing;
+  replay_timing_reset(timing);
+  CanReplayPlayer player(options, CAN_NATIVE, timing);
+  // The skipped TX1 and RX6 frames still keep the schedule of the log
+  EXPECT_EQ(replay(player, records, dispatchers), 2000);
+
+  ASSERT_EQ(native.frames.size(), 1u);
+  EXPECT_EQ(native.frames[0].ID, 0x100);
+  ASSERT_EQ(addon.frames.size(), 1u);
+  EXPECT_EQ(addon.frames[0].ID, 0x102);
+  EXPECT_EQ(timing.frames, 2);
+}
+
+TEST(CanReplayPlayerTests, ShouldOnlyDeliverTheIdsAReceiverWants) {
+  const auto records = parse_log(
+      "(0.000000) RX0 1DB [8] 00 00 00 00 00 00 00 00\n"
+      "(0.000100) RX0 5BC [8] 00 00 00 00 00 00 00 00\n"
+      "(0.000200) RX0 1DB [8] 00 00 00 00 00 00 00 01\n");
+
+  CanDispatcher dispatchers[CANFD_ADDON_MCP2518 + 1];
+  RecordingReceiver receiver;
+  dispatchers[CAN_NATIVE].add_receiver(&receiver, {{0x1DB, 0x1DB, false}});
+
+  CAN_replay_options options = receivers_options();
+  CAN_replay_timing timing;
+  replay_timing_reset(timing);
+  CanReplayPlayer player(options, CAN_NATIVE, timing);
+  replay(player, records, dispatchers);
+
+  ASSERT_EQ(receiver.frames.size(), 2u);
+  EXPECT_EQ(receiver.frames[1].data.u8[7], 0x01);
+}
+
+TEST(CanReplayPlayerTests, ShouldReplayAnHourOfLogWithoutWaitingForIt) {
+  std::vector<CAN_log_record> records;
+  for (int64_t log_us = 0; log_us <= 3600000000; log_us += 100000) {
+    CAN_log_record record = {};
+    record.timestamp_us = log_us;
+    record.ID = 0x1DB;
+    record.DLC = 8;
+    records.push_back(record);
+  }
+
+  CanDispatcher dispatchers[CANFD_ADDON_MCP2518 + 1];
+  RecordingReceiver receiver;
+  dispatchers[CAN_NATIVE].add_receiver(&receiver, {});
+
+  CAN_replay_options options = receivers_options();
+  CAN_replay_timing timing;
+  replay_timing_reset(timing);
+  CanReplayPlayer player(options, CAN_NATIVE, timing);
+  EXPECT_EQ(replay(player, records, dispatchers), 3600000000);
+
+  EXPECT_EQ(receiver.frames.size(), 36001u);
+  EXPECT_EQ(timing.max_error_us, 0);
+}
+
+TEST(CanReplayPlayerTests, ShouldSkipBusesMappedToNoInterface) {
+  const auto records = parse_log(
+      "(1.000000) RX0 100 [1] 01\n"
+      "(1.001000) RX2 102 [1] 03\n");
+
+  CanDispatcher dispatchers[CANFD_ADDON_MCP2518 + 1];
+  RecordingReceiver native;
+  dispatchers[CAN_NATIVE].add_receiver(&native, {});
+
+  CAN_replay_options options = receivers_options();
+  options.map_buses = true;
+  memset(options.bus_map, CAN_REPLAY_BUS_OFF, sizeof(options.bus_map));
+  options.bus_map[0] = CAN_NATIVE;
+  options.bus_map[2] = 7;
+  CAN_replay_timing timing;
+  replay_timing_reset(timing);
+  CanReplayPlayer player(options, CAN_NATIVE, timing);
+  replay(player, records, dispatchers);
+
+  ASSERT_EQ(native.frames.size(), 1u);
+  EXPECT_EQ(timing.frames, 1);
+
+  // Nor is an invalid default interface used
+  const CAN_replay_options defaults = receivers_options();
+  CanReplayPlayer unmapped(defaults, (CAN_Interface)9, timing);
+  CAN_frame frame;
+  CAN_Interface interface;
+  int64_t deadline_us;
+  unmapped.start_pass(0, records.front().timestamp_us);
+  EXPECT_FALSE(unmapped.route(records.front(), frame, interface, deadline_us));
+}
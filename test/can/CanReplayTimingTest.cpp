@@ -0,0 +1,87 @@
+#include <gtest/gtest.h>
+
+#include "../../Software/src/communication/can/CanReplayTiming.h"
+
+TEST(CanReplayTimingTests, ShouldScheduleFramesAgainstThePassStart) {
+  CAN_replay_timing timing;
+  replay_timing_reset(timing);
+  // The MG HS log starts at 84215.921 s, far beyond what float timestamps could resolve to the microsecond
+  replay_timing_start_pass(timing, 5000000, 84215921000, 100);
+
+  EXPECT_EQ(replay_timing_next_deadline_us(timing, 84215921000), 5000000);
+  EXPECT_EQ(replay_timing_next_deadline_us(timing, 84215922001), 5001001);
+  EXPECT_EQ(replay_timing_next_deadline_us(timing, 84216921000), 6000000);
+}
+
+TEST(CanReplayTimingTests, ShouldScaleGapsWithTheSpeed) {
+  CAN_replay_timing timing;
+  replay_timing_reset(timing);
+  replay_timing_start_pass(timing, 1000, 0, 250);
+
+  EXPECT_EQ(replay_timing_next_deadline_us(timing, 0), 1000);
+  EXPECT_EQ(replay_timing_next_deadline_us(timing, 10000), 5000);
+
+  replay_timing_start_pass(timing, 1000, 0, 50);
+  EXPECT_EQ(replay_timing_next_deadline_us(timing, 10000), 21000);
+}
+
+TEST(CanReplayTimingTests, ShouldContinueWhereTheLogClockRestarted) {
+  CAN_replay_timing timing;
+  replay_timing_reset(timing);
+  replay_timing_start_pass(timing, 0, 3600000000, 100);
+
+  EXPECT_EQ(replay_timing_next_deadline_us(timing, 3600500000), 500000);
+  // The logging board rebooted, its clock starts over
+  EXPECT_EQ(replay_timing_next_deadline_us(timing, 2000000), 500000);
+  EXPECT_EQ(replay_timing_next_deadline_us(timing, 2010000), 510000);
+}
+
+TEST(CanReplayTimingTests, ShouldKeepTheScheduleForFramesSlightlyOutOfOrder) {
+  CAN_replay_timing timing;
+  replay_timing_reset(timing);
+  replay_timing_start_pass(timing, 0, 0, 100);
+
+  // A 10 ms TX cycle, each TX frame followed by an RX frame logged 100 us before it
+  for (int64_t log_us = 0; log_us < 10000000; log_us += 10000) {
+    EXPECT_EQ(replay_timing_next_deadline_us(timing, log_us), log_us);
+    EXPECT_EQ(replay_timing_next_deadline_us(timing, log_us - 100), log_us - 100);
+  }
+  EXPECT_EQ(replay_timing_next_deadline_us(timing, 10000000), 10000000);
+}
+
+TEST(CanReplayTimingTests, ShouldNotAccumulateWaitingErrors) {
+  CAN_replay_timing timing;
+  replay_timing_reset(timing);
+  replay_timing_start_pass(timing, 0, 0, 100);
+
+  // Every frame sent 300 us late, the next deadline still follows the log and not the late frame
+  int64_t sent_us = 0;
+  for (int64_t log_us = 0; log_us < 10000; log_us += 1000) {
+    const int64_t deadline_us = replay_timing_next_deadline_us(timing, log_us);
+    EXPECT_EQ(deadline_us, log_us);
+    sent_us = deadline_us + 300;
+    replay_timing_record(timing, deadline_us, sent_us, 500);
+  }
+
+  EXPECT_EQ(timing.frames, 10);
+  EXPECT_EQ(replay_timing_mean_error_us(timing), 300);
+  EXPECT_EQ(timing.max_error_us, 300);
+  EXPECT_EQ(timing.late, 0);
+  EXPECT_EQ(timing.histogram[2], 10);  // <= 500 us
+}
+
+TEST(CanReplayTimingTests, ShouldCountLateFramesAndIgnoreEarlyOnes) {
+  CAN_replay_timing timing;
+  replay_timing_reset(timing);
+
+  replay_timing_record(timing, 1000, 900, 500);   // Early counts as on time
+  replay_timing_record(timing, 2000, 2600, 500);  // Late
+  replay_timing_record(timing, 3000, 9000, 500);  // Very late
+
+  EXPECT_EQ(timing.frames, 3);
+  EXPECT_EQ(timing.late, 2);
+  EXPECT_EQ(timing.max_error_us, 6000);
+  EXPECT_EQ(timing.histogram[0], 1);
+  EXPECT_EQ(timing.histogram[CAN_TX_JITTER_BUCKETS - 1], 1);
+  EXPECT_EQ(replay_timing_mean_error_us(timing), 2200);
+}
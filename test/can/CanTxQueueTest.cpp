@@ -0,0 +1,93 @@
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "../../Software/src/communication/can/CanTxQueue.h"
+
+static CAN_frame frame_with_id(uint32_t id, uint8_t content = 0, bool ext_ID = false) {
+  CAN_frame frame = {.ext_ID = ext_ID, .DLC = 8, .ID = id};
+  frame.data.u8[0] = content;
+  return frame;
+}
+
+static std::vector<uint32_t> queued_ids(const CanTxQueue& queue) {
+  std::vector<uint32_t> ids;
+  for (const CAN_frame& frame : queue.front(CAN_TX_QUEUE_SIZE)) {
+    ids.push_back(frame.ID);
+  }
+  return ids;
+}
+
+TEST(CanTxQueueTests, ShouldReturnFramesInArbitrationOrder) {
+  CAN_tx_queue_stats stats = {};
+  CanTxQueue queue(stats);
+
+  queue.push(frame_with_id(0x5BC), false);
+  queue.push(frame_with_id(0x1DB), false);
+  queue.push(frame_with_id(0x55B), false);
+  queue.push(frame_with_id(0x1F2), false);
+
+  EXPECT_EQ(queued_ids(queue), (std::vector<uint32_t>{0x1DB, 0x1F2, 0x55B, 0x5BC}));
+  EXPECT_EQ(queue.front(2).size(), 2);
+
+  queue.pop(2);
+  EXPECT_EQ(queued_ids(queue), (std::vector<uint32_t>{0x55B, 0x5BC}));
+  EXPECT_EQ(stats.depth, 2);
+  EXPECT_EQ(stats.depth_max, 4);
+}
+
+TEST(CanTxQueueTests, ShouldOrderStandardBeforeExtendedFramesWithTheSameBaseId) {
+  EXPECT_LT(CanTxQueue::arbitration_key(frame_with_id(0x100)),
+            CanTxQueue::arbitration_key(frame_with_id(0x100 << 18, 0, true)));
+  EXPECT_LT(CanTxQueue::arbitration_key(frame_with_id(0x0FF << 18 | 0x3FFFF, 0, true)),
+            CanTxQueue::arbitration_key(frame_with_id(0x100)));
+}
+
+TEST(CanTxQueueTests, ShouldReplaceStaleFrameWithNewerOneWithTheSameId) {
+  CAN_tx_queue_stats stats = {};
+  CanTxQueue queue(stats);
+
+  queue.push(frame_with_id(0x1F2, 1), true);
+  queue.push(frame_with_id(0x1DB, 1), true);
+  queue.push(frame_with_id(0x1F2, 2), true);
+
+  ASSERT_EQ(queue.size(), 2);
+  EXPECT_EQ(queue.front(2)[1].ID, 0x1F2);
+  EXPECT_EQ(queue.front(2)[1].data.u8[0], 2);
+  EXPECT_EQ(stats.coalesced, 1);
+}
+
+TEST(CanTxQueueTests, ShouldKeepEveryFrameOfAMultiFrameSequenceInOrder) {
+  CAN_tx_queue_stats stats = {};
+  CanTxQueue queue(stats);
+
+  // A cyclic message is queued, then the parts of a transfer that share an ID, like ISO-TP consecutive frames
+  queue.push(frame_with_id(0x7E0, 0x10), true);
+  queue.push(frame_with_id(0x7E0, 0x21), false);
+  queue.push(frame_with_id(0x7E0, 0x22), false);
+  queue.push(frame_with_id(0x7E0, 0x23), true);  // Only replaces the cyclic copy
+
+  ASSERT_EQ(queue.size(), 3);
+  EXPECT_EQ(queue.front(3)[0].data.u8[0], 0x23);
+  EXPECT_EQ(queue.front(3)[1].data.u8[0], 0x21);
+  EXPECT_EQ(queue.front(3)[2].data.u8[0], 0x22);
+  EXPECT_TRUE(queue.cyclic(0));
+  EXPECT_FALSE(queue.cyclic(1));
+  EXPECT_EQ(stats.coalesced, 1);
+}
+
+TEST(CanTxQueueTests, ShouldDropLowestPriorityFrameWhenFull) {
+  CAN_tx_queue_stats stats = {};
+  CanTxQueue queue(stats);
+
+  for (uint32_t id = 0x200; id < 0x200 + CAN_TX_QUEUE_SIZE; id++) {
+    queue.push(frame_with_id(id), false);
+  }
+  queue.push(frame_with_id(0x7FF), false);  // Lower priority than everything queued, dropped itself
+  queue.push(frame_with_id(0x100), false);  // Pushes out the last queued frame
+
+  EXPECT_EQ(queue.size(), CAN_TX_QUEUE_SIZE);
+  EXPECT_EQ(queue.front(1)[0].ID, 0x100);
+  EXPECT_EQ(queued_ids(queue).back(), 0x200 + CAN_TX_QUEUE_SIZE - 2);
+  EXPECT_EQ(stats.dropped, 2);
+}
@@ -0,0 +1,65 @@
+#include <gtest/gtest.h>
+
+#include "../../Software/src/communication/can/CanTxTiming.h"
+
+static CAN_tx_timing monitored_10ms() {
+  CAN_tx_timing timing;
+  tx_timing_init(timing, 0x1F2, CAN_NATIVE, 10);
+  return timing;
+}
+
+TEST(CanTxTimingTests, ShouldNotCountAnIntervalForTheFirstTransmission) {
+  CAN_tx_timing timing = monitored_10ms();
+
+  tx_timing_record(timing, 1000000, 1000);
+
+  EXPECT_EQ(timing.intervals, 0);
+  EXPECT_EQ(tx_timing_mean_us(timing), 0);
+}
+
+TEST(CanTxTimingTests, ShouldTrackMinMaxMeanAndJitterHistogram) {
+  CAN_tx_timing timing = monitored_10ms();
+
+  tx_timing_record(timing, 1000000, 1000);
+  tx_timing_record(timing, 1010000, 1000);  // On time
+  tx_timing_record(timing, 1019800, 1000);  // 200 us early
+  tx_timing_record(timing, 1030600, 1000);  // 800 us late, within tolerance
+
+  EXPECT_EQ(timing.intervals, 3);
+  EXPECT_EQ(timing.min_us, 9800);
+  EXPECT_EQ(timing.max_us, 10800);
+  EXPECT_EQ(tx_timing_mean_us(timing), 10200);
+  EXPECT_EQ(timing.histogram[0], 1);  // <= 100 us
+  EXPECT_EQ(timing.histogram[1], 1);  // <= 250 us
+  EXPECT_EQ(timing.histogram[3], 1);  // <= 1000 us
+  EXPECT_EQ(timing.late, 0);
+  EXPECT_EQ(timing.missed, 0);
+}
+
+TEST(CanTxTimingTests, ShouldTellLateFromMissedSlots) {
+  CAN_tx_timing timing = monitored_10ms();
+
+  tx_timing_record(timing, 1000000, 1000);
+  tx_timing_record(timing, 1012000, 1000);  // 2 ms late
+  tx_timing_record(timing, 1042000, 1000);  // Two slots skipped
+
+  EXPECT_EQ(timing.late, 1);
+  EXPECT_EQ(timing.missed, 2);
+  EXPECT_EQ(timing.histogram[CAN_TX_JITTER_BUCKETS - 1], 1);
+}
+
+TEST(CanTxTimingTests, ResetShouldKeepWhatIsMonitored) {
+  CAN_tx_timing timing = monitored_10ms();
+  tx_timing_record(timing, 1000000, 1000);
+  tx_timing_record(timing, 1030000, 1000);
+
+  tx_timing_reset(timing);
+  tx_timing_record(timing, 2000000, 1000);
+  tx_timing_record(timing, 2010000, 1000);
+
+  EXPECT_EQ(timing.ID, 0x1F2);
+  EXPECT_EQ(timing.period_us, 10000);
+  EXPECT_EQ(timing.intervals, 1);
+  EXPECT_EQ(timing.missed, 0);
+  EXPECT_EQ(timing.min_us, 10000);
+}
@@ -0,0 +1,96 @@
+#include <gtest/gtest.h>
+
+#include <map>
+
+#include "../../Software/src/communication/CyclicScheduler.h"
+
+TEST(CyclicSchedulerTests, ShouldRunTasksOnTheirPeriodAndPhase) {
+  CyclicScheduler scheduler;
+  std::vector<unsigned long> runs;
+  scheduler.add(10, [&](unsigned long now) { runs.push_back(now); }, 0, 3);
+
+  for (unsigned long now = 0; now < 40; now++) {
+    scheduler.run(now);
+  }
+
+  EXPECT_EQ(runs, (std::vector<unsigned long>{3, 13, 23, 33}));
+}
+
+TEST(CyclicSchedulerTests, ShouldOnlyRunWhatIsDue) {
+  CyclicScheduler scheduler;
+  int fast = 0;
+  int slow = 0;
+  scheduler.add(10, [&](unsigned long) { fast++; }, 0, 0);
+  scheduler.add(100, [&](unsigned long) { slow++; }, 0, 0);
+
+  EXPECT_EQ(scheduler.run(0), 2);
+  EXPECT_EQ(scheduler.run(1), 0);
+  EXPECT_EQ(scheduler.run(10), 1);
+  EXPECT_EQ(fast, 2);
+  EXPECT_EQ(slow, 1);
+}
+
+TEST(CyclicSchedulerTests, ShouldSkipMissedRunsButKeepThePhase) {
+  CyclicScheduler scheduler;
+  std::vector<unsigned long> runs;
+  scheduler.add(10, [&](unsigned long now) { runs.push_back(now); }, 0, 5);
+
+  scheduler.run(5);
+  scheduler.run(47);  // Late, 15, 25, 35 and 45 were missed
+  scheduler.run(55);
+
+  EXPECT_EQ(runs, (std::vector<unsigned long>{5, 47, 55}));
+}
+
+TEST(CyclicSchedulerTests, ShouldSpreadPhasesSoBurstsDoNotCollide) {
+  CyclicScheduler scheduler;
+  std::map<unsigned long, int> runs_per_ms;
+  auto count = [&](unsigned long now) { runs_per_ms[now]++; };
+
+  scheduler.add(10, count, 0);
+  scheduler.add(100, count, 0);
+  scheduler.add(30, count, 0);
+  scheduler.add(200, count, 0);
+
+  for (unsigned long now = 0; now < 6000; now++) {
+    scheduler.run(now);
+  }
+
+  for (auto& [ms, runs] : runs_per_ms) {
+    EXPECT_EQ(runs, 1) << "Several tasks ran at " << ms << " ms";
+  }
+}
+
+TEST(CyclicSchedulerTests, ShouldHandleMillisWrapAround) {
+  CyclicScheduler scheduler;
+  int runs = 0;
+  const unsigned long start = ~0UL - 25;
+  scheduler.add(10, [&](unsigned long) { runs++; }, start, CyclicScheduler::AUTO_PHASE);
+
+  for (unsigned long i = 0; i < 100; i++) {
+    scheduler.run(start + i);
+  }
+
+  EXPECT_EQ(runs, 10);
+}
+
+TEST(CyclicSchedulerTests, CallbacksMayRegisterNewTasks) {
+  CyclicScheduler scheduler;
+  int added_runs = 0;
+  bool added = false;
+  scheduler.add(
+      10,
+      [&](unsigned long now) {
+        if (!added) {
+          added = true;
+          scheduler.add(10, [&](unsigned long) { added_runs++; }, now);
+        }
+      },
+      0, 0);
+
+  for (unsigned long now = 0; now < 100; now++) {
+    scheduler.run(now);
+  }
+
+  EXPECT_GE(added_runs, 9);
+}
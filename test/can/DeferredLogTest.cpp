@@ -0,0 +1,86 @@
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <string>
+
+#include "../../Software/src/devboard/utils/deferred_log.h"
+
+template <typename... Args>
+static std::string format_deferred(const char* fmt, Args... args) {
+  DeferredLogRecord record(1234, fmt);
+  (record.add(args), ...);
+  char out[256];
+  size_t len = format_deferred_log(record.bytes(), record.size(), out, sizeof(out));
+  EXPECT_EQ(len, strlen(out));
+  return std::string(out, len);
+}
+
+template <typename... Args>
+static std::string format_now(const char* fmt, Args... args) {
+  char out[256];
+  snprintf(out, sizeof(out), fmt, args...);
+  return out;
+}
+
+TEST(DeferredLogTest, MatchesPrintf) {
+  const char* name = "Leaf";
+  uint16_t setpoint = 390;
+  int8_t negative = -5;
+  float current = 12.25f;
+  unsigned long ms = 4000000000UL;
+  uint64_t big = 0x123456789ULL;
+
+  EXPECT_EQ(format_deferred("no arguments\n"), "no arguments\n");
+  EXPECT_EQ(format_deferred("%s %u %d\n", name, setpoint, negative), format_now("%s %u %d\n", name, setpoint, negative));
+  EXPECT_EQ(format_deferred("IDC=%fA VDC=%.1fV\n", current, 399.95), format_now("IDC=%fA VDC=%.1fV\n", current, 399.95));
+  EXPECT_EQ(format_deferred("%lu ms %llx %c%%\n", ms, big, 'x'), format_now("%lu ms %llx %c%%\n", ms, big, 'x'));
+  EXPECT_EQ(format_deferred("[%-6s|%04X|%*d]", "ab", 0xbeef, 5, 42), format_now("[%-6s|%04X|%*d]", "ab", 0xbeef, 5, 42));
+  EXPECT_EQ(format_deferred("%d", true), "1");
+}
+
+TEST(DeferredLogTest, StringsAreCopied) {
+  char buffer[16];
+  strcpy(buffer, "before");
+  DeferredLogRecord record(0, "ssid=%s\n");
+  record.add(buffer);
+  strcpy(buffer, "after");
+
+  char out[64];
+  format_deferred_log(record.bytes(), record.size(), out, sizeof(out));
+  EXPECT_STREQ(out, "ssid=before\n");
+
+  EXPECT_EQ(format_deferred("%s", (const char*)nullptr), "(null)");
+  std::string long_string(100, 'a');
+  EXPECT_EQ(format_deferred("%s", long_string.c_str()), std::string(DEFERRED_LOG_MAX_STRING, 'a'));
+}
+
+TEST(DeferredLogTest, ArgumentsThatDontFitAreShownAsConversions) {
+  std::string long_string(DEFERRED_LOG_MAX_STRING, 'b');
+  DeferredLogRecord record(0, "%s %s %s %d\n");
+  record.add(long_string.c_str());
+  record.add(long_string.c_str());
+  record.add(long_string.c_str());
+  record.add(7);
+
+  char out[256];
+  format_deferred_log(record.bytes(), record.size(), out, sizeof(out));
+  EXPECT_EQ(std::string(out), long_string + " " + long_string + " %s %d\n");
+  EXPECT_LE(record.size(), (size_t)DEFERRED_LOG_MAX_RECORD);
+}
+
+TEST(DeferredLogTest, OutputIsTruncated) {
+  char out[8];
+  DeferredLogRecord plain(0, "0123456789");
+  EXPECT_EQ(format_deferred_log(plain.bytes(), plain.size(), out, sizeof(out)), 7u);
+  EXPECT_STREQ(out, "0123456");
+
+  DeferredLogRecord record(42, "0123%d6789");
+  record.add(45);
+  EXPECT_EQ(format_deferred_log(record.bytes(), record.size(), out, sizeof(out)), 7u);
+  EXPECT_STREQ(out, "0123456");
+
+  uint32_t time_ms;
+  ASSERT_TRUE(deferred_log_time(record.bytes(), record.size(), time_ms));
+  EXPECT_EQ(time_ms, 42u);
+  EXPECT_FALSE(deferred_log_time(record.bytes(), 3, time_ms));
+}
@@ -0,0 +1,78 @@
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "../../Software/src/communication/can/gvret.h"
+
+static std::vector<uint8_t> encode(const CAN_frame& frame, CAN_Interface interface, int64_t time_us) {
+  uint8_t record_bytes[CAN_LOG_RECORD_MAX_SIZE];
+  CAN_log_record record;
+  decode_can_log_record(record_bytes, encode_can_log_record(frame, MSG_RX, interface, time_us, record_bytes), record);
+  uint8_t out[GVRET_FRAME_MAX_SIZE];
+  return std::vector<uint8_t>(out, out + gvret_encode_frame(record, out));
+}
+
+static std::vector<uint8_t> feed(GvretParser& parser, std::vector<uint8_t> bytes) {
+  Gvret_status status = {.speed_bps = {500000, 0, 250000, 0}, .time_us = 0x01020304};
+  std::vector<uint8_t> replies;
+  for (uint8_t byte : bytes) {
+    uint8_t reply[GVRET_REPLY_MAX_SIZE];
+    size_t size = parser.feed(byte, status, reply);
+    replies.insert(replies.end(), reply, reply + size);
+  }
+  return replies;
+}
+
+TEST(GvretTest, EncodesClassicFrames) {
+  CAN_frame frame = {.FD = false, .ext_ID = false, .DLC = 3, .ID = 0x1DB, .data = {0xAA, 0xBB, 0xCC}};
+  // The timestamp is truncated to 32 bits, the bus goes in the upper nibble of the DLC byte
+  EXPECT_EQ(encode(frame, CAN_ADDON_MCP2515, 0x100000005),
+            std::vector<uint8_t>(
+                {0xF1, 0x00, 0x05, 0x00, 0x00, 0x00, 0xDB, 0x01, 0x00, 0x00, 0x23, 0xAA, 0xBB, 0xCC, 0}));
+
+  frame.ext_ID = true;
+  frame.ID = 0x18DAF1DB;
+  auto extended = encode(frame, CAN_NATIVE, 0);
+  EXPECT_EQ(std::vector<uint8_t>(extended.begin() + 6, extended.begin() + 10),
+            std::vector<uint8_t>({0xDB, 0xF1, 0xDA, 0x98}));
+}
+
+TEST(GvretTest, EncodesFdFrames) {
+  CAN_frame frame = {.FD = true, .ext_ID = false, .DLC = 12, .ID = 0x123};
+  for (int i = 0; i < 12; i++) {
+    frame.data.u8[i] = i;
+  }
+  auto bytes = encode(frame, CANFD_NATIVE, 7);
+  ASSERT_EQ(bytes.size(), 2 + 4 + 4 + 2 + 12 + 1u);
+  EXPECT_EQ(bytes[1], 0x14);
+  EXPECT_EQ(bytes[10], 12);
+  EXPECT_EQ(bytes[11], CANFD_NATIVE);
+  EXPECT_EQ(bytes[12 + 11], 11);
+}
+
+TEST(GvretTest, AnswersTheConnectHandshake) {
+  GvretParser parser;
+  EXPECT_FALSE(parser.binary_mode());
+  EXPECT_TRUE(feed(parser, {0xE7, 0xE7}).empty());
+  EXPECT_TRUE(parser.binary_mode());
+
+  EXPECT_EQ(feed(parser, {0xF1, 0x0C}), std::vector<uint8_t>({0xF1, 0x0C, GVRET_NUM_BUSES}));
+  EXPECT_EQ(feed(parser, {0xF1, 0x09}), std::vector<uint8_t>({0xF1, 0x09, 0xDE, 0xAD}));
+  EXPECT_EQ(feed(parser, {0xF1, 0x01}), std::vector<uint8_t>({0xF1, 0x01, 0x04, 0x03, 0x02, 0x01}));
+  EXPECT_EQ(feed(parser, {0xF1, 0x06}),
+            std::vector<uint8_t>({0xF1, 0x06, 1, 0x20, 0xA1, 0x07, 0x00, 0, 0, 0, 0, 0}));
+  auto ext = feed(parser, {0xF1, 0x0D});
+  ASSERT_EQ(ext.size(), 2 + 15u);
+  EXPECT_EQ(ext[2], 1);
+  EXPECT_EQ(ext[3] | ext[4] << 8 | ext[5] << 16, 250000);
+  EXPECT_EQ(feed(parser, {0xF1, 0x07}).size(), 8u);
+}
+
+TEST(GvretTest, SkipsPayloadsOfHostCommands) {
+  GvretParser parser;
+  // A frame to send, its DLC decides the length, then bus setup with eight bytes of payload
+  std::vector<uint8_t> bytes = {0xF1, 0x00, 0xF1, 0x09, 0x00, 0x00, 0x00, 4, 0xF1, 0x09, 0xF1, 0x0C, 0};
+  bytes.insert(bytes.end(), {0xF1, 0x05, 0xF1, 0x09, 0xF1, 0x09, 0xF1, 0x09, 0xF1, 0x09});
+  EXPECT_TRUE(feed(parser, bytes).empty());
+  EXPECT_EQ(feed(parser, {0xF1, 0x09}), std::vector<uint8_t>({0xF1, 0x09, 0xDE, 0xAD}));
+}
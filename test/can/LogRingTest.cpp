@@ -0,0 +1,185 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../../Software/src/devboard/utils/log_ring.h"
+
+template <size_t Size>
+static std::vector<std::string> read_all(const LogRing<Size>& ring, uint32_t& cursor) {
+  std::vector<std::string> records;
+  char buffer[Size];
+  size_t len;
+  while ((len = ring.read(cursor, buffer, sizeof(buffer))) > 0) {
+    records.emplace_back(buffer, len);
+  }
+  return records;
+}
+
+template <size_t Size>
+static void write(LogRing<Size>& ring, const std::string& text) {
+  EXPECT_TRUE(ring.write(text.data(), text.size()));
+}
+
+TEST(LogRingTests, ShouldReturnRecordsInOrderFromTheCursor) {
+  LogRing<256> ring;
+  uint32_t cursor = ring.oldest();
+  EXPECT_TRUE(read_all(ring, cursor).empty());
+
+  write(ring, "first");
+  write(ring, "second line");
+  EXPECT_EQ(read_all(ring, cursor), (std::vector<std::string>{"first", "second line"}));
+
+  write(ring, "third");
+  EXPECT_EQ(read_all(ring, cursor), (std::vector<std::string>{"third"}));
+
+  uint32_t late = ring.newest();
+  write(ring, "fourth");
+  EXPECT_EQ(read_all(ring, late), (std::vector<std::string>{"fourth"}));
+}
+
+TEST(LogRingTests, ShouldDropOnlyTheOldestRecordsWhenFull) {
+  LogRing<256> ring;
+  for (int i = 0; i < 100; i++) {
+    write(ring, "record " + std::to_string(i));
+  }
+
+  uint32_t cursor = ring.oldest();
+  auto records = read_all(ring, cursor);
+  ASSERT_FALSE(records.empty());
+  EXPECT_GT(records.size(), 8);
+  for (size_t i = 0; i < records.size(); i++) {
+    EXPECT_EQ(records[i], "record " + std::to_string(100 - records.size() + i));
+  }
+}
+
+TEST(LogRingTests, ShouldSkipRecordsOverwrittenBeforeTheReaderGotThere) {
+  LogRing<256> ring;
+  uint32_t cursor = ring.oldest();
+  write(ring, "lost");
+  for (int i = 0; i < 50; i++) {
+    write(ring, std::string(20, 'a' + i % 26));
+  }
+
+  auto records = read_all(ring, cursor);
+  ASSERT_FALSE(records.empty());
+  EXPECT_EQ(records.back(), std::string(20, 'a' + 49 % 26));
+  for (auto& record : records) {
+    EXPECT_EQ(record.size(), 20);
+  }
+}
+
+TEST(LogRingTests, ShouldRejectRecordsThatCanNeverFit) {
+  LogRing<256> ring;
+  std::string big(LogRing<256>::MAX_RECORD + 1, 'x');
+  EXPECT_FALSE(ring.write(big.data(), big.size()));
+  EXPECT_TRUE(ring.write(big.data(), big.size() - 1));
+}
+
+TEST(LogRingTests, ShouldKeepRecordsWholeWithConcurrentProducers) {
+  LogRing<4096> ring;
+  constexpr int PRODUCERS = 4;
+  constexpr int RECORDS = 20000;
+  std::atomic<bool> done{false};
+
+  std::vector<std::thread> producers;
+  for (int p = 0; p < PRODUCERS; p++) {
+    producers.emplace_back([&ring, p]() {
+      for (int i = 0; i < RECORDS; i++) {
+        // Length and content both derived from the producer and sequence number, so a torn record shows
+        std::string text(1 + (i * 7 + p) % 90, 'A' + p);
+        text += ":" + std::to_string(i);
+        ring.write(text.data(), text.size());
+      }
+    });
+  }
+
+  size_t read = 0;
+  std::vector<int> last_seen(PRODUCERS, -1);
+  std::thread reader([&]() {
+    uint32_t cursor = ring.oldest();
+    char buffer[256];
+    while (true) {
+      const bool finished = done.load();
+      size_t len;
+      while ((len = ring.read(cursor, buffer, sizeof(buffer))) > 0) {
+        std::string text(buffer, len);
+        const size_t colon = text.find(':');
+        ASSERT_NE(colon, std::string::npos) << text;
+        const int p = text[0] - 'A';
+        ASSERT_TRUE(p >= 0 && p < PRODUCERS) << text;
+        const int i = std::stoi(text.substr(colon + 1));
+        EXPECT_EQ(text.substr(0, colon), std::string(1 + (i * 7 + p) % 90, 'A' + p));
+        // Each producer's records come out in order, some may have been overwritten
+        EXPECT_GT(i, last_seen[p]);
+        last_seen[p] = i;
+        read++;
+      }
+      if (finished) {
+        break;
+      }
+    }
+  });
+
+  for (auto& producer : producers) {
+    producer.join();
+  }
+  done = true;
+  reader.join();
+
+  // Producers finishing early may have had their last records overwritten, the last one to finish has not
+  EXPECT_GT(read, 0);
+  EXPECT_EQ(*std::max_element(last_seen.begin(), last_seen.end()), RECORDS - 1);
+}
+
+TEST(LogRingTests, ShouldNotSkipRecordsReservedButNotYetWrittenWhenReadingAtTheHead) {
+  // Large enough to never wrap, so every record has to come out
+  constexpr size_t SIZE = 1 << 21;
+  auto ring = std::make_unique<LogRing<SIZE>>();
+  constexpr int PRODUCERS = 4;
+  constexpr int RECORDS = 5000;
+  std::atomic<bool> done{false};
+
+  std::vector<std::thread> producers;
+  for (int p = 0; p < PRODUCERS; p++) {
+    producers.emplace_back([&ring, p]() {
+      for (int i = 0; i < RECORDS; i++) {
+        std::string text(1 + (i * 7 + p) % 60, 'A' + p);
+        text += ":" + std::to_string(i);
+        ring->write(text.data(), text.size());
+      }
+    });
+  }
+
+  std::vector<int> last_seen(PRODUCERS, -1);
+  std::thread reader([&]() {
+    uint32_t cursor = ring->oldest();
+    char buffer[128];
+    while (true) {
+      const bool finished = done.load();
+      size_t len;
+      while ((len = ring->read(cursor, buffer, sizeof(buffer))) > 0) {
+        std::string text(buffer, len);
+        const int p = text[0] - 'A';
+        ASSERT_TRUE(p >= 0 && p < PRODUCERS) << text;
+        const int i = std::stoi(text.substr(text.find(':') + 1));
+        ASSERT_EQ(i, last_seen[p] + 1) << text;
+        last_seen[p] = i;
+      }
+      if (finished) {
+        break;
+      }
+    }
+  });
+
+  for (auto& producer : producers) {
+    producer.join();
+  }
+  done = true;
+  reader.join();
+
+  EXPECT_EQ(last_seen, std::vector<int>(PRODUCERS, RECORDS - 1));
+}
@@ -0,0 +1,51 @@
+#include <gtest/gtest.h>
+
+#include "../../Software/src/devboard/sdcard/log_segments.h"
+
+static std::vector<uint32_t> numbers(const std::vector<Log_segment>& segments) {
+  std::vector<uint32_t> result;
+  for (const Log_segment& segment : segments) {
+    result.push_back(segment.number);
+  }
+  return result;
+}
+
+TEST(LogSegmentsTests, ShouldRoundTripIndexAndSkipGarbage) {
+  std::vector<Log_segment> segments = {{1, 100, 0}, {2, 4000, 0}, {17, 4294967295u, 0}};
+
+  std::string content = format_index(segments);
+  EXPECT_EQ(content, "1,100\n2,4000\n17,4294967295\n");
+
+  auto parsed = parse_index("garbage\n" + content + "3,\n,5\n4,50");
+  EXPECT_EQ(numbers(parsed), (std::vector<uint32_t>{1, 2, 17, 4}));
+  EXPECT_EQ(parsed[1].start_s, 4000);
+  EXPECT_EQ(parsed[3].start_s, 50);
+}
+
+TEST(LogSegmentsTests, ShouldRotateOnSizeOrAge) {
+  Log_segment segment = {1, 1000, 500};
+
+  EXPECT_FALSE(segment_should_rotate(segment, 1100, 1000, 3600));
+  EXPECT_TRUE(segment_should_rotate(segment, 4600, 1000, 3600));
+  segment.size = 1000;
+  EXPECT_TRUE(segment_should_rotate(segment, 1100, 1000, 3600));
+}
+
+TEST(LogSegmentsTests, ShouldDropOldestSegmentsButNeverTheNewest) {
+  std::vector<Log_segment> segments = {{1, 0, 400}, {2, 10, 400}, {3, 20, 400}};
+
+  EXPECT_EQ(segments_to_drop(segments, 1200), 0);
+  EXPECT_EQ(segments_to_drop(segments, 1000), 1);
+  EXPECT_EQ(segments_to_drop(segments, 500), 2);
+  EXPECT_EQ(segments_to_drop(segments, 0), 2);
+}
+
+TEST(LogSegmentsTests, ShouldSelectSegmentsOverlappingTimeRange) {
+  std::vector<Log_segment> segments = {{1, 0, 0}, {2, 100, 0}, {3, 200, 0}, {4, 300, 0}};
+
+  EXPECT_EQ(numbers(segments_in_range(segments, 150, 250)), (std::vector<uint32_t>{2, 3}));
+  EXPECT_EQ(numbers(segments_in_range(segments, 100, 100)), (std::vector<uint32_t>{2}));
+  EXPECT_EQ(numbers(segments_in_range(segments, 350, 9999)), (std::vector<uint32_t>{4}));
+  EXPECT_EQ(numbers(segments_in_range(segments, 0, 0)), (std::vector<uint32_t>{1}));
+  EXPECT_EQ(numbers(segments_in_range(segments, 0, UINT32_MAX)), (std::vector<uint32_t>{1, 2, 3, 4}));
+}
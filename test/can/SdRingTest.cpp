@@ -0,0 +1,107 @@
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "../../Software/src/devboard/sdcard/can_log_format.h"
+#include "../../Software/src/devboard/sdcard/sd_ring.h"
+
+static void send_record(RingbufHandle_t ring, uint32_t id) {
+  // Mixed record sizes, so the ring wraps at varying places
+  CAN_frame frame = {.FD = id % 3 == 0, .ext_ID = false, .DLC = (uint8_t)(id % 3 == 0 ? 64 : 8), .ID = id};
+  frame.data.u8[0] = (uint8_t)id;
+  uint8_t record[CAN_LOG_RECORD_MAX_SIZE];
+  const size_t size = encode_can_log_record(frame, MSG_RX, CAN_NATIVE, 1000 * id, record);
+  ASSERT_EQ(xRingbufferSend(ring, record, size, 0), pdTRUE);
+}
+
+TEST(SdRingTests, ShouldKeepLogAlignedWhenDroppingRecordsAcrossTheWrap) {
+  RingbufHandle_t ring = xRingbufferCreate(1024, RINGBUF_TYPE_NOSPLIT);
+  ASSERT_NE(ring, nullptr);
+
+  std::vector<uint8_t> log(CAN_LOG_MAGIC, CAN_LOG_MAGIC + sizeof(CAN_LOG_MAGIC));
+  std::vector<uint32_t> kept;
+  const uint8_t* previous = nullptr;
+  int wraps_while_paused = 0;
+
+  uint32_t next_id = 0;
+  for (int i = 0; i < 8; i++) {
+    send_record(ring, next_id++);
+  }
+
+  for (int i = 0; i < 200; i++) {
+    send_record(ring, next_id++);
+
+    // Paused in stretches, like during exports
+    const bool paused = (i / 15) % 2 == 1;
+    ASSERT_TRUE(take_sd_ring_item(ring, 0, [&](const uint8_t* data, size_t size) {
+      if (paused && previous != nullptr && data < previous) {
+        wraps_while_paused++;
+      }
+      previous = data;
+      if (!paused) {
+        CAN_log_record record;
+        ASSERT_EQ(decode_can_log_record(data, size, record), size);
+        kept.push_back(record.ID);
+        log.insert(log.end(), data, data + size);
+      }
+    }));
+  }
+  EXPECT_GT(wraps_while_paused, 0);
+
+  CanLogBlockDecoder decoder;
+  decoder.set_block(log.data(), log.size());
+  std::vector<uint32_t> decoded;
+  CAN_log_record record;
+  while (decoder.next(record)) {
+    EXPECT_EQ(record.timestamp_us, 1000 * record.ID);
+    EXPECT_EQ(record.data[0], (uint8_t)record.ID);
+    decoded.push_back(record.ID);
+  }
+  EXPECT_EQ(decoded, kept);
+
+  vRingbufferDelete(ring);
+}
+
+TEST(SdRingTests, ShouldStartEverySegmentOnARecord) {
+  RingbufHandle_t ring = xRingbufferCreate(512, RINGBUF_TYPE_NOSPLIT);
+  std::vector<std::vector<uint8_t>> segments;
+
+  // The SD writer rotates between items, here after every 100 bytes like SD_LOG_SEGMENT_MAX_BYTES
+  uint32_t next_id = 0;
+  for (int i = 0; i < 60; i++) {
+    send_record(ring, next_id++);
+    if (segments.empty() || segments.back().size() >= 100) {
+      segments.emplace_back(CAN_LOG_MAGIC, CAN_LOG_MAGIC + sizeof(CAN_LOG_MAGIC));
+    }
+    take_sd_ring_item(ring, 0, [&](const uint8_t* data, size_t size) {
+      segments.back().insert(segments.back().end(), data, data + size);
+    });
+  }
+  ASSERT_GT(segments.size(), 2);
+
+  // Each segment decodes alone, as an export starting at it or after the ones before it were deleted
+  uint32_t expected_id = 0;
+  for (const auto& segment : segments) {
+    CanLogBlockDecoder decoder;
+    decoder.set_block(segment.data(), segment.size());
+    CAN_log_record record;
+    while (decoder.next(record)) {
+      EXPECT_EQ(record.ID, expected_id++);
+    }
+    EXPECT_FALSE(decoder.bad_magic());
+  }
+  EXPECT_EQ(expected_id, next_id);
+
+  vRingbufferDelete(ring);
+}
+
+TEST(SdRingTests, ShouldReportEmptyRing) {
+  RingbufHandle_t ring = xRingbufferCreate(256, RINGBUF_TYPE_NOSPLIT);
+  bool called = false;
+
+  EXPECT_FALSE(take_sd_ring_item(ring, 0, [&](const uint8_t*, size_t) { called = true; }));
+  EXPECT_FALSE(called);
+  EXPECT_EQ(xRingbufferGetCurFreeSize(ring), 256);
+
+  vRingbufferDelete(ring);
+}
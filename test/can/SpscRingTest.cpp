@@ -0,0 +1,71 @@
+#include <gtest/gtest.h>
+
+#include <thread>
+
+#include "../../Software/src/devboard/utils/spsc_ring.h"
+#include "../../Software/src/devboard/utils/types.h"
+
+TEST(SpscRingTests, ShouldReturnItemsInOrderAndRejectWhenFull) {
+  SpscRing<int, 4> ring;
+  int item = 0;
+
+  EXPECT_TRUE(ring.empty());
+  EXPECT_FALSE(ring.pop(item));
+
+  for (int i = 1; i <= 4; i++) {
+    EXPECT_TRUE(ring.push(i));
+  }
+  EXPECT_FALSE(ring.push(5));
+  EXPECT_EQ(ring.count(), 4);
+
+  for (int i = 1; i <= 4; i++) {
+    ASSERT_TRUE(ring.pop(item));
+    EXPECT_EQ(item, i);
+  }
+  EXPECT_TRUE(ring.empty());
+}
+
+TEST(SpscRingTests, ShouldKeepWorkingAcrossWrapAround) {
+  SpscRing<int, 2> ring;
+  int item = 0;
+
+  for (int i = 0; i < 1000; i++) {
+    ASSERT_TRUE(ring.push(i));
+    ASSERT_TRUE(ring.pop(item));
+    EXPECT_EQ(item, i);
+  }
+  EXPECT_TRUE(ring.empty());
+}
+
+TEST(SpscRingTests, ShouldHandOverFramesBetweenThreadsWithoutLossOrReordering) {
+  static SpscRing<CAN_frame, 64> ring;
+  const uint32_t frame_count = 200000;
+
+  std::thread producer([&] {
+    for (uint32_t i = 0; i < frame_count;) {
+      CAN_frame frame = {.DLC = 8, .ID = i & 0x7FF};
+      frame.data.u8[0] = i & 0xFF;
+      frame.data.u8[7] = (i >> 8) & 0xFF;
+      if (ring.push(frame)) {
+        i++;
+      } else {
+        std::this_thread::yield();
+      }
+    }
+  });
+
+  CAN_frame frame;
+  for (uint32_t i = 0; i < frame_count;) {
+    if (!ring.pop(frame)) {
+      std::this_thread::yield();
+      continue;
+    }
+    ASSERT_EQ(frame.ID, i & 0x7FF);
+    ASSERT_EQ(frame.data.u8[0], i & 0xFF);
+    ASSERT_EQ(frame.data.u8[7], (i >> 8) & 0xFF);
+    i++;
+  }
+
+  producer.join();
+  EXPECT_TRUE(ring.empty());
+}
@@ -0,0 +1,176 @@
+#include <gtest/gtest.h>
+
+#include <optional>
+#include <string>
+
+#include "../../Software/src/charger/NISSAN-LEAF-CHARGER.h"
+#include "../../Software/src/communication/can/can_replay.h"
+#include "../../Software/src/datalayer/datalayer.h"
+#include "../emul/sim_clock.h"
+#include "../emul/virtual_can.h"
+
+// Runs the LEAF PDM charger in the host build: core_loop on the simulated clock, the PDM on a virtual bus
+class NissanLeafChargerTests : public testing::Test {
+ protected:
+  void SetUp() override {
+    datalayer = DataLayer();
+    sim_clock_set_us(START_US);
+    virtual_can_reset();
+    charger.emplace();
+    init_CAN();
+  }
+
+  void TearDown() override {
+    virtual_can_reset();
+    charger.reset();
+  }
+
+  std::vector<Virtual_CAN_frame> sent(uint32_t id) {
+    std::vector<Virtual_CAN_frame> frames;
+    for (auto& entry : virtual_can_sent()) {
+      if (entry.frame.ID == id) {
+        frames.push_back(entry);
+      }
+    }
+    return frames;
+  }
+
+  static CAN_frame pdm_status(uint8_t charge_status, uint8_t ac_voltage, uint16_t power) {
+    CAN_frame frame = {.FD = false, .ext_ID = false, .DLC = 8, .ID = 0x390, .data = {}};
+    frame.data.u8[0] = (power >> 8) & 0x01;
+    frame.data.u8[1] = power & 0xFF;
+    frame.data.u8[3] = ac_voltage << 3;
+    frame.data.u8[5] = charge_status << 1;
+    return frame;
+  }
+
+  static constexpr int64_t START_US = 1000000;
+  std::optional<NissanLeafCharger> charger;
+};
+
+TEST_F(NissanLeafChargerTests, ShouldSendItsCyclicMessagesOnTime) {
+  run_core_loop_until(START_US + 10000000);
+
+  const auto frames_1f2 = sent(0x1F2);
+  ASSERT_GE(frames_1f2.size(), 999u);
+  EXPECT_LE(frames_1f2.size(), 1001u);
+  for (size_t i = 1; i < frames_1f2.size(); i++) {
+    EXPECT_EQ(frames_1f2[i].time_us - frames_1f2[i - 1].time_us, 10000);
+  }
+  EXPECT_GE(sent(0x55B).size(), 99u);
+
+  // The simulated clock has no jitter, so neither has the TX timing monitor
+  const auto& timing = datalayer.system.status.can_tx_timing[0];
+  EXPECT_EQ(timing.ID, 0x1F2u);
+  EXPECT_EQ(timing.intervals, frames_1f2.size() - 1);
+  EXPECT_EQ(timing.max_us, 10000u);
+  EXPECT_EQ(timing.late, 0u);
+  EXPECT_EQ(timing.missed, 0u);
+}
+
+TEST_F(NissanLeafChargerTests, ShouldRequestPowerOncePluggedIn) {
+  run_core_loop_until(START_US + 1000000);
+  EXPECT_EQ(sent(0x1F2).back().frame.data.u8[1], 0x64);
+
+  CAN_frame plugged_in = {.FD = false, .ext_ID = false, .DLC = 8, .ID = 0x679, .data = {}};
+  virtual_can_receive(plugged_in, CAN_NATIVE, START_US + 1000500);
+  // Charging at 230 V AC, 3.2 kW
+  virtual_can_receive(pdm_status(4, 2, 32), CAN_NATIVE, START_US + 1005000);
+  run_core_loop_until(START_US + 2000000);
+
+  EXPECT_TRUE(datalayer.charger.charger_HV_enabled);
+  EXPECT_EQ(datalayer.charger.charger_stat_ACvol, 230);
+  EXPECT_EQ(datalayer.charger.charger_stat_HVcur, 32);
+  // 16 A requested on plug in, clamped to the 15 A the PDM is known to take
+  EXPECT_EQ(sent(0x1F2).back().frame.data.u8[1], 0xA0);
+}
+
+TEST_F(NissanLeafChargerTests, ShouldFollowAReplayedLogWithoutTransmitting) {
+  // Ten minutes of a PDM charging at a slowly rising power, one status frame a second
+  std::string log = "(0.000000) RX0 679 [8] 00 00 00 00 00 00 00 00\n";
+  for (int s = 1; s <= 600; s++) {
+    char line[80];
+    snprintf(line, sizeof(line), "(%d.000000) RX0 390 [8] 00 %02X 00 10 00 08 00 00\n", s, s / 4);
+    log += line;
+  }
+  // The charger runs for a moment before the replay takes over
+  run_core_loop_until(START_US + 100000);
+  const auto& timing = datalayer.system.status.can_tx_timing[0];
+  const uint32_t intervals_before = timing.intervals;
+  virtual_can_clear_sent();
+
+  ASSERT_TRUE(begin_can_replay_upload());
+  add_can_replay_upload_data(reinterpret_cast<const uint8_t*>(log.data()), log.size());
+  ASSERT_TRUE(end_can_replay_upload());
+  ASSERT_EQ(can_replay_frames(), 601u);
+
+  // start_can_replay() without its task: the replay waits by running core_loop until each frame is due
+  CAN_replay_options options = {};
+  options.speed_percent = 100;
+  options.target = REPLAY_TO_RECEIVERS;
+  options.suppress_tx = true;
+  ASSERT_TRUE(begin_can_replay(options));
+  UploadReplaySource source;
+  run_can_replay(source, run_core_loop_until);
+  const int64_t last_us = sim_clock_now_us();
+  run_core_loop_until(last_us + 10000);
+
+  EXPECT_EQ(last_us, START_US + 100000 + 600000000);
+  EXPECT_EQ(can_replay_timing().frames, 601u);
+  EXPECT_EQ(datalayer.charger.charger_stat_HVcur, 150);
+  EXPECT_EQ(datalayer.charger.charger_stat_ACvol, 230);
+  EXPECT_TRUE(virtual_can_sent().empty());
+  // Frames held back are not timed
+  EXPECT_EQ(timing.intervals, intervals_before);
+
+  // The charger is heard again once the replay is over, on its schedule, with the silence not counted as missed
+  end_can_replay();
+  run_core_loop_until(last_us + 100000);
+  EXPECT_GE(sent(0x1F2).size(), 9u);
+  EXPECT_GE(timing.intervals, intervals_before + 8);
+  EXPECT_EQ(timing.max_us, 10000u);
+  EXPECT_EQ(timing.missed, 0u);
+}
+
+TEST_F(NissanLeafChargerTests, ShouldKeepEveryFrameOfAnUploadOfShortLines) {
+  // Each line is shorter than the record it becomes
+  std::string log;
+  for (int i = 0; i < 1000; i++) {
+    log += "(0.000000) RX0 1F2 [0]\n";
+  }
+
+  ASSERT_TRUE(begin_can_replay_upload());
+  add_can_replay_upload_data(reinterpret_cast<const uint8_t*>(log.data()), log.size());
+  ASSERT_TRUE(end_can_replay_upload());
+  EXPECT_EQ(can_replay_frames(), 1000u);
+  EXPECT_EQ(can_replay_frames_dropped(), 0u);
+}
+
+TEST_F(NissanLeafChargerTests, ShouldStartAReplayAfterAnAbortedUpload) {
+  const std::string half = "(0.000000) RX0 679 [8] 00 00 00 00 00 00 00 00\n(1.000000) RX0 390";
+
+  ASSERT_TRUE(begin_can_replay_upload());
+  add_can_replay_upload_data(reinterpret_cast<const uint8_t*>(half.data()), half.size());
+  abort_can_replay_upload();
+  EXPECT_EQ(can_replay_frames(), 0u);
+
+  CAN_replay_options options = {};
+  options.speed_percent = 100;
+  options.target = REPLAY_TO_RECEIVERS;
+  EXPECT_TRUE(begin_can_replay(options));
+  end_can_replay();
+}
+
+TEST_F(NissanLeafChargerTests, ShouldTurnAwayASecondUploadWhileOneIsInProgress) {
+  const std::string first = "(0.000000) RX0 679 [8] 00 00 00 00 00 00 00 00\n";
+
+  ASSERT_TRUE(begin_can_replay_upload());
+  add_can_replay_upload_data(reinterpret_cast<const uint8_t*>(first.data()), first.size());
+  EXPECT_FALSE(begin_can_replay_upload());
+
+  add_can_replay_upload_data(reinterpret_cast<const uint8_t*>(first.data()), first.size());
+  ASSERT_TRUE(end_can_replay_upload());
+  EXPECT_EQ(can_replay_frames(), 2u);
+  EXPECT_TRUE(begin_can_replay_upload());
+  abort_can_replay_upload();
+}
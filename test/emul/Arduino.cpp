@@ -1,6 +1,7 @@
 #include "Arduino.h"
 
 #include "../../Software/src/communication/can/comm_can.h"
+#include "sim_clock.h"
 
 // Provide the definition that was previously in USER_SETTINGS.cpp
 volatile CAN_Configuration can_config = {.battery = CAN_Interface::CAN_NATIVE,
@@ -9,16 +10,18 @@ volatile CAN_Configuration can_config = {.battery = CAN_Interface::CAN_NATIVE,
                                          .charger = CAN_Interface::CAN_NATIVE,
                                          .shunt = CAN_Interface::CAN_NATIVE};
 
-void delay(unsigned long ms) {}
-void delayMicroseconds(unsigned long us) {}
+// Busy waits pass on the simulated clock
+void delay(unsigned long ms) {
+  sim_clock_advance_us((int64_t)ms * 1000);
+}
+void delayMicroseconds(unsigned long us) {
+  sim_clock_advance_us(us);
+}
 int digitalRead(uint8_t pin) {
   return 0;
 }
 void digitalWrite(uint8_t pin, uint8_t val) {}
 
-unsigned long micros() {
-  return 0;
-}
 void pinMode(uint8_t pin, uint8_t mode) {}
 
 int max(int a, int b) {
@@ -1,4 +1,4 @@
-#include "../../src/devboard/utils/logging.h"
+#include "../../Software/src/devboard/utils/logging.h"
 
 // This creates the global instance that links against the real implementation
 Logging logging;
@@ -1,9 +1,116 @@
-#include "../../Software/src/communication/Transmitter.h"
-#include "../../Software/src/communication/can/comm_can.h"
+#include "virtual_can.h"
 
-void transmit_can_frame_to_interface(const CAN_frame* tx_frame, CAN_Interface interface) {}
+#include <algorithm>
+#include <climits>
+#include <map>
 
-void register_can_receiver(CanReceiver* receiver, CAN_Interface interface, CAN_Speed speed) {}
+#include "../../Software/src/communication/can/can_registry.h"
+#include "../../Software/src/communication/core_tick.h"
+#include "../../Software/src/datalayer/datalayer.h"
+#include "Arduino.h"
+#include "sim_clock.h"
+
+// Stands in for the drivers of comm_can.cpp. Receivers, dispatching and TX timing are the board's own code, from
+// can_registry.cpp.
+
+// Frames on the virtual buses that core_loop has not handled yet, by the time they arrive
+static std::multimap<int64_t, Virtual_CAN_frame> can_rx_pending;
+static std::vector<Virtual_CAN_frame> can_sent;
+static bool can_tx_suppressed = false;
+static int64_t next_core_tick_us = 0;
+
+bool init_CAN() {
+  build_can_dispatchers();
+  return true;
+}
+
+void transmit_can_frames(std::span<const CAN_frame> frames, CAN_Interface interface) {
+  if (can_tx_suppressed) {
+    return;
+  }
+  // A single task sends everything on the host, the replay too
+  for (const CAN_frame& frame : frames) {
+    can_sent.push_back({frame, interface, sim_clock_now_us()});
+    record_can_tx_timing(frame, interface, sim_clock_now_us());
+  }
+}
+
+void transmit_can_frame_to_interface(const CAN_frame* tx_frame, CAN_Interface interface) {
+  transmit_can_frames(std::span<const CAN_frame>(tx_frame, 1), interface);
+}
+
+// The virtual buses take every frame right away, nothing is ever queued for a retry
+void retry_can_tx_queues() {}
+
+bool inject_can_frame(const CAN_frame& frame, CAN_Interface interface) {
+  virtual_can_receive(frame, interface, sim_clock_now_us());
+  return true;
+}
+
+void set_can_tx_suppressed(bool suppressed) {
+  if (can_tx_suppressed && !suppressed) {
+    restart_can_tx_timing();
+  }
+  can_tx_suppressed = suppressed;
+}
+
+void set_can_rx_consumer(TaskHandle_t task) {}
+
+bool receive_can() {
+  const int64_t now_us = sim_clock_now_us();
+  while (!can_rx_pending.empty() && can_rx_pending.begin()->first <= now_us) {
+    Virtual_CAN_frame entry = can_rx_pending.begin()->second;
+    can_rx_pending.erase(can_rx_pending.begin());
+    entry.frame.timestamp_us = entry.time_us;
+    dispatch_can_frame(entry.frame, entry.interface);
+  }
+  // No receive budget on the host, every frame that arrived by now was handled
+  return false;
+}
+
+void virtual_can_receive(const CAN_frame& frame, CAN_Interface interface, int64_t at_us) {
+  can_rx_pending.insert({at_us, {frame, interface, at_us}});
+}
+
+const std::vector<Virtual_CAN_frame>& virtual_can_sent() {
+  return can_sent;
+}
+
+void virtual_can_clear_sent() {
+  can_sent.clear();
+}
+
+void virtual_can_reset() {
+  clear_can_receivers();
+  can_rx_pending.clear();
+  can_sent.clear();
+  can_tx_suppressed = false;
+  datalayer.system.status.can_tx_timing_count = 0;
+  clear_cyclic_tasks();
+  next_core_tick_us = sim_clock_now_us();
+}
+
+void run_core_loop_until(int64_t end_us) {
+  while (true) {
+    const int64_t next_rx_us = can_rx_pending.empty() ? LLONG_MAX : can_rx_pending.begin()->first;
+    const int64_t next_us = std::max(std::min(next_core_tick_us, next_rx_us), sim_clock_now_us());
+    if (next_us > end_us) {
+      sim_clock_set_us(std::max(end_us, sim_clock_now_us()));
+      return;
+    }
+    sim_clock_set_us(next_us);
+
+    receive_can();
+    if (next_us >= next_core_tick_us) {
+      next_core_tick_us += 1000;
+      run_core_tick(millis());
+    }
+  }
+}
+
+int64_t can_frame_log_time_us(const CAN_frame& frame) {
+  return frame.timestamp_us != 0 ? frame.timestamp_us : sim_clock_now_us();
+}
 
 bool change_can_speed(CAN_Interface interface, CAN_Speed speed) {
   return true;
@@ -17,6 +124,4 @@ char const* getCANInterfaceName(CAN_Interface) {
   return "Foobar";
 }
 
-void register_transmitter(Transmitter* transmitter) {}
-
-void dump_can_frame(CAN_frame& frame, CAN_Interface interface, frameDirection msgDir) {}
+void dump_can_frame(const CAN_frame& frame, CAN_Interface interface, frameDirection msgDir) {}
@@ -0,0 +1,19 @@
+#ifndef ESP_HEAP_CAPS_H
+#define ESP_HEAP_CAPS_H
+
+#include <stdint.h>
+#include <stdlib.h>
+
+// The host has a single heap, every capability is served from it
+#define MALLOC_CAP_8BIT (1 << 2)
+#define MALLOC_CAP_SPIRAM (1 << 10)
+
+inline void* heap_caps_malloc(size_t size, uint32_t caps) {
+  return malloc(size);
+}
+
+inline void heap_caps_free(void* ptr) {
+  free(ptr);
+}
+
+#endif
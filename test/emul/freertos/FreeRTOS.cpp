@@ -1,4 +1,12 @@
 #include "FreeRTOS.h"
+#include "queue.h"
+#include "ringbuf.h"
+
+#include "../sim_clock.h"
+
+#include <cstring>
+#include <deque>
+#include <vector>
 
 extern "C" {
 BaseType_t xTaskCreatePinnedToCore(TaskFunction_t pxTaskCode, const char* const pcName, const uint32_t ulStackDepth,
@@ -7,4 +15,131 @@ BaseType_t xTaskCreatePinnedToCore(TaskFunction_t pxTaskCode, const char* const
   return 0;
 }
 void vTaskDelete(TaskHandle_t xTaskToDelete) {}
+void vTaskDelay(const TickType_t xTicksToDelay) {
+  sim_clock_advance_us((int64_t)xTicksToDelay * 1000);
+}
+}
+
+struct QueueDefinition {
+  UBaseType_t length;
+  UBaseType_t item_size;
+  std::deque<std::vector<uint8_t>> items;
+};
+
+QueueHandle_t xQueueCreate(UBaseType_t uxQueueLength, UBaseType_t uxItemSize) {
+  return new QueueDefinition{uxQueueLength, uxItemSize, {}};
+}
+
+BaseType_t xQueueSend(QueueHandle_t xQueue, const void* pvItemToQueue, TickType_t xTicksToWait) {
+  if (xQueue->items.size() >= xQueue->length) {
+    return pdFALSE;
+  }
+  const uint8_t* item = (const uint8_t*)pvItemToQueue;
+  xQueue->items.emplace_back(item, item + xQueue->item_size);
+  return pdTRUE;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t xQueue, void* pvBuffer, TickType_t xTicksToWait) {
+  if (xQueue->items.empty()) {
+    return pdFALSE;
+  }
+  memcpy(pvBuffer, xQueue->items.front().data(), xQueue->item_size);
+  xQueue->items.pop_front();
+  return pdTRUE;
+}
+
+BaseType_t xQueueReset(QueueHandle_t xQueue) {
+  xQueue->items.clear();
+  return pdTRUE;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t xQueue) {
+  return xQueue->items.size();
+}
+
+void vQueueDelete(QueueHandle_t xQueue) {
+  delete xQueue;
+}
+
+static const size_t RINGBUF_ITEM_HEADER_SIZE = 8;
+
+struct RingbufferDefinition {
+  struct Item {
+    size_t offset;
+    size_t size;
+    // Bytes the item keeps from being reused, its header, padding and the end of the ring skipped after it
+    size_t footprint;
+  };
+  std::vector<uint8_t> storage;
+  std::deque<Item> items;
+  size_t write = 0;
+  size_t used = 0;
+  // Items handed out by xRingbufferReceive() and not returned yet, always the oldest ones
+  size_t received = 0;
+};
+
+RingbufHandle_t xRingbufferCreate(size_t xBufferSize, RingbufferType_t xBufferType) {
+  if (xBufferType != RINGBUF_TYPE_NOSPLIT) {
+    return NULL;
+  }
+  auto ring = new RingbufferDefinition();
+  ring->storage.resize(xBufferSize & ~(size_t)3);
+  return ring;
+}
+
+BaseType_t xRingbufferSend(RingbufHandle_t xRingbuffer, const void* pvItem, size_t xItemSize,
+                           TickType_t xTicksToWait) {
+  auto ring = (RingbufferDefinition*)xRingbuffer;
+  const size_t capacity = ring->storage.size();
+  const size_t footprint = RINGBUF_ITEM_HEADER_SIZE + ((xItemSize + 3) & ~(size_t)3);
+  if (xItemSize > capacity / 2 - RINGBUF_ITEM_HEADER_SIZE) {
+    return pdFALSE;
+  }
+
+  size_t skipped = 0;
+  if (ring->write + footprint > capacity) {
+    skipped = capacity - ring->write;
+  }
+  if (ring->used + skipped + footprint > capacity) {
+    return pdFALSE;
+  }
+  if (skipped > 0) {
+    if (!ring->items.empty()) {
+      ring->items.back().footprint += skipped;
+      ring->used += skipped;
+    }
+    ring->write = 0;
+  }
+
+  memcpy(ring->storage.data() + ring->write + RINGBUF_ITEM_HEADER_SIZE, pvItem, xItemSize);
+  ring->items.push_back({ring->write + RINGBUF_ITEM_HEADER_SIZE, xItemSize, footprint});
+  ring->write = (ring->write + footprint) % capacity;
+  ring->used += footprint;
+  return pdTRUE;
+}
+
+void* xRingbufferReceive(RingbufHandle_t xRingbuffer, size_t* pxItemSize, TickType_t xTicksToWait) {
+  auto ring = (RingbufferDefinition*)xRingbuffer;
+  if (ring->received >= ring->items.size()) {
+    return NULL;
+  }
+  const RingbufferDefinition::Item& item = ring->items[ring->received++];
+  *pxItemSize = item.size;
+  return ring->storage.data() + item.offset;
+}
+
+void vRingbufferReturnItem(RingbufHandle_t xRingbuffer, void* pvItem) {
+  auto ring = (RingbufferDefinition*)xRingbuffer;
+  ring->used -= ring->items.front().footprint;
+  ring->items.pop_front();
+  ring->received--;
+}
+
+size_t xRingbufferGetCurFreeSize(RingbufHandle_t xRingbuffer) {
+  auto ring = (RingbufferDefinition*)xRingbuffer;
+  return ring->storage.size() - ring->used;
+}
+
+void vRingbufferDelete(RingbufHandle_t xRingbuffer) {
+  delete (RingbufferDefinition*)xRingbuffer;
 }
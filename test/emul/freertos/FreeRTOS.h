@@ -7,6 +7,12 @@
 
 typedef int BaseType_t;
 typedef unsigned int UBaseType_t;
+typedef uint32_t TickType_t;
+
+#define pdFALSE ((BaseType_t)0)
+#define pdTRUE ((BaseType_t)1)
+#define portMAX_DELAY ((TickType_t)0xffffffffUL)
+#define pdMS_TO_TICKS(ms) ((TickType_t)(ms))
 
 const BaseType_t tskNO_AFFINITY = -1;
 
@@ -16,6 +22,9 @@ BaseType_t xTaskCreatePinnedToCore(TaskFunction_t pxTaskCode, const char* const
                                    const BaseType_t xCoreID);
 
 void vTaskDelete(TaskHandle_t xTaskToDelete);
+
+// Passes on the simulated clock, one tick per millisecond
+void vTaskDelay(const TickType_t xTicksToDelay);
 }
 
 #endif
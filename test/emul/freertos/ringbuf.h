@@ -0,0 +1,28 @@
+#ifndef _RINGBUF_H_
+#define _RINGBUF_H_
+
+#include "FreeRTOS.h"
+
+#include <stddef.h>
+
+// Ring buffers for the host tests, which run single threaded: a send to a full ring or a receive from an empty one
+// fails right away instead of waiting. Only RINGBUF_TYPE_NOSPLIT is there. Items are laid out like ESP-IDF does:
+// an 8 byte header and the data rounded up to 4 bytes, wrapping to the start when the rest of the ring is too short.
+typedef void* RingbufHandle_t;
+
+typedef enum {
+  RINGBUF_TYPE_NOSPLIT = 0,
+  RINGBUF_TYPE_ALLOWSPLIT,
+  RINGBUF_TYPE_BYTEBUF,
+} RingbufferType_t;
+
+// NULL for the types the host does not have
+RingbufHandle_t xRingbufferCreate(size_t xBufferSize, RingbufferType_t xBufferType);
+BaseType_t xRingbufferSend(RingbufHandle_t xRingbuffer, const void* pvItem, size_t xItemSize,
+                           TickType_t xTicksToWait);
+void* xRingbufferReceive(RingbufHandle_t xRingbuffer, size_t* pxItemSize, TickType_t xTicksToWait);
+void vRingbufferReturnItem(RingbufHandle_t xRingbuffer, void* pvItem);
+size_t xRingbufferGetCurFreeSize(RingbufHandle_t xRingbuffer);
+void vRingbufferDelete(RingbufHandle_t xRingbuffer);
+
+#endif
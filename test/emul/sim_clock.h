@@ -0,0 +1,12 @@
+#ifndef SIM_CLOCK_H
+#define SIM_CLOCK_H
+
+#include <stdint.h>
+
+// Simulated time behind millis(), micros(), millis64() and esp_timer_get_time() in the host build. It starts at 0
+// and only moves when a test moves it, so hours of firmware time run as fast as the host can execute them.
+int64_t sim_clock_now_us();
+void sim_clock_set_us(int64_t now_us);
+void sim_clock_advance_us(int64_t delta_us);
+
+#endif
@@ -1,13 +1,34 @@
 #include <stdint.h>
 
+#include "esp_timer.h"
+#include "sim_clock.h"
+
+static int64_t sim_now_us = 0;
+
+int64_t sim_clock_now_us() {
+  return sim_now_us;
+}
+
+void sim_clock_set_us(int64_t now_us) {
+  sim_now_us = now_us;
+}
+
+void sim_clock_advance_us(int64_t delta_us) {
+  sim_now_us += delta_us;
+}
+
+int64_t esp_timer_get_time() {
+  return sim_now_us;
+}
+
 unsigned long millis() {
-  return 0;
+  return (unsigned long)(sim_now_us / 1000);
 }
 
-uint64_t get_timestamp(unsigned long millis) {
-  return 0;
+unsigned long micros() {
+  return (unsigned long)sim_now_us;
 }
 
 uint64_t millis64(void) {
-  return 0;
+  return sim_now_us / 1000;
 }
@@ -0,0 +1,36 @@
+#ifndef VIRTUAL_CAN_H
+#define VIRTUAL_CAN_H
+
+#include <vector>
+
+#include "../../Software/src/communication/can/comm_can.h"
+
+// The host build replaces the CAN drivers with a virtual bus per interface. Frames a test puts on a bus reach the
+// receivers registered for that interface through the same CanDispatcher lookup as on the board, frames the
+// firmware transmits are kept with the simulated time they were sent at.
+
+// A frame on a virtual bus, at the simulated time it was sent or received
+typedef struct {
+  CAN_frame frame;
+  CAN_Interface interface;
+  int64_t time_us;
+} Virtual_CAN_frame;
+
+// Puts a frame on the bus of the interface at at_us. It is handed to the receivers by the first receive_can() at
+// or after that time, with at_us as its receive timestamp.
+void virtual_can_receive(const CAN_frame& frame, CAN_Interface interface, int64_t at_us);
+
+// Frames transmitted by the firmware, oldest first. Frames held back by set_can_tx_suppressed() are not included.
+const std::vector<Virtual_CAN_frame>& virtual_can_sent();
+void virtual_can_clear_sent();
+
+// Forgets the receivers, queued and sent frames, TX timing monitors and cyclic tasks, so a test can set up a new
+// charger. The next core_loop tick is due at the current simulated time.
+void virtual_can_reset();
+
+// Runs core_loop from the current simulated time to end_us as fast as the host can: receive_can() and a core tick
+// every simulated millisecond, and receive_can() as soon as a frame reaches a bus in between, the way the CAN RX
+// task wakes core_loop on the board.
+void run_core_loop_until(int64_t end_us);
+
+#endif
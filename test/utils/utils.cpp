@@ -1,5 +1,6 @@
 #include "utils.h"
 
+#include <cmath>
 #include <fstream>
 
 namespace fs = std::filesystem;
@@ -56,9 +57,10 @@ CAN_frame parse_can_log_line(const std::string& logLine) {
   double timestamp;
   std::string interfaceName;
 
-  // timestamp and interface name are parsed but not used
+  // interface name is parsed but not used
   ss >> dummy >> timestamp >> dummy;
   ss >> interfaceName;
+  frame.timestamp_us = std::llround(timestamp * 1000000);
 
   // parse hexadecimal CAN ID
   ss >> std::hex >> frame.ID;
@@ -0,0 +1,122 @@
+// Converts binary CAN logs written to the SD card (canlog.bin) into text.
+//
+// Usage: canlog_convert [--emulator | --candump | --savvycan] <canlog.bin> [output]
+//
+//   --emulator  "(seconds) RX0 ID [DLC] data" lines, as shown by the web CAN logger and accepted by CAN replay (default)
+//   --candump   candump -l log format, interface N is written as canN
+//   --savvycan  SavvyCAN / GVRET CSV
+//
+// Build it with the unit tests: cmake -S test -B build && cmake --build build --target canlog_convert
+
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "../Software/src/devboard/sdcard/can_log_format.h"
+
+enum class OutputFormat { Emulator, Candump, SavvyCAN };
+
+static void print_data(FILE* out, const CAN_log_record& record, const char* separator) {
+  for (uint8_t i = 0; i < record.DLC && i < sizeof(record.data); i++) {
+    fprintf(out, "%s%02X", i == 0 ? "" : separator, record.data[i]);
+  }
+}
+
+static void print_record(FILE* out, const CAN_log_record& record, OutputFormat format) {
+  const unsigned long seconds = record.timestamp_us / 1000000;
+  const unsigned long micros = record.timestamp_us % 1000000;
+  const bool tx = record.flags & CAN_LOG_FLAG_TX;
+
+  switch (format) {
+    case OutputFormat::Emulator: {
+      char line[CAN_LOG_LINE_MAX_SIZE];
+      fwrite(line, 1, format_can_log_line(record, line, sizeof(line)), out);
+      break;
+    }
+    case OutputFormat::Candump:
+      fprintf(out, "(%lu.%06lu) can%u ", seconds, micros, record.interface);
+      fprintf(out, (record.flags & CAN_LOG_FLAG_EXT) ? "%08" PRIX32 : "%03" PRIX32, record.ID);
+      fprintf(out, (record.flags & CAN_LOG_FLAG_FD) ? "##0" : "#");
+      print_data(out, record, "");
+      fprintf(out, "\n");
+      break;
+    case OutputFormat::SavvyCAN:
+      fprintf(out, "%" PRId64 ",%08" PRIX32 ",%s,%s,%u,%u,", record.timestamp_us, record.ID,
+              (record.flags & CAN_LOG_FLAG_EXT) ? "true" : "false", tx ? "Tx" : "Rx", record.interface, record.DLC);
+      print_data(out, record, ",");
+      fprintf(out, "\n");
+      break;
+  }
+}
+
+int main(int argc, char** argv) {
+  OutputFormat format = OutputFormat::Emulator;
+  int arg = 1;
+  if (arg < argc && argv[arg][0] == '-') {
+    if (strcmp(argv[arg], "--emulator") == 0) {
+      format = OutputFormat::Emulator;
+    } else if (strcmp(argv[arg], "--candump") == 0) {
+      format = OutputFormat::Candump;
+    } else if (strcmp(argv[arg], "--savvycan") == 0) {
+      format = OutputFormat::SavvyCAN;
+    } else {
+      fprintf(stderr, "Unknown option %s\n", argv[arg]);
+      return 1;
+    }
+    arg++;
+  }
+  if (arg >= argc) {
+    fprintf(stderr, "Usage: %s [--emulator | --candump | --savvycan] <canlog.bin> [output]\n", argv[0]);
+    return 1;
+  }
+
+  FILE* in = fopen(argv[arg], "rb");
+  if (in == nullptr) {
+    perror(argv[arg]);
+    return 1;
+  }
+  FILE* out = (arg + 1 < argc) ? fopen(argv[arg + 1], "w") : stdout;
+  if (out == nullptr) {
+    perror(argv[arg + 1]);
+    return 1;
+  }
+
+  char magic[sizeof(CAN_LOG_MAGIC)];
+  if (fread(magic, 1, sizeof(magic), in) != sizeof(magic) || memcmp(magic, CAN_LOG_MAGIC, sizeof(magic)) != 0) {
+    fprintf(stderr, "%s is not a binary CAN log\n", argv[arg]);
+    return 1;
+  }
+
+  if (format == OutputFormat::SavvyCAN) {
+    fprintf(out, "Time Stamp,ID,Extended,Dir,Bus,LEN,D1,D2,D3,D4,D5,D6,D7,D8\n");
+  }
+
+  std::vector<uint8_t> buffer;
+  uint8_t chunk[4096];
+  size_t records = 0;
+  size_t read;
+  while ((read = fread(chunk, 1, sizeof(chunk), in)) > 0) {
+    buffer.insert(buffer.end(), chunk, chunk + read);
+    size_t offset = 0;
+    CAN_log_record record;
+    size_t used;
+    while ((used = decode_can_log_record(buffer.data() + offset, buffer.size() - offset, record)) > 0) {
+      print_record(out, record, format);
+      offset += used;
+      records++;
+    }
+    buffer.erase(buffer.begin(), buffer.begin() + offset);
+  }
+
+  if (!buffer.empty()) {
+    fprintf(stderr, "Ignored %zu bytes of a truncated record at the end\n", buffer.size());
+  }
+  fprintf(stderr, "Converted %zu frames\n", records);
+
+  fclose(in);
+  if (out != stdout) {
+    fclose(out);
+  }
+  return 0;
+}